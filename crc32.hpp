@@ -91,12 +91,14 @@ static unsigned int crc32_tab[] = {
 
 #include "flstring.hpp"
 
-template<size_t strlen>
-unsigned int calculateCRC32( const fl::string<strlen>& str ) {
+template<size_t strlen, typename... policies>
+unsigned int calculateCRC32( const fl::string<strlen, policies...>& str ) {
     const unsigned char *p = reinterpret_cast<const unsigned char*>( str.data() );
 
+    // only the characters, so that the same text hashes the same whatever
+    // its padding policy (and as it does through the string_view overload)
     unsigned int crc = 0;
-    size_t size = strlen-1;
+    size_t size = str.length();
     while( size-- ) {
         crc = crc32_tab[( crc ^ *p++ ) & 0xFF] ^ ( crc >> 8 );
     }
@@ -104,12 +106,11 @@ unsigned int calculateCRC32( const fl::string<strlen>& str ) {
     return crc ^ ~0U;
 }
 #if 1
-template<size_t strlen>
-unsigned int calculateCRC32( const std::string& str ) {
+inline unsigned int calculateCRC32( std::string_view str ) {
     const unsigned char *p = reinterpret_cast<const unsigned char*>( str.data() );
 
     unsigned int crc = 0;
-    size_t size = strlen-1;
+    size_t size = str.length();
     while( size-- ) {
         crc = crc32_tab[( crc ^ *p++ ) & 0xFF] ^ ( crc >> 8 );
     }
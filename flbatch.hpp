@@ -0,0 +1,304 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flbatch.hpp
+    Author  :   Jamie Taylor
+    Desc    :   Batch selections over many strings at once: which of a
+                contiguous array of fl::string<N> (or the rows of an
+                fl::string_column<N>) equal, start with, or contain a
+                pattern. The result is a selection bitmap, one bit per
+                string, which selection_to_indices() turns into a list of
+                indices.
+                - Arrays of fl::string<4/8/16/32> are matched several
+                  strings per compare: the pattern (plus its capacity
+                  byte, for equality) and a mask are laid out as a whole
+                  string, so each test is a fixed-width masked compare.
+                - Columns first filter on the separate length array, 16
+                  or 32 lengths per compare, and only then read the
+                  characters of the candidate rows (as masked words).
+                - Searches (contains) test strings and rows of up to 32
+                  bytes as a single block; longer ones use fl::string's
+                  SIMD find().
+
+===============================================================================
+*/
+#ifndef FLBATCH_HPP
+#define FLBATCH_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "flcolumn.hpp"
+#include "flsimd.hpp"
+#include "flstring.hpp"
+
+namespace fl {
+
+// Selections hold a bit per string, in 64-bit words: string i is selected if
+// bit ( i % 64 ) of word ( i / 64 ) is set. Unused bits of the last word are
+// left clear.
+constexpr std::size_t selection_words( std::size_t count ) {
+    return ( count + 63 ) / 64;
+}
+
+// Writes the indices of the selected strings (in order) and returns how many.
+inline std::size_t selection_to_indices( const std::uint64_t* selection, std::size_t count, std::uint32_t* indices ) {
+    std::size_t selected = 0;
+    for( std::size_t word=0; word<selection_words( count ); ++word ) {
+        for( std::uint64_t bits = selection[word]; bits != 0; bits &= bits - 1 ) {
+            indices[selected++] = static_cast<std::uint32_t>( word*64 + std::countr_zero( bits ) );
+        }
+    }
+    return selected;
+}
+
+namespace detail {
+
+// Runs match( first, count ) over each (up to) 64 strings, storing the bits it
+// returns; returns the total selected.
+template<typename matcher>
+inline std::size_t select_words( std::size_t count, std::uint64_t* selection, matcher match ) {
+    std::size_t selected = 0;
+    for( std::size_t word=0; word<selection_words( count ); ++word ) {
+        const std::size_t first = word*64;
+        selection[word] = match( first, std::min<std::size_t>( 64, count - first ) );
+        selected += static_cast<std::size_t>( std::popcount( selection[word] ) );
+    }
+    return selected;
+}
+
+// One bit per string, from a predicate on each
+template<typename predicate>
+inline std::uint64_t match_each( std::size_t first, std::size_t count, predicate match ) {
+    std::uint64_t bits = 0;
+    for( std::size_t i=0; i<count; ++i ) {
+        bits |= static_cast<std::uint64_t>( match( first + i ) ) << i;
+    }
+    return bits;
+}
+
+// Whole fl::strings are matched as masked fixed-width blocks when they're a
+// size simd::match_blocks() compares several (or one) to a register.
+template<std::size_t string_size>
+inline constexpr bool batch_in_register = ( string_size == 4 ) || ( string_size == 8 ) ||
+                                          ( string_size == 16 ) || ( string_size == 32 );
+
+template<std::size_t string_size>
+struct block_pattern {
+    char                        pattern[string_size] = {};
+    char                        mask[string_size] = {};
+};
+
+// Equal: the characters, and the capacity byte (which gives the length); the
+// bytes in between are ignored, so either padding policy matches.
+template<std::size_t string_size>
+inline block_pattern<string_size> equal_pattern( std::string_view sv ) {
+    block_pattern<string_size> block;
+    std::memcpy( block.pattern, sv.data(), sv.length() );
+    std::memset( block.mask, 0xFF, sv.length() );
+    block.pattern[string_size-1] = static_cast<char>( string_size-1 - sv.length() );
+    block.mask[string_size-1] = static_cast<char>( 0xFF );
+    return block;
+}
+// Starts with: just the characters. A shorter string fails at its terminator,
+// so the pattern mustn't hold any nulls itself.
+template<std::size_t string_size>
+inline block_pattern<string_size> prefix_pattern( std::string_view sv ) {
+    block_pattern<string_size> block;
+    std::memcpy( block.pattern, sv.data(), sv.length() );
+    std::memset( block.mask, 0xFF, sv.length() );
+    return block;
+}
+
+template<std::size_t string_size, typename... policies>
+inline std::size_t select_blocks( const string<string_size, policies...>* strings, std::size_t count,
+                                  const block_pattern<string_size>& block, std::uint64_t* selection ) {
+    static_assert( sizeof( string<string_size, policies...> ) == string_size, "fl::string must be exactly its buffer" );
+    const char* blocks = reinterpret_cast<const char*>( strings );
+    return select_words( count, selection, [&]( std::size_t first, std::size_t n ) {
+        return simd::match_blocks<string_size>( blocks + first*string_size, n, block.pattern, block.mask );
+    } );
+}
+
+// The first sv.length() bytes of a pattern as masked 64-bit words, to test
+// rows which can be read in whole words (a column's can, thanks to its padding)
+// without a variable-length memcmp().
+template<std::size_t max_length>
+struct word_pattern {
+    static constexpr std::size_t max_words = ( max_length + 7 ) / 8;
+
+    explicit                    word_pattern( std::string_view sv ) : m_count( ( sv.length() + 7 ) / 8 ) {
+                                    char bytes[max_words * 8] = {};
+                                    char mask_bytes[max_words * 8] = {};
+                                    std::memcpy( bytes, sv.data(), sv.length() );
+                                    std::memset( mask_bytes, 0xFF, sv.length() );
+                                    for( std::size_t i=0; i<m_count; ++i ) {
+                                        m_words[i] = simd::detail::load_u64( bytes + i*8 );
+                                        m_masks[i] = simd::detail::load_u64( mask_bytes + i*8 );
+                                    }
+                                }
+
+    bool                        matches( const char* p ) const noexcept {
+                                    std::uint64_t differences = 0;
+                                    for( std::size_t i=0; i<m_count; ++i ) {
+                                        differences |= ( simd::detail::load_u64( p + i*8 ) & m_masks[i] ) ^ m_words[i];
+                                    }
+                                    return differences == 0;
+                                }
+
+private:
+    std::uint64_t               m_words[max_words] = {};
+    std::uint64_t               m_masks[max_words] = {};
+    std::size_t                 m_count;
+};
+
+// Whether p[0, length) contains sv, where p can be read as a whole block of
+// 'width' bytes (and length <= width)
+template<std::size_t width>
+inline bool block_contains( const char* p, std::size_t length, std::string_view sv ) {
+    if( sv.empty() ) {
+        return true;
+    }
+    if( sv.length() > length ) {
+        return false;
+    }
+    unsigned int candidates = simd::match_first_last<width>( p, sv.front(), sv.back(), sv.length()-1 );
+    candidates = simd::detail::low_bits( candidates, length - sv.length() + 1, width );
+    return simd::detail::verify_candidates( candidates, p, 0, sv.data(), sv.length() ) != simd::npos;
+}
+
+// Clears the bits of candidates for which test( row ) fails
+template<typename test>
+inline std::uint64_t verify_rows( std::uint64_t candidates, std::size_t first, test row_matches ) {
+    std::uint64_t bits = candidates;
+    for( ; candidates != 0; candidates &= candidates - 1 ) {
+        const std::size_t i = static_cast<std::size_t>( std::countr_zero( candidates ) );
+        if( !row_matches( first + i ) ) {
+            bits &= ~( std::uint64_t( 1 ) << i );
+        }
+    }
+    return bits;
+}
+
+} // namespace detail
+
+// Select the strings equal to sv.
+template<std::size_t string_size, typename... policies>
+std::size_t select_equal( const string<string_size, policies...>* strings, std::size_t count,
+                          std::string_view sv, std::uint64_t* selection ) {
+    if constexpr( detail::batch_in_register<string_size> ) {
+        if( sv.length() < string_size ) {
+            return detail::select_blocks( strings, count, detail::equal_pattern<string_size>( sv ), selection );
+        }
+    }
+    return detail::select_words( count, selection, [&]( std::size_t first, std::size_t n ) {
+        return detail::match_each( first, n, [&]( std::size_t i ) {
+            return ( strings[i].length() == sv.length() ) && ( std::memcmp( strings[i].data(), sv.data(), sv.length() ) == 0 );
+        } );
+    } );
+}
+
+// Select the strings which start with sv.
+template<std::size_t string_size, typename... policies>
+std::size_t select_prefix( const string<string_size, policies...>* strings, std::size_t count,
+                           std::string_view sv, std::uint64_t* selection ) {
+    if constexpr( detail::batch_in_register<string_size> ) {
+        if( ( sv.length() < string_size ) && ( sv.find( '\0' ) == std::string_view::npos ) ) {
+            return detail::select_blocks( strings, count, detail::prefix_pattern<string_size>( sv ), selection );
+        }
+    }
+    return detail::select_words( count, selection, [&]( std::size_t first, std::size_t n ) {
+        return detail::match_each( first, n, [&]( std::size_t i ) {
+            return ( strings[i].length() >= sv.length() ) && ( std::memcmp( strings[i].data(), sv.data(), sv.length() ) == 0 );
+        } );
+    } );
+}
+
+// Select the strings which contain sv.
+template<std::size_t string_size, typename... policies>
+std::size_t select_contains( const string<string_size, policies...>* strings, std::size_t count,
+                             std::string_view sv, std::uint64_t* selection ) {
+    return detail::select_words( count, selection, [&]( std::size_t first, std::size_t n ) {
+        return detail::match_each( first, n, [&]( std::size_t i ) {
+            if constexpr( ( string_size == 16 ) || ( string_size == 32 ) ) {
+                // the whole string is one block
+                return detail::block_contains<string_size>( strings[i].data(), strings[i].length(), sv );
+            } else if constexpr( string_size < 32 ) {
+                // (copied out whole, rather than read past the end of the array)
+                const std::size_t width = ( string_size < 16 ) ? 16 : 32;
+                char block[width];
+                std::memcpy( block, strings[i].data(), string_size );
+                return detail::block_contains<width>( block, strings[i].length(), sv );
+            } else {
+                return strings[i].find( sv ) != string<string_size, policies...>::npos;
+            }
+        } );
+    } );
+}
+
+// The same selections over a column. Rows are first filtered by length alone,
+// and only the candidates' characters are read.
+template<std::size_t string_size, typename overflow_policy>
+std::size_t select_equal( const string_column<string_size, overflow_policy>& column, std::string_view sv, std::uint64_t* selection ) {
+    using column_type = string_column<string_size, overflow_policy>;
+    if( sv.length() > column_type::stride ) {
+        return detail::select_words( column.size(), selection, []( std::size_t, std::size_t ) { return std::uint64_t( 0 ); } );
+    }
+
+    // the lengths already match, so only the characters are left to compare
+    const detail::word_pattern<column_type::stride> pattern( sv );
+    return detail::select_words( column.size(), selection, [&]( std::size_t first, std::size_t n ) {
+        const std::uint64_t candidates = simd::match_lengths( column.lengths() + first, n, static_cast<std::uint8_t>( sv.length() ), false );
+        return detail::verify_rows( candidates, first, [&]( std::size_t i ) {
+            return pattern.matches( column.chars() + i * column_type::stride );
+        } );
+    } );
+}
+template<std::size_t string_size, typename overflow_policy>
+std::size_t select_prefix( const string_column<string_size, overflow_policy>& column, std::string_view sv, std::uint64_t* selection ) {
+    using column_type = string_column<string_size, overflow_policy>;
+    if( sv.length() > column_type::stride ) {
+        return detail::select_words( column.size(), selection, []( std::size_t, std::size_t ) { return std::uint64_t( 0 ); } );
+    }
+
+    const detail::word_pattern<column_type::stride> pattern( sv );
+    return detail::select_words( column.size(), selection, [&]( std::size_t first, std::size_t n ) {
+        const std::uint64_t candidates = simd::match_lengths( column.lengths() + first, n, static_cast<std::uint8_t>( sv.length() ), true );
+        return detail::verify_rows( candidates, first, [&]( std::size_t i ) {
+            return pattern.matches( column.chars() + i * column_type::stride );
+        } );
+    } );
+}
+template<std::size_t string_size, typename overflow_policy>
+std::size_t select_contains( const string_column<string_size, overflow_policy>& column, std::string_view sv, std::uint64_t* selection ) {
+    using column_type = string_column<string_size, overflow_policy>;
+    if( sv.length() > column_type::stride ) {
+        return detail::select_words( column.size(), selection, []( std::size_t, std::size_t ) { return std::uint64_t( 0 ); } );
+    }
+
+    // the column's padding makes a whole row, and a block past it, readable
+    return detail::select_words( column.size(), selection, [&]( std::size_t first, std::size_t n ) {
+        const std::uint64_t candidates = simd::match_lengths( column.lengths() + first, n, static_cast<std::uint8_t>( sv.length() ), true );
+        return detail::verify_rows( candidates, first, [&]( std::size_t i ) {
+            const char* row = column.chars() + i * column_type::stride;
+            if constexpr( column_type::stride <= 32 ) {
+                return detail::block_contains<( column_type::stride <= 16 ? 16 : 32 )>( row, column.length( i ), sv );
+            } else {
+                return simd::find( row, column.length( i ), column_type::stride + column_type::padding,
+                                   sv.data(), sv.length(), 0 ) != simd::npos;
+            }
+        } );
+    } );
+}
+
+} // namespace fl
+
+
+#endif // FLBATCH_HPP
@@ -0,0 +1,912 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flbench.hpp
+    Author  :   Jamie Taylor
+    Desc    :   A small micro-benchmark harness, for the benchmarks in
+                flstring_benchmarking.cpp.
+                - Each benchmark is warmed up, then its iteration count is
+                  calibrated so that one timed sample takes a set minimum
+                  time (a single std::string construction is far below
+                  the clock's resolution), and then a number of samples
+                  are taken; the min, median and 99th percentile (and
+                  mean) time per operation are reported.
+                - do_not_optimize() and clobber_memory() stop the compiler
+                  from removing or hoisting the work being timed.
+                - The thread can be pinned to a CPU, so that samples
+                  aren't spread over cores (and their caches); threads
+                  that benchmark scaling unpin themselves (and anything
+                  they start) with unpin_thread() or unpinned.
+                - Results can be written out as JSON or CSV, and two CSV
+                  runs compared, flagging regressions in the median.
+                - Heap allocations can be counted too (how many, how many
+                  bytes, and how many more the allocator actually handed
+                  out), once the program routes its global operator new
+                  and delete through track_allocation() and
+                  track_deallocation().
+                - On Linux, hardware performance counters (cycles,
+                  instructions, cache, branch and TLB misses) can be read
+                  over the timed samples too, through perf_event_open();
+                  where they can't be (no PMU, perf_event_paranoid, a
+                  container), the benchmarks just run without them.
+
+===============================================================================
+*/
+#ifndef FLBENCH_HPP
+#define FLBENCH_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#elif defined( _MSC_VER )
+#include <intrin.h>
+#endif
+#if defined( __GLIBC__ )
+#include <malloc.h>
+#elif defined( _MSC_VER )
+#include <malloc.h>
+#endif
+
+namespace fl {
+namespace bench {
+
+// Optimisation barriers (as Google Benchmark's DoNotOptimize()/ClobberMemory()):
+// do_not_optimize() makes the compiler assume that value is read (and for a non-const
+// value, changed) by something it can't see, so the work that produced it can't be
+// removed; clobber_memory() makes it assume that all memory may have been read and written.
+#if defined( __GNUC__ ) || defined( __clang__ )
+// (small trivially-copyable values may stay in a register; GCC mis-compiles the
+// register-or-memory alternatives that clang takes for these, so gets "r" alone)
+namespace detail {
+    template<typename T>
+    inline constexpr bool register_sized = std::is_trivially_copyable_v<T> && sizeof( T ) <= sizeof( void* );
+}
+template<typename T>
+inline void do_not_optimize( const T& value ) {
+#if defined( __clang__ )
+    asm volatile( "" : : "r,m"( value ) : "memory" );
+#else
+    if constexpr( detail::register_sized<T> ) {
+        asm volatile( "" : : "r"( value ) : "memory" );
+    } else {
+        asm volatile( "" : : "m"( value ) : "memory" );
+    }
+#endif
+}
+template<typename T>
+inline void do_not_optimize( T& value ) {
+    if constexpr( detail::register_sized<T> ) {
+#if defined( __clang__ )
+        asm volatile( "" : "+r,m"( value ) : : "memory" );
+#else
+        asm volatile( "" : "+r"( value ) : : "memory" );
+#endif
+    } else {
+        asm volatile( "" : "+m"( value ) : : "memory" );
+    }
+}
+inline void clobber_memory() {
+    asm volatile( "" : : : "memory" );
+}
+#else
+namespace detail {
+    inline volatile const void* sink = nullptr;
+}
+template<typename T>
+inline void do_not_optimize( const T& value ) {
+    detail::sink = &value;
+    _ReadWriteBarrier();
+}
+inline void clobber_memory() {
+    _ReadWriteBarrier();
+}
+#endif
+
+#if defined( __linux__ )
+namespace detail {
+    // the CPUs the process could run on before pin_to_cpu() first narrowed them
+    inline cpu_set_t            unpinned_set;
+    inline std::atomic<bool>    have_unpinned_set = false;
+}
+#endif
+
+// Pin the calling thread to the given CPU; false if that isn't possible (or supported)
+inline bool pin_to_cpu( int cpu ) {
+#if defined( __linux__ )
+    if( cpu < 0 || cpu >= CPU_SETSIZE ) {
+        return false;
+    }
+    if( !detail::have_unpinned_set.load( std::memory_order_acquire ) &&
+        sched_getaffinity( 0, sizeof( detail::unpinned_set ), &detail::unpinned_set ) == 0 ) {
+        detail::have_unpinned_set.store( true, std::memory_order_release );
+    }
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( cpu, &set );
+    return sched_setaffinity( 0, sizeof( set ), &set ) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+// Let the calling thread (and the threads it starts from now on) run on every CPU the
+// process could before pin_to_cpu(), for benchmarks of how work scales over threads,
+// which a thread inheriting --cpu's pinning would squeeze onto one core; does nothing
+// if nothing was pinned
+inline void unpin_thread() noexcept {
+#if defined( __linux__ )
+    if( detail::have_unpinned_set.load( std::memory_order_acquire ) ) {
+        sched_setaffinity( 0, sizeof( detail::unpinned_set ), &detail::unpinned_set );
+    }
+#endif
+}
+// unpin_thread() for as long as it's in scope, then back to the CPUs the thread had
+class unpinned {
+public:
+                                unpinned() noexcept {
+#if defined( __linux__ )
+                                    m_restore = detail::have_unpinned_set.load( std::memory_order_acquire ) &&
+                                                ( sched_getaffinity( 0, sizeof( m_previous ), &m_previous ) == 0 );
+                                    unpin_thread();
+#endif
+                                }
+                                ~unpinned() {
+#if defined( __linux__ )
+                                    if( m_restore ) {
+                                        sched_setaffinity( 0, sizeof( m_previous ), &m_previous );
+                                    }
+#endif
+                                }
+                                unpinned( const unpinned& ) = delete;
+    unpinned&                   operator=( const unpinned& ) = delete;
+
+private:
+#if defined( __linux__ )
+    cpu_set_t                   m_previous;
+    bool                        m_restore = false;
+#endif
+};
+
+// Allocation tracking. The program's replacement global operator new/delete call
+// track_allocation()/track_deallocation(), which only count (with relaxed atomics, from
+// any thread) between begin_allocation_tracking() and end_allocation_tracking().
+struct allocation_stats {
+    std::uint64_t               count = 0;              // allocations
+    std::uint64_t               bytes = 0;              // bytes asked for
+    std::uint64_t               usable_bytes = 0;       // bytes the allocator handed out (malloc_usable_size())
+    std::int64_t                peak_bytes = 0;         // most (usable) bytes live at once, over the fewest live before then
+};
+
+namespace detail {
+    inline std::atomic<bool>            tracking = false;
+    inline std::atomic<std::uint64_t>   allocation_count = 0;
+    inline std::atomic<std::uint64_t>   allocated_bytes = 0;
+    inline std::atomic<std::uint64_t>   usable_bytes = 0;
+    inline std::atomic<std::int64_t>    live_bytes = 0;
+    inline std::atomic<std::int64_t>    trough_bytes = 0;   // the lowest live_bytes has been
+    inline std::atomic<std::int64_t>    peak_bytes = 0;
+
+    // the size of the block the allocator actually gave out for ptr (0 if it can't say)
+    inline std::size_t usable_size( void* ptr ) noexcept {
+#if defined( __GLIBC__ )
+        return malloc_usable_size( ptr );
+#elif defined( _MSC_VER )
+        return _msize( ptr );
+#else
+        (void)ptr;
+        return 0;
+#endif
+    }
+}
+
+inline void track_allocation( void* ptr, std::size_t size ) noexcept {
+    if( ptr == nullptr || !detail::tracking.load( std::memory_order_relaxed ) ) {
+        return;
+    }
+    const std::size_t usable = std::max( detail::usable_size( ptr ), size );
+    detail::allocation_count.fetch_add( 1, std::memory_order_relaxed );
+    detail::allocated_bytes.fetch_add( size, std::memory_order_relaxed );
+    detail::usable_bytes.fetch_add( usable, std::memory_order_relaxed );
+
+    const std::int64_t live = detail::live_bytes.fetch_add( static_cast<std::int64_t>( usable ), std::memory_order_relaxed ) + static_cast<std::int64_t>( usable );
+    const std::int64_t rise = live - detail::trough_bytes.load( std::memory_order_relaxed );
+    std::int64_t peak = detail::peak_bytes.load( std::memory_order_relaxed );
+    while( rise > peak && !detail::peak_bytes.compare_exchange_weak( peak, rise, std::memory_order_relaxed ) ) {
+    }
+}
+inline void track_deallocation( void* ptr ) noexcept {
+    if( ptr == nullptr || !detail::tracking.load( std::memory_order_relaxed ) ) {
+        return;
+    }
+    // Blocks allocated before tracking began are 'freed' here too, so live bytes can dip
+    // below where they started (clearing a container made outside the operation, say);
+    // the peak is measured from the lowest point so far, not from the start, so that
+    // what's built after such a dip still shows up
+    const std::int64_t size = static_cast<std::int64_t>( detail::usable_size( ptr ) );
+    const std::int64_t live = detail::live_bytes.fetch_sub( size, std::memory_order_relaxed ) - size;
+    std::int64_t trough = detail::trough_bytes.load( std::memory_order_relaxed );
+    while( live < trough && !detail::trough_bytes.compare_exchange_weak( trough, live, std::memory_order_relaxed ) ) {
+    }
+}
+
+inline void begin_allocation_tracking() noexcept {
+    detail::allocation_count.store( 0, std::memory_order_relaxed );
+    detail::allocated_bytes.store( 0, std::memory_order_relaxed );
+    detail::usable_bytes.store( 0, std::memory_order_relaxed );
+    detail::live_bytes.store( 0, std::memory_order_relaxed );
+    detail::trough_bytes.store( 0, std::memory_order_relaxed );
+    detail::peak_bytes.store( 0, std::memory_order_relaxed );
+    detail::tracking.store( true, std::memory_order_seq_cst );
+}
+inline allocation_stats end_allocation_tracking() noexcept {
+    detail::tracking.store( false, std::memory_order_seq_cst );
+    allocation_stats stats;
+    stats.count = detail::allocation_count.load( std::memory_order_relaxed );
+    stats.bytes = detail::allocated_bytes.load( std::memory_order_relaxed );
+    stats.usable_bytes = detail::usable_bytes.load( std::memory_order_relaxed );
+    stats.peak_bytes = detail::peak_bytes.load( std::memory_order_relaxed );
+    return stats;
+}
+// The allocations made by op()
+template<typename operation>
+allocation_stats count_allocations( operation op ) {
+    begin_allocation_tracking();
+    op();
+    return end_allocation_tracking();
+}
+// Heap bytes owned by a std::string (none, when it's held in the SSO buffer)
+inline std::size_t heap_bytes( const std::string& str ) noexcept {
+    const char* object = reinterpret_cast<const char*>( &str );
+    const bool in_situ = ( str.data() >= object ) && ( str.data() < object + sizeof( str ) );
+    return in_situ ? 0 : str.capacity() + 1;
+}
+
+// Hardware performance counters, through Linux's perf_event_open(). Each event is opened
+// on its own (not as a group), so that one the CPU doesn't have doesn't lose the rest; if
+// there are more events than hardware counters, the kernel time-slices them, and the
+// counts are scaled up by the time each one was actually counting.
+inline constexpr std::size_t    counter_count = 6;
+                                // (for output, and as the JSON keys/CSV columns)
+inline constexpr std::array<const char*, counter_count> counter_names = {
+    "cycles", "instructions", "L1D misses", "LLC misses", "branch misses", "dTLB misses"
+};
+inline constexpr std::array<const char*, counter_count> counter_keys = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+};
+                                // the counts, in counter_names order; NaN for any that weren't counted
+using counter_values            = std::array<double, counter_count>;
+
+inline counter_values no_counter_values() noexcept {
+    counter_values values;
+    values.fill( std::numeric_limits<double>::quiet_NaN() );
+    return values;
+}
+// "1.23 cycles, 4.56 instructions (IPC 3.71), ..." (leaving out those that weren't counted)
+inline void write_counters( std::ostream& out, const counter_values& values );
+
+class perf_counters {
+public:
+                                // Opens the counters (stopped) for the calling thread, and any threads it
+                                // starts from now on; user-space only
+                                perf_counters();
+                                ~perf_counters();
+                                perf_counters( const perf_counters& ) = delete;
+    perf_counters&              operator=( const perf_counters& ) = delete;
+
+                                // whether any counter (or the given one) could be opened, and if not all
+                                // of them, why not
+    bool                        available() const noexcept;
+    bool                        available( std::size_t counter ) const noexcept { return m_fds[counter] >= 0; }
+    const std::string&          error() const noexcept { return m_error; }
+
+                                // zero and start the counters; stop them, and read what they counted
+    void                        start() noexcept;
+    counter_values              stop() noexcept;
+
+private:
+    std::array<int, counter_count> m_fds;
+    std::string                 m_error;
+};
+
+#if defined( __linux__ )
+inline perf_counters::perf_counters() {
+    const auto cache_miss = []( std::uint64_t cache ) {
+        return cache | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+    };
+    const std::array<std::pair<std::uint32_t, std::uint64_t>, counter_count> events = { {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, cache_miss( PERF_COUNT_HW_CACHE_L1D ) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },     // (the last level, on most CPUs)
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, cache_miss( PERF_COUNT_HW_CACHE_DTLB ) },
+    } };
+
+    int error = 0;
+    for( std::size_t i=0; i<counter_count; ++i ) {
+        perf_event_attr attr;
+        std::memset( &attr, 0, sizeof( attr ) );
+        attr.size = sizeof( attr );
+        attr.type = events[i].first;
+        attr.config = events[i].second;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fds[i] = static_cast<int>( syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 ) );
+        if( m_fds[i] < 0 ) {
+            error = ( error == 0 ) ? errno : error;
+            m_error += ( m_error.empty() ? "" : ", " ) + std::string( counter_names[i] );
+        }
+    }
+    // (the reason given is the first failure's; they tend all to fail for the same one)
+    if( error != 0 ) {
+        m_error += std::string( ": " ) + std::strerror( error );
+        if( error == EACCES || error == EPERM ) {
+            m_error += " (see /proc/sys/kernel/perf_event_paranoid)";
+        }
+    }
+}
+inline perf_counters::~perf_counters() {
+    for( const int fd : m_fds ) {
+        if( fd >= 0 ) {
+            close( fd );
+        }
+    }
+}
+inline void perf_counters::start() noexcept {
+    for( const int fd : m_fds ) {
+        if( fd >= 0 ) {
+            ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+            ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+        }
+    }
+}
+inline counter_values perf_counters::stop() noexcept {
+    for( const int fd : m_fds ) {
+        if( fd >= 0 ) {
+            ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+        }
+    }
+    counter_values values = no_counter_values();
+    for( std::size_t i=0; i<counter_count; ++i ) {
+        std::uint64_t data[3];     // value, time enabled, time running
+        if( m_fds[i] < 0 || read( m_fds[i], data, sizeof( data ) ) != static_cast<ssize_t>( sizeof( data ) ) ) {
+            continue;
+        }
+        if( data[2] != 0 ) {
+            values[i] = static_cast<double>( data[0] ) * data[1] / data[2];
+        } else if( data[1] == 0 ) {
+            values[i] = 0.0;    // enabled too briefly to have been scheduled
+        }
+        // (and left as NaN if it never got onto the PMU at all)
+    }
+    return values;
+}
+#else
+inline perf_counters::perf_counters() :
+    m_error( "hardware counters are only read on Linux" ) {
+    m_fds.fill( -1 );
+}
+inline perf_counters::~perf_counters() {
+}
+inline void perf_counters::start() noexcept {
+}
+inline counter_values perf_counters::stop() noexcept {
+    return no_counter_values();
+}
+#endif
+inline bool perf_counters::available() const noexcept {
+    return std::any_of( m_fds.begin(), m_fds.end(), []( int fd ) { return fd >= 0; } );
+}
+
+inline void write_counters( std::ostream& out, const counter_values& values ) {
+    const char* separator = "";
+    for( std::size_t i=0; i<counter_count; ++i ) {
+        if( std::isnan( values[i] ) ) {
+            continue;
+        }
+        out << separator << values[i] << ' ' << counter_names[i];
+        separator = ", ";
+        if( i == 1 && !std::isnan( values[0] ) && values[0] > 0.0 ) {
+            out << " (IPC " << values[1] / values[0] << ')';
+        }
+    }
+    if( *separator == '\0' ) {
+        out << "no counters";
+    }
+}
+
+struct options {
+    double                      warmup_ms = 20.0;       // time spent running a benchmark before calibrating it
+    double                      sample_ms = 2.0;        // the least time one sample should take
+    unsigned int                sample_count = 100;
+    int                         cpu = -1;               // the CPU to pin to (-1: leave the thread be)
+                                                        // count each benchmark's allocations (only if the program
+                                                        // reports them: see track_allocation())
+    bool                        track_allocations = false;
+    bool                        perf_counters = false;  // read the hardware counters over each benchmark's samples
+    std::string                 json_path;              // where to write the results, if anywhere
+    std::string                 csv_path;
+};
+
+struct result {
+    std::string                 name;
+    std::uint64_t               iterations = 0;         // operations a sample
+    unsigned int                samples = 0;
+    std::size_t                 items = 1;              // items an operation; the times below are per item
+    double                      min_ns = 0.0;
+    double                      median_ns = 0.0;
+    double                      p99_ns = 0.0;
+    double                      mean_ns = 0.0;
+    bool                        tracked_allocations = false;
+                                                        // per item, if allocations were tracked
+    double                      allocations = 0.0;
+    double                      allocated_bytes = 0.0;
+    double                      overhead_bytes = 0.0;   // usable bytes over those asked for
+    std::int64_t                peak_bytes = 0;         // over all the allocation-counting run
+    bool                        counted = false;        // whether the hardware counters were read
+    counter_values              counters = no_counter_values(); // per item, over all the samples
+};
+
+class harness {
+public:
+    explicit                    harness( const options& opts = options() );
+
+                                // Time op(), as name; items is the number of things (keys, look-ups,
+                                // ...) that one op() call processes, so that times are per thing.
+                                // max_samples caps options::sample_count, for operations too long
+                                // to sample that often (sorting millions of strings, say)
+                                template<typename operation>
+    const result&               run( std::string_view name, operation op, std::size_t items = 1,
+                                     unsigned int max_samples = std::numeric_limits<unsigned int>::max() );
+
+    const std::vector<result>&  results() const noexcept { return m_results; }
+    const options&              settings() const noexcept { return m_options; }
+
+    void                        write_json( std::ostream& out ) const;
+    void                        write_csv( std::ostream& out ) const;
+                                // to options::json_path and options::csv_path (those that are set)
+    void                        write_files() const;
+
+private:
+    using clock                 = std::chrono::steady_clock;
+
+    template<typename operation>
+    static double               time_ns( operation& op, std::uint64_t iterations );
+
+    options                     m_options;
+    std::optional<perf_counters> m_counters;            // if options::perf_counters, and any could be opened
+    std::vector<result>         m_results;
+};
+
+// Read back the output of harness::write_csv()
+inline std::vector<result>      read_csv( std::istream& in );
+// Compare two CSV runs, benchmark by benchmark (by name), printing each change in the
+// median time; returns the number of regressions (slower by more than threshold, as a
+// fraction, or making more allocations)
+inline std::size_t              compare( const std::vector<result>& baseline, const std::vector<result>& current,
+                                         double threshold, std::ostream& out );
+// options from the command line: --cpu N, --samples N, --sample-ms MS, --warmup-ms MS,
+// --json FILE, --csv FILE, --perf; throws std::invalid_argument for anything else
+// (options::track_allocations is left to the program, which knows if it can)
+inline options                  parse_options( int argc, char* argv[] );
+
+// construction
+inline harness::harness( const options& opts ) :
+    m_options( opts ) {
+    if( m_options.sample_count == 0 ) {
+        throw std::invalid_argument( "fl::bench::harness needs at least one sample" );
+    }
+    if( m_options.cpu >= 0 && !pin_to_cpu( m_options.cpu ) ) {
+        std::cerr << "fl::bench: couldn't pin to CPU " << m_options.cpu << "; carrying on unpinned." << std::endl;
+    }
+    if( m_options.perf_counters ) {
+        m_counters.emplace();
+        if( !m_counters->error().empty() ) {
+            std::cerr << "fl::bench: couldn't open " << ( m_counters->available() ? "some" : "any" ) << " hardware counters ("
+                      << m_counters->error() << "); carrying on " << ( m_counters->available() ? "without those." : "without them." ) << std::endl;
+        }
+        if( !m_counters->available() ) {
+            m_counters.reset();
+        }
+    }
+}
+
+// running
+template<typename operation>
+const result& harness::run( std::string_view name, operation op, std::size_t items, unsigned int max_samples ) {
+    // warm up (caches, branch predictors, lazily-mapped pages, CPU clocks)
+    const auto warmup_end = clock::now() + std::chrono::duration<double, std::milli>( m_options.warmup_ms );
+    do {
+        op();
+    } while( clock::now() < warmup_end );
+
+    // calibrate: grow the iteration count until one sample takes at least sample_ms
+    const double sample_ns = m_options.sample_ms * 1e6;
+    std::uint64_t iterations = 1;
+    for( ;; ) {
+        const double elapsed = time_ns( op, iterations );
+        if( elapsed >= sample_ns || iterations >= ( std::uint64_t( 1 ) << 32 ) ) {
+            break;
+        }
+        // aim a little past the target, but grow at most 100x at a time (the first
+        // timings of very short operations are mostly clock overhead)
+        const double scale = ( elapsed > 0.0 ) ? std::min( 100.0, 1.2 * sample_ns / elapsed ) : 100.0;
+        iterations = std::max( iterations + 1, static_cast<std::uint64_t>( iterations * scale ) );
+    }
+
+    std::vector<double> samples( std::min( m_options.sample_count, std::max( max_samples, 1u ) ) );
+    if( m_counters ) {
+        m_counters->start();
+    }
+    for( double& sample : samples ) {
+        sample = time_ns( op, iterations ) / ( static_cast<double>( iterations ) * items );
+    }
+    const counter_values counts = m_counters ? m_counters->stop() : no_counter_values();
+    std::sort( samples.begin(), samples.end() );
+
+    result r;
+    r.name = name;
+    r.iterations = iterations;
+    r.samples = static_cast<unsigned int>( samples.size() );
+    r.items = items;
+    r.min_ns = samples.front();
+    r.median_ns = ( samples.size() % 2 ) ? samples[samples.size()/2] : ( samples[samples.size()/2 - 1] + samples[samples.size()/2] ) / 2.0;
+    // nearest rank
+    r.p99_ns = samples[static_cast<std::size_t>( std::ceil( 0.99 * samples.size() ) ) - 1];
+    for( const double sample : samples ) {
+        r.mean_ns += sample;
+    }
+    r.mean_ns /= samples.size();
+    if( m_counters ) {
+        const double divisor = static_cast<double>( iterations ) * samples.size() * items;
+        for( std::size_t i=0; i<counter_count; ++i ) {
+            r.counters[i] = counts[i] / divisor;
+        }
+        r.counted = true;
+    }
+
+    // Count allocations in a separate, untimed run, so that tracking them can't slow
+    // down the timed ones (up to 1000 operations: allocation patterns don't vary much)
+    if( m_options.track_allocations ) {
+        const std::uint64_t counted = std::min<std::uint64_t>( iterations, 1000 );
+        const allocation_stats stats = count_allocations( [&]() {
+            for( std::uint64_t i=0; i<counted; ++i ) {
+                op();
+            }
+        } );
+        const double divisor = static_cast<double>( counted ) * items;
+        r.allocations = stats.count / divisor;
+        r.allocated_bytes = stats.bytes / divisor;
+        r.overhead_bytes = ( stats.usable_bytes - stats.bytes ) / divisor;
+        r.peak_bytes = stats.peak_bytes;
+        r.tracked_allocations = true;
+    }
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision( 2 )
+         << r.name << ": median " << r.median_ns << " ns, min " << r.min_ns << " ns, p99 " << r.p99_ns << " ns";
+    if( m_options.track_allocations ) {
+        // (to significant digits, not places: a few allocations per thousand items is not none)
+        line << std::defaultfloat << std::setprecision( 3 )
+             << "; " << r.allocations << " allocations of " << r.allocated_bytes << " B (+" << r.overhead_bytes << " B overhead)"
+             << std::fixed << std::setprecision( 2 );
+    }
+    line << ( ( items > 1 ) ? " per item" : "" );
+    if( m_options.track_allocations ) {
+        line << "; peak " << r.peak_bytes << " B";
+    }
+    if( r.counted ) {
+        line << "\n    ";
+        write_counters( line, r.counters );
+        line << ( ( items > 1 ) ? " per item" : "" );
+    }
+    std::cout << line.str() << std::endl;
+
+    m_results.push_back( std::move( r ) );
+    return m_results.back();
+}
+template<typename operation>
+double harness::time_ns( operation& op, std::uint64_t iterations ) {
+    const auto start = clock::now();
+    for( std::uint64_t i=0; i<iterations; ++i ) {
+        op();
+    }
+    const auto stop = clock::now();
+    return std::chrono::duration<double, std::nano>( stop - start ).count();
+}
+
+// output
+namespace detail {
+    // restores a stream's formatting (precision, fixed, ...) on the way out
+    class format_saver {
+    public:
+        explicit                format_saver( std::ostream& out ) : m_out( out ), m_flags( out.flags() ), m_precision( out.precision() ) {}
+                                ~format_saver() { m_out.flags( m_flags ); m_out.precision( m_precision ); }
+    private:
+        std::ostream&           m_out;
+        std::ios_base::fmtflags m_flags;
+        std::streamsize         m_precision;
+    };
+    inline void write_json_string( std::ostream& out, std::string_view str ) {
+        out << '"';
+        for( const char c : str ) {
+            switch( c ) {
+            case '"':   out << "\\\""; break;
+            case '\\':  out << "\\\\"; break;
+            case '\n':  out << "\\n"; break;
+            case '\t':  out << "\\t"; break;
+            default:
+                if( static_cast<unsigned char>( c ) < 0x20 ) {
+                    out << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << static_cast<int>( c ) << std::dec << std::setfill( ' ' );
+                } else {
+                    out << c;
+                }
+            }
+        }
+        out << '"';
+    }
+    inline void write_csv_field( std::ostream& out, std::string_view str ) {
+        if( str.find_first_of( ",\"\n" ) == std::string_view::npos ) {
+            out << str;
+            return;
+        }
+        out << '"';
+        for( const char c : str ) {
+            out << c;
+            if( c == '"' ) {
+                out << '"';
+            }
+        }
+        out << '"';
+    }
+    // One CSV record (which may span lines, inside quotes); false at the end of the input
+    inline bool read_csv_record( std::istream& in, std::vector<std::string>& fields ) {
+        fields.clear();
+        if( in.peek() == std::char_traits<char>::eof() ) {
+            return false;
+        }
+        std::string field;
+        bool quoted = false;
+        for( int c; ( c = in.get() ) != std::char_traits<char>::eof(); ) {
+            if( quoted ) {
+                if( c == '"' ) {
+                    if( in.peek() == '"' ) {
+                        field += static_cast<char>( in.get() );
+                    } else {
+                        quoted = false;
+                    }
+                } else {
+                    field += static_cast<char>( c );
+                }
+            } else if( c == '"' ) {
+                quoted = true;
+            } else if( c == ',' ) {
+                fields.push_back( std::move( field ) );
+                field.clear();
+            } else if( c == '\n' ) {
+                break;
+            } else if( c != '\r' ) {
+                field += static_cast<char>( c );
+            }
+        }
+        fields.push_back( std::move( field ) );
+        return true;
+    }
+}
+
+inline void harness::write_json( std::ostream& out ) const {
+    const detail::format_saver saver( out );
+    out << std::setprecision( 17 ) << "{\n  \"benchmarks\": [";
+    for( std::size_t i=0; i<m_results.size(); ++i ) {
+        const result& r = m_results[i];
+        out << ( i ? ",\n" : "\n" ) << "    { \"name\": ";
+        detail::write_json_string( out, r.name );
+        out << ", \"iterations\": " << r.iterations << ", \"samples\": " << r.samples << ", \"items\": " << r.items
+            << ", \"min_ns\": " << r.min_ns << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+            << ", \"mean_ns\": " << r.mean_ns;
+        if( r.tracked_allocations ) {
+            out << ", \"allocations\": " << r.allocations << ", \"allocated_bytes\": " << r.allocated_bytes
+                << ", \"overhead_bytes\": " << r.overhead_bytes << ", \"peak_bytes\": " << r.peak_bytes;
+        }
+        for( std::size_t c=0; c<counter_count; ++c ) {
+            if( r.counted && !std::isnan( r.counters[c] ) ) {
+                out << ", \"" << counter_keys[c] << "\": " << r.counters[c];
+            }
+        }
+        out << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+inline void harness::write_csv( std::ostream& out ) const {
+    const detail::format_saver saver( out );
+    out << std::setprecision( 17 ) << "name,iterations,samples,items,min_ns,median_ns,p99_ns,mean_ns,allocations,allocated_bytes,overhead_bytes,peak_bytes";
+    for( const char* key : counter_keys ) {
+        out << ',' << key;
+    }
+    out << '\n';
+    for( const result& r : m_results ) {
+        detail::write_csv_field( out, r.name );
+        out << ',' << r.iterations << ',' << r.samples << ',' << r.items << ',' << r.min_ns << ','
+            << r.median_ns << ',' << r.p99_ns << ',' << r.mean_ns;
+        // (the allocation and counter columns are left empty if they weren't tracked, or counted)
+        if( r.tracked_allocations ) {
+            out << ',' << r.allocations << ',' << r.allocated_bytes << ',' << r.overhead_bytes << ',' << r.peak_bytes;
+        } else {
+            out << ",,,,";
+        }
+        for( const double count : r.counters ) {
+            out << ',';
+            if( r.counted && !std::isnan( count ) ) {
+                out << count;
+            }
+        }
+        out << '\n';
+    }
+}
+inline void harness::write_files() const {
+    if( !m_options.json_path.empty() ) {
+        std::ofstream out( m_options.json_path );
+        write_json( out );
+        if( !out ) {
+            throw std::runtime_error( "fl::bench: couldn't write " + m_options.json_path );
+        }
+    }
+    if( !m_options.csv_path.empty() ) {
+        std::ofstream out( m_options.csv_path );
+        write_csv( out );
+        if( !out ) {
+            throw std::runtime_error( "fl::bench: couldn't write " + m_options.csv_path );
+        }
+    }
+}
+
+// comparison
+inline std::vector<result> read_csv( std::istream& in ) {
+    std::vector<result> results;
+    std::vector<std::string> fields;
+    if( !detail::read_csv_record( in, fields ) || fields.empty() || fields[0] != "name" ) {
+        throw std::invalid_argument( "fl::bench: not a benchmark CSV file" );
+    }
+    while( detail::read_csv_record( in, fields ) ) {
+        if( fields.size() == 1 && fields[0].empty() ) {
+            continue;   // blank line
+        }
+        // (without the allocation or counter columns, from before they were added)
+        if( fields.size() != 8 && fields.size() != 12 && fields.size() != 12 + counter_count ) {
+            throw std::invalid_argument( "fl::bench: malformed benchmark CSV record" );
+        }
+        result r;
+        r.name = fields[0];
+        r.iterations = std::stoull( fields[1] );
+        r.samples = static_cast<unsigned int>( std::stoul( fields[2] ) );
+        r.items = static_cast<std::size_t>( std::stoull( fields[3] ) );
+        r.min_ns = std::stod( fields[4] );
+        r.median_ns = std::stod( fields[5] );
+        r.p99_ns = std::stod( fields[6] );
+        r.mean_ns = std::stod( fields[7] );
+        if( fields.size() >= 12 && !fields[8].empty() ) {
+            r.tracked_allocations = true;
+            r.allocations = std::stod( fields[8] );
+            r.allocated_bytes = std::stod( fields[9] );
+            r.overhead_bytes = std::stod( fields[10] );
+            r.peak_bytes = std::stoll( fields[11] );
+        }
+        for( std::size_t c=0; c<counter_count && 12 + c < fields.size(); ++c ) {
+            if( !fields[12 + c].empty() ) {
+                r.counters[c] = std::stod( fields[12 + c] );
+                r.counted = true;
+            }
+        }
+        results.push_back( std::move( r ) );
+    }
+    return results;
+}
+inline std::size_t compare( const std::vector<result>& baseline, const std::vector<result>& current,
+                            double threshold, std::ostream& out ) {
+    std::map<std::string_view, const result*> baseline_by_name;
+    for( const result& r : baseline ) {
+        baseline_by_name[r.name] = &r;
+    }
+
+    std::size_t regressions = 0;
+    const detail::format_saver saver( out );
+    out << std::fixed << std::setprecision( 2 );
+    for( const result& r : current ) {
+        const auto it = baseline_by_name.find( r.name );
+        if( it == baseline_by_name.end() ) {
+            out << r.name << ": new (median " << r.median_ns << " ns)\n";
+            continue;
+        }
+        const double before = it->second->median_ns;
+        const double change = ( before > 0.0 ) ? ( r.median_ns - before ) / before : 0.0;
+        const char* verdict = "";
+        if( change > threshold ) {
+            verdict = "  << REGRESSION";
+            ++regressions;
+        } else if( change < -threshold ) {
+            verdict = "  (improved)";
+        }
+        out << r.name << ": median " << before << " ns -> " << r.median_ns << " ns ("
+            << std::showpos << change * 100.0 << std::noshowpos << "%)" << verdict << "\n";
+        // any new heap traffic is a regression, whatever the time
+        if( r.tracked_allocations && it->second->tracked_allocations && r.allocations > it->second->allocations ) {
+            out << r.name << ": allocations " << it->second->allocations << " -> " << r.allocations << " per item  << REGRESSION\n";
+            ++regressions;
+        }
+        baseline_by_name.erase( it );
+    }
+    for( const auto& [name, r] : baseline_by_name ) {
+        out << name << ": missing from the current run\n";
+    }
+    out << regressions << " regression(s) beyond " << threshold * 100.0 << "%" << std::endl;
+    return regressions;
+}
+
+inline options parse_options( int argc, char* argv[] ) {
+    options opts;
+    for( int i=1; i<argc; ++i ) {
+        const std::string_view arg( argv[i] );
+        if( arg == "--perf" ) {
+            opts.perf_counters = true;
+            continue;
+        }
+        if( i + 1 >= argc ) {
+            throw std::invalid_argument( "fl::bench: unknown (or incomplete) option " + std::string( arg ) );
+        }
+        const std::string value( argv[++i] );
+        if( arg == "--cpu" ) {
+            opts.cpu = std::stoi( value );
+        } else if( arg == "--samples" ) {
+            opts.sample_count = static_cast<unsigned int>( std::stoul( value ) );
+        } else if( arg == "--sample-ms" ) {
+            opts.sample_ms = std::stod( value );
+        } else if( arg == "--warmup-ms" ) {
+            opts.warmup_ms = std::stod( value );
+        } else if( arg == "--json" ) {
+            opts.json_path = value;
+        } else if( arg == "--csv" ) {
+            opts.csv_path = value;
+        } else {
+            throw std::invalid_argument( "fl::bench: unknown option " + std::string( arg ) );
+        }
+    }
+    return opts;
+}
+
+} // namespace bench
+} // namespace fl
+
+
+#endif // FLBENCH_HPP
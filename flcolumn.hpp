@@ -0,0 +1,331 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flcolumn.hpp
+    Author  :   Jamie Taylor
+    Desc    :   A column of fixed-width strings, stored structure-of-arrays
+                style: the characters of every row in one contiguous,
+                cache-line aligned block (N-1 bytes a row, zero-padded),
+                and the lengths in a separate array of bytes. Compared to
+                an array of fl::string<N>, there is no capacity byte or
+                terminator interleaved with the characters, so scans over
+                the characters (or over just the lengths) touch only the
+                bytes they need. Rows are read back as std::string_views,
+                or copied out as fl::string<N>.
+
+===============================================================================
+*/
+#ifndef FLCOLUMN_HPP
+#define FLCOLUMN_HPP
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "flstring.hpp"
+
+namespace fl {
+
+template<std::size_t string_size, typename overflow_policy = assert_on_overflow>
+class string_column {
+    // lengths are stored in a byte each
+    static_assert( ( string_size > 1 ) && ( string_size <= 256 ), "fl::string_column size must be between 2 and 256" );
+
+public:
+
+                                // member types
+                                // rows are read as string_views (what the iterators give), and copied
+                                // out by get() as string_type
+    using value_type            = std::string_view;
+    using string_type           = string<string_size, zero_padding, overflow_policy>;
+    using size_type             = std::size_t;
+    using difference_type       = std::ptrdiff_t;
+    using string_view           = std::string_view;
+    using length_type           = std::uint8_t;
+
+    class                       const_iterator;
+    using iterator              = const_iterator;
+
+                                // characters per row (no terminator)
+    static constexpr size_type  stride = string_size - 1;
+                                // the character block is aligned to, and padded by, a cache line; so
+                                // a row can always be read with whole 16 or 32 byte (unaligned) loads
+    static constexpr size_type  alignment = 64;
+    static constexpr size_type  padding = 64;
+
+                                // construction and assignment
+                                string_column() noexcept = default;
+                                string_column( const string_column& other );
+                                string_column( string_column&& other ) noexcept;
+                                ~string_column();
+
+    string_column&              operator=( const string_column& other );
+    string_column&              operator=( string_column&& other ) noexcept;
+
+                                // element access
+    string_view                 operator[]( size_type pos ) const noexcept;
+    string_view                 at( size_type pos ) const;
+    string_type                 get( size_type pos ) const;
+    size_type                   length( size_type pos ) const noexcept { return m_lengths[pos]; }
+                                // the raw columns: row i is chars()[i*stride, i*stride + lengths()[i])
+    const char*                 chars() const noexcept { return m_chars; }
+    const length_type*          lengths() const noexcept { return m_lengths; }
+
+                                // iterators
+    const_iterator              begin() const noexcept { return const_iterator( this, 0 ); }
+    const_iterator              cbegin() const noexcept { return begin(); }
+    const_iterator              end() const noexcept { return const_iterator( this, m_size ); }
+    const_iterator              cend() const noexcept { return end(); }
+
+                                // capacity
+    bool                        empty() const noexcept { return m_size == 0; }
+    size_type                   size() const noexcept { return m_size; }
+    size_type                   capacity() const noexcept { return m_capacity; }
+    void                        reserve( size_type count );
+    void                        shrink_to_fit();
+                                // bytes allocated for the characters and lengths
+    size_type                   memory_usage() const noexcept;
+
+                                // modifiers
+    void                        clear() noexcept { m_size = 0; }
+    void                        push_back( string_view sv );
+                                template<std::size_t N, typename... policies>
+    void                        push_back( const string<N, policies...>& str ) { push_back( string_view( str.data(), str.length() ) ); }
+    void                        append( const char* const* strings, size_type count );
+    void                        append( const string_view* strings, size_type count );
+    void                        set( size_type pos, string_view sv );
+    void                        pop_back() noexcept { --m_size; }
+    void                        swap( string_column& other ) noexcept;
+
+private:
+    char*                       row( size_type pos ) const noexcept { return m_chars + pos*stride; }
+    void                        store( size_type pos, string_view sv );
+                                // grow_for() and reallocate() hand back the old block (in an otherwise
+                                // empty column, which frees it), so that strings being copied in from
+                                // this column's own rows can still be read until they're stored
+    string_column               grow_for( size_type count );
+    string_column               reallocate( size_type capacity );
+    void                        deallocate() noexcept;
+
+    char*                       m_chars = nullptr;
+    length_type*                m_lengths = nullptr;
+    size_type                   m_size = 0;
+    size_type                   m_capacity = 0;
+};
+
+// Random access iterator over the rows, as string_views. It hands the views out by value,
+// so it's only a (legacy) input iterator, though a C++20 random access one.
+template<std::size_t string_size, typename overflow_policy>
+class string_column<string_size, overflow_policy>::const_iterator {
+public:
+    using iterator_category     = std::input_iterator_tag;
+    using iterator_concept      = std::random_access_iterator_tag;
+    using value_type            = std::string_view;
+    using difference_type       = std::ptrdiff_t;
+    using reference             = std::string_view;
+    using pointer               = void;
+
+                                const_iterator() noexcept = default;
+
+    reference                   operator*() const noexcept { return ( *m_column )[m_pos]; }
+    reference                   operator[]( difference_type n ) const noexcept { return ( *m_column )[m_pos + n]; }
+
+    const_iterator&             operator++() noexcept { ++m_pos; return *this; }
+    const_iterator              operator++( int ) noexcept { const_iterator previous = *this; ++m_pos; return previous; }
+    const_iterator&             operator--() noexcept { --m_pos; return *this; }
+    const_iterator              operator--( int ) noexcept { const_iterator previous = *this; --m_pos; return previous; }
+    const_iterator&             operator+=( difference_type n ) noexcept { m_pos += n; return *this; }
+    const_iterator&             operator-=( difference_type n ) noexcept { m_pos -= n; return *this; }
+
+    friend const_iterator       operator+( const_iterator it, difference_type n ) noexcept { return it += n; }
+    friend const_iterator       operator+( difference_type n, const_iterator it ) noexcept { return it += n; }
+    friend const_iterator       operator-( const_iterator it, difference_type n ) noexcept { return it -= n; }
+    friend difference_type      operator-( const const_iterator& lhs, const const_iterator& rhs ) noexcept {
+                                    return static_cast<difference_type>( lhs.m_pos ) - static_cast<difference_type>( rhs.m_pos );
+                                }
+    friend bool                 operator==( const const_iterator& lhs, const const_iterator& rhs ) noexcept { return lhs.m_pos == rhs.m_pos; }
+    friend auto                 operator<=>( const const_iterator& lhs, const const_iterator& rhs ) noexcept { return lhs.m_pos <=> rhs.m_pos; }
+
+private:
+    friend class string_column;
+
+                                const_iterator( const string_column* column, size_type pos ) noexcept :
+                                    m_column( column ), m_pos( pos ) {}
+
+    const string_column*        m_column = nullptr;
+    size_type                   m_pos = 0;
+};
+
+// construction and assignment
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy>::string_column( const string_column& other ) {
+    if( other.m_size == 0 ) {
+        return;
+    }
+
+    reallocate( other.m_size );
+    std::memcpy( m_chars, other.m_chars, other.m_size * stride );
+    std::memcpy( m_lengths, other.m_lengths, other.m_size );
+    m_size = other.m_size;
+}
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy>::string_column( string_column&& other ) noexcept {
+    swap( other );
+}
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy>::~string_column() {
+    deallocate();
+}
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy>& string_column<string_size, overflow_policy>::operator=( const string_column& other ) {
+    if( this != &other ) {
+        string_column copy( other );
+        swap( copy );
+    }
+    return *this;
+}
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy>& string_column<string_size, overflow_policy>::operator=( string_column&& other ) noexcept {
+    string_column moved( std::move( other ) );
+    swap( moved );
+    return *this;
+}
+
+// element access
+template<std::size_t string_size, typename overflow_policy>
+std::string_view string_column<string_size, overflow_policy>::operator[]( size_type pos ) const noexcept {
+    assert( pos < m_size );
+    return string_view( row( pos ), m_lengths[pos] );
+}
+template<std::size_t string_size, typename overflow_policy>
+std::string_view string_column<string_size, overflow_policy>::at( size_type pos ) const {
+    if( pos >= m_size ) {
+        throw std::out_of_range( "fl::string_column::at" );
+    }
+    return ( *this )[pos];
+}
+template<std::size_t string_size, typename overflow_policy>
+typename string_column<string_size, overflow_policy>::string_type string_column<string_size, overflow_policy>::get( size_type pos ) const {
+    return string_type( ( *this )[pos] );
+}
+
+// capacity
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::reserve( size_type count ) {
+    if( count > m_capacity ) {
+        reallocate( count );
+    }
+}
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::shrink_to_fit() {
+    if( m_size == 0 ) {
+        deallocate();
+    } else if( m_size < m_capacity ) {
+        reallocate( m_size );
+    }
+}
+template<std::size_t string_size, typename overflow_policy>
+typename string_column<string_size, overflow_policy>::size_type string_column<string_size, overflow_policy>::memory_usage() const noexcept {
+    return ( m_capacity == 0 ) ? 0 : ( m_capacity * stride + padding ) + m_capacity * sizeof( length_type );
+}
+
+// modifiers
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::push_back( string_view sv ) {
+    const string_column retired = grow_for( 1 );
+    store( m_size, sv );
+    ++m_size;
+}
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::append( const char* const* strings, size_type count ) {
+    const string_column retired = grow_for( count );
+    for( size_type i=0; i<count; ++i ) {
+        store( m_size + i, string_view( strings[i] ) );
+    }
+    m_size += count;
+}
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::append( const string_view* strings, size_type count ) {
+    const string_column retired = grow_for( count );
+    for( size_type i=0; i<count; ++i ) {
+        store( m_size + i, strings[i] );
+    }
+    m_size += count;
+}
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::set( size_type pos, string_view sv ) {
+    assert( pos < m_size );
+    store( pos, sv );
+}
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::swap( string_column& other ) noexcept {
+    std::swap( m_chars, other.m_chars );
+    std::swap( m_lengths, other.m_lengths );
+    std::swap( m_size, other.m_size );
+    std::swap( m_capacity, other.m_capacity );
+}
+
+// internals
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::store( size_type pos, string_view sv ) {
+    const size_type len = overflow_policy::fit( sv.length(), stride );
+    char* p = row( pos );
+    // (sv may be part of this same row, as with set( i, column[i].substr( ... ) ))
+    std::memmove( p, sv.data(), len );
+    std::memset( p + len, 0, stride - len );
+    m_lengths[pos] = static_cast<length_type>( len );
+}
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy> string_column<string_size, overflow_policy>::grow_for( size_type count ) {
+    if( m_size + count > m_capacity ) {
+        return reallocate( std::max( m_size + count, 2 * m_capacity ) );
+    }
+    return string_column();
+}
+template<std::size_t string_size, typename overflow_policy>
+string_column<string_size, overflow_policy> string_column<string_size, overflow_policy>::reallocate( size_type capacity ) {
+    char* chars = static_cast<char*>( ::operator new( capacity * stride + padding, std::align_val_t( alignment ) ) );
+    length_type* lengths;
+    try {
+        lengths = new length_type[capacity];
+    } catch( ... ) {
+        ::operator delete( chars, std::align_val_t( alignment ) );
+        throw;
+    }
+    if( m_size != 0 ) {
+        std::memcpy( chars, m_chars, m_size * stride );
+        std::memcpy( lengths, m_lengths, m_size );
+    }
+    std::memset( chars + capacity * stride, 0, padding );
+
+    string_column old;
+    old.m_chars = std::exchange( m_chars, chars );
+    old.m_lengths = std::exchange( m_lengths, lengths );
+    old.m_capacity = std::exchange( m_capacity, capacity );
+    return old;
+}
+template<std::size_t string_size, typename overflow_policy>
+void string_column<string_size, overflow_policy>::deallocate() noexcept {
+    if( m_chars != nullptr ) {
+        ::operator delete( m_chars, std::align_val_t( alignment ) );
+        delete[] m_lengths;
+    }
+    m_chars = nullptr;
+    m_lengths = nullptr;
+    m_capacity = 0;
+}
+
+} // namespace fl
+
+
+#endif // FLCOLUMN_HPP
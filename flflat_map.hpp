@@ -0,0 +1,494 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flflat_map.hpp
+    Author  :   Jamie Taylor
+    Desc    :   An open-addressing hash map keyed on fl::string<N>.
+                Keys and values live inline in one contiguous array of
+                slots (no per-entry nodes). Alongside it is an array of
+                control bytes, one per slot, holding either a 7-bit tag
+                from the key's hash or an empty/deleted marker. Lookups
+                compare 16 tags at a time with SSE2 (SwissTable-style),
+                and only compare keys whose tags match. Keys are stored
+                zero-padded, so that comparison is a whole-block
+                fixed-width equality (a single integer compare for
+                N = 4, 8 and 16).
+
+===============================================================================
+*/
+#ifndef FLFLAT_MAP_HPP
+#define FLFLAT_MAP_HPP
+
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "flstring.hpp"
+#include "flsimd.hpp"
+
+namespace fl {
+
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+class sharded_map;
+
+template<std::size_t key_size, typename mapped>
+class flat_map {
+public:
+
+                                // member types
+    using key_type              = string<key_size, zero_padding>;
+    using mapped_type           = mapped;
+    using value_type            = std::pair<const key_type, mapped_type>;
+    using size_type             = std::size_t;
+    using reference             = value_type&;
+    using const_reference       = const value_type&;
+
+                                template<bool is_const>
+    class                       basic_iterator;
+    using iterator              = basic_iterator<false>;
+    using const_iterator        = basic_iterator<true>;
+
+                                // slots are probed a group (of control bytes) at a time
+    static constexpr size_type  group_size = 16;
+
+                                // construction and assignment
+                                flat_map() noexcept = default;
+                                flat_map( const flat_map& other );
+                                flat_map( flat_map&& other ) noexcept;
+                                ~flat_map();
+
+    flat_map&                   operator=( const flat_map& other );
+    flat_map&                   operator=( flat_map&& other ) noexcept;
+
+                                // iterators
+    iterator                    begin() noexcept;
+    const_iterator              begin() const noexcept;
+    const_iterator              cbegin() const noexcept;
+    iterator                    end() noexcept;
+    const_iterator              end() const noexcept;
+    const_iterator              cend() const noexcept;
+
+                                // capacity
+    bool                        empty() const noexcept;
+    size_type                   size() const noexcept;
+    size_type                   capacity() const noexcept;
+    void                        reserve( size_type count );
+
+                                // modifiers
+    void                        clear() noexcept;
+    std::pair<iterator, bool>   insert( const value_type& value );
+                                template<typename... args>
+    std::pair<iterator, bool>   try_emplace( const key_type& key, args&&... values );
+    mapped_type&                operator[]( const key_type& key );
+    size_type                   erase( const key_type& key );
+    iterator                    erase( const_iterator pos );
+    void                        swap( flat_map& other ) noexcept;
+
+                                // lookup
+    iterator                    find( const key_type& key );
+    const_iterator              find( const key_type& key ) const;
+    bool                        contains( const key_type& key ) const;
+
+private:
+                                // (which hashes its batches up front, and hands the hashes on)
+                                template<std::size_t, typename, unsigned int>
+    friend class                sharded_map;
+
+    static constexpr size_type  npos = static_cast<size_type>( -1 );
+                                // full slots hold the low 7 bits of the hash (top bit clear)
+    static constexpr char       empty_control = static_cast<char>( 0x80 );
+    static constexpr char       deleted_control = static_cast<char>( 0xFE );
+
+    static size_type            hash_of( const key_type& key ) noexcept { return hash_value( key ); }
+    static char                 tag_of( size_type hash ) noexcept { return static_cast<char>( hash & 0x7F ); }
+    static size_type            max_load( size_type capacity ) noexcept { return capacity - capacity/8; }
+
+                                // try_emplace() and find() for a key whose hash_of() is already known
+                                template<typename... args>
+    std::pair<iterator, bool>   try_emplace_hashed( const key_type& key, size_type hash, args&&... values );
+    const_iterator              find_hashed( const key_type& key, size_type hash ) const;
+    size_type                   find_index( const key_type& key, size_type hash ) const;
+    size_type                   find_insert_index( size_type hash ) const;
+    void                        set_control( size_type index, char control ) noexcept { m_control[index] = control; }
+    void                        erase_at( size_type index );
+    void                        rehash( size_type capacity );
+    void                        destroy_slots() noexcept;
+    void                        deallocate() noexcept;
+    iterator                    iterator_at( size_type index ) noexcept;
+    const_iterator              iterator_at( size_type index ) const noexcept;
+
+    char*                       m_control = nullptr;
+    value_type*                 m_slots = nullptr;
+    size_type                   m_capacity = 0;     // 0, or a power-of-two multiple of group_size
+    size_type                   m_size = 0;
+    size_type                   m_growth_left = 0;  // inserts into empty slots before a rehash
+};
+
+// Forward iterator over the full slots.
+template<std::size_t key_size, typename mapped>
+template<bool is_const>
+class flat_map<key_size, mapped>::basic_iterator {
+public:
+    using iterator_category     = std::forward_iterator_tag;
+    using value_type            = typename flat_map::value_type;
+    using difference_type       = std::ptrdiff_t;
+    using pointer               = std::conditional_t<is_const, const value_type*, value_type*>;
+    using reference             = std::conditional_t<is_const, const value_type&, value_type&>;
+
+                                basic_iterator() noexcept = default;
+                                // iterator -> const_iterator
+                                template<bool other_is_const> requires ( is_const && !other_is_const )
+                                basic_iterator( const basic_iterator<other_is_const>& other ) noexcept :
+                                    m_control( other.m_control ), m_control_end( other.m_control_end ), m_slot( other.m_slot ) {}
+
+    reference                   operator*() const noexcept { return *m_slot; }
+    pointer                     operator->() const noexcept { return m_slot; }
+    basic_iterator&             operator++() noexcept {
+                                    ++m_control;
+                                    ++m_slot;
+                                    skip_unused();
+                                    return *this;
+                                }
+    basic_iterator              operator++( int ) noexcept {
+                                    basic_iterator previous = *this;
+                                    ++( *this );
+                                    return previous;
+                                }
+    friend bool                 operator==( const basic_iterator& lhs, const basic_iterator& rhs ) noexcept {
+                                    return lhs.m_slot == rhs.m_slot;
+                                }
+
+private:
+    friend class flat_map;
+                                template<bool>
+    friend class                basic_iterator;
+
+                                basic_iterator( const char* control, const char* control_end, pointer slot ) noexcept :
+                                    m_control( control ), m_control_end( control_end ), m_slot( slot ) {
+                                    skip_unused();
+                                }
+    void                        skip_unused() noexcept {
+                                    // empty and deleted slots both have the top bit set
+                                    while( ( m_control != m_control_end ) && ( *m_control & 0x80 ) ) {
+                                        ++m_control;
+                                        ++m_slot;
+                                    }
+                                }
+
+    const char*                 m_control = nullptr;
+    const char*                 m_control_end = nullptr;
+    pointer                     m_slot = nullptr;
+};
+
+// construction and assignment
+template<std::size_t key_size, typename mapped>
+flat_map<key_size, mapped>::flat_map( const flat_map& other ) {
+    if( other.m_capacity == 0 ) {
+        return;
+    }
+
+    // Built up in a map of its own, each slot marked used only once it's been copied, so
+    // that if a copy throws, its destructor cleans up what was done
+    flat_map copy;
+    copy.m_control = new char[other.m_capacity];
+    std::memset( copy.m_control, empty_control, other.m_capacity );
+    copy.m_capacity = other.m_capacity;
+    copy.m_slots = std::allocator<value_type>().allocate( other.m_capacity );
+    for( size_type i=0; i<other.m_capacity; ++i ) {
+        if( !( other.m_control[i] & 0x80 ) ) {
+            std::construct_at( &copy.m_slots[i], other.m_slots[i] );
+            copy.set_control( i, other.m_control[i] );
+        }
+    }
+    std::memcpy( copy.m_control, other.m_control, other.m_capacity );
+    copy.m_size = other.m_size;
+    copy.m_growth_left = other.m_growth_left;
+
+    swap( copy );
+}
+template<std::size_t key_size, typename mapped>
+flat_map<key_size, mapped>::flat_map( flat_map&& other ) noexcept {
+    swap( other );
+}
+template<std::size_t key_size, typename mapped>
+flat_map<key_size, mapped>::~flat_map() {
+    destroy_slots();
+    deallocate();
+}
+template<std::size_t key_size, typename mapped>
+flat_map<key_size, mapped>& flat_map<key_size, mapped>::operator=( const flat_map& other ) {
+    if( this != &other ) {
+        flat_map copy( other );
+        swap( copy );
+    }
+    return *this;
+}
+template<std::size_t key_size, typename mapped>
+flat_map<key_size, mapped>& flat_map<key_size, mapped>::operator=( flat_map&& other ) noexcept {
+    flat_map moved( std::move( other ) );
+    swap( moved );
+    return *this;
+}
+
+// iterators
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::iterator flat_map<key_size, mapped>::begin() noexcept {
+    return iterator( m_control, m_control + m_capacity, m_slots );
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::begin() const noexcept {
+    return const_iterator( m_control, m_control + m_capacity, m_slots );
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::cbegin() const noexcept {
+    return begin();
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::iterator flat_map<key_size, mapped>::end() noexcept {
+    return iterator( m_control + m_capacity, m_control + m_capacity, m_slots + m_capacity );
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::end() const noexcept {
+    return const_iterator( m_control + m_capacity, m_control + m_capacity, m_slots + m_capacity );
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::cend() const noexcept {
+    return end();
+}
+
+// capacity
+template<std::size_t key_size, typename mapped>
+bool flat_map<key_size, mapped>::empty() const noexcept {
+    return m_size == 0;
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::size_type flat_map<key_size, mapped>::size() const noexcept {
+    return m_size;
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::size_type flat_map<key_size, mapped>::capacity() const noexcept {
+    return m_capacity;
+}
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::reserve( size_type count ) {
+    // room for count entries without going over the maximum load
+    size_type capacity = group_size;
+    while( max_load( capacity ) < count ) {
+        capacity *= 2;
+    }
+    if( capacity > m_capacity ) {
+        rehash( capacity );
+    }
+}
+
+// modifiers
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::clear() noexcept {
+    destroy_slots();
+    if( m_capacity != 0 ) {
+        std::memset( m_control, empty_control, m_capacity );
+    }
+    m_size = 0;
+    m_growth_left = max_load( m_capacity );
+}
+template<std::size_t key_size, typename mapped>
+std::pair<typename flat_map<key_size, mapped>::iterator, bool> flat_map<key_size, mapped>::insert( const value_type& value ) {
+    return try_emplace( value.first, value.second );
+}
+template<std::size_t key_size, typename mapped>
+template<typename... args>
+std::pair<typename flat_map<key_size, mapped>::iterator, bool> flat_map<key_size, mapped>::try_emplace( const key_type& key, args&&... values ) {
+    return try_emplace_hashed( key, hash_of( key ), std::forward<args>( values )... );
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::mapped_type& flat_map<key_size, mapped>::operator[]( const key_type& key ) {
+    return try_emplace( key ).first->second;
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::size_type flat_map<key_size, mapped>::erase( const key_type& key ) {
+    const size_type index = find_index( key, hash_of( key ) );
+    if( index == npos ) {
+        return 0;
+    }
+    erase_at( index );
+    return 1;
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::iterator flat_map<key_size, mapped>::erase( const_iterator pos ) {
+    const size_type index = static_cast<size_type>( pos.m_slot - m_slots );
+    erase_at( index );
+    return iterator_at( index );
+}
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::swap( flat_map& other ) noexcept {
+    std::swap( m_control, other.m_control );
+    std::swap( m_slots, other.m_slots );
+    std::swap( m_capacity, other.m_capacity );
+    std::swap( m_size, other.m_size );
+    std::swap( m_growth_left, other.m_growth_left );
+}
+
+// lookup
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::iterator flat_map<key_size, mapped>::find( const key_type& key ) {
+    const size_type index = find_index( key, hash_of( key ) );
+    return ( index != npos ) ? iterator_at( index ) : end();
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::find( const key_type& key ) const {
+    const size_type index = find_index( key, hash_of( key ) );
+    return ( index != npos ) ? iterator_at( index ) : end();
+}
+template<std::size_t key_size, typename mapped>
+bool flat_map<key_size, mapped>::contains( const key_type& key ) const {
+    return find_index( key, hash_of( key ) ) != npos;
+}
+
+// private functions
+template<std::size_t key_size, typename mapped>
+template<typename... args>
+std::pair<typename flat_map<key_size, mapped>::iterator, bool> flat_map<key_size, mapped>::try_emplace_hashed( const key_type& key, size_type hash, args&&... values ) {
+    size_type index = find_index( key, hash );
+    if( index != npos ) {
+        return { iterator_at( index ), false };
+    }
+
+    if( m_growth_left == 0 ) {
+        // mostly tombstones: clean them out in place, otherwise grow
+        rehash( ( m_size < max_load( m_capacity )/2 ) ? m_capacity : std::max( m_capacity*2, group_size ) );
+    }
+
+    // (the slot is only counted against the growth left once the value's been made)
+    index = find_insert_index( hash );
+    std::construct_at( &m_slots[index], std::piecewise_construct, std::forward_as_tuple( key ),
+                       std::forward_as_tuple( std::forward<args>( values )... ) );
+    if( m_control[index] == empty_control ) {
+        --m_growth_left;
+    }
+    set_control( index, tag_of( hash ) );
+    ++m_size;
+
+    return { iterator_at( index ), true };
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::find_hashed( const key_type& key, size_type hash ) const {
+    const size_type index = find_index( key, hash );
+    return ( index != npos ) ? iterator_at( index ) : end();
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::size_type flat_map<key_size, mapped>::find_index( const key_type& key, size_type hash ) const {
+    if( m_capacity == 0 ) {
+        return npos;
+    }
+
+    // groups are probed triangularly (+1, +2, +3, ...), which visits every
+    // group when their count is a power of two. A group with an empty slot
+    // ends the search, the key would have been inserted there.
+    const size_type group_mask = m_capacity/group_size - 1;
+    const char tag = tag_of( hash );
+    size_type group = ( hash >> 7 ) & group_mask;
+    for( size_type step = 1; ; ++step ) {
+        const char* control = &m_control[group * group_size];
+        for( unsigned int matches = simd::match_group16( control, tag ); matches != 0; matches &= matches - 1 ) {
+            const size_type index = group * group_size + simd::detail::count_trailing_zeros( matches );
+            if( m_slots[index].first == key ) {
+                return index;
+            }
+        }
+        if( simd::match_group16( control, empty_control ) != 0 ) {
+            return npos;
+        }
+        group = ( group + step ) & group_mask;
+    }
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::size_type flat_map<key_size, mapped>::find_insert_index( size_type hash ) const {
+    // first empty or deleted slot on the key's probe sequence, there's always
+    // one as the load is capped at 7/8
+    const size_type group_mask = m_capacity/group_size - 1;
+    size_type group = ( hash >> 7 ) & group_mask;
+    for( size_type step = 1; ; ++step ) {
+        const unsigned int unused = simd::match_group16_high_bit( &m_control[group * group_size] );
+        if( unused != 0 ) {
+            return group * group_size + simd::detail::count_trailing_zeros( unused );
+        }
+        group = ( group + step ) & group_mask;
+    }
+}
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::erase_at( size_type index ) {
+    std::destroy_at( &m_slots[index] );
+    --m_size;
+
+    // if the group still has an empty slot, no probe ever went past it, so
+    // this one can be marked empty (and reused) rather than left a tombstone
+    const char* group = &m_control[index - index % group_size];
+    if( simd::match_group16( group, empty_control ) != 0 ) {
+        set_control( index, empty_control );
+        ++m_growth_left;
+    } else {
+        set_control( index, deleted_control );
+    }
+}
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::rehash( size_type capacity ) {
+    flat_map rehashed;
+    rehashed.m_control = new char[capacity];
+    std::memset( rehashed.m_control, empty_control, capacity );
+    rehashed.m_capacity = capacity;
+    rehashed.m_slots = std::allocator<value_type>().allocate( capacity );
+
+    for( size_type i=0; i<m_capacity; ++i ) {
+        if( !( m_control[i] & 0x80 ) ) {
+            const size_type hash = hash_of( m_slots[i].first );
+            const size_type index = rehashed.find_insert_index( hash );
+            std::construct_at( &rehashed.m_slots[index], std::move( m_slots[i] ) );
+            rehashed.set_control( index, tag_of( hash ) );
+        }
+    }
+    rehashed.m_size = m_size;
+    rehashed.m_growth_left = max_load( capacity ) - m_size;
+
+    swap( rehashed );
+}
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::destroy_slots() noexcept {
+    if constexpr( !std::is_trivially_destructible_v<value_type> ) {
+        for( size_type i=0; i<m_capacity; ++i ) {
+            if( !( m_control[i] & 0x80 ) ) {
+                std::destroy_at( &m_slots[i] );
+            }
+        }
+    }
+}
+template<std::size_t key_size, typename mapped>
+void flat_map<key_size, mapped>::deallocate() noexcept {
+    // (the slots may not have been allocated, if that's what threw)
+    delete[] m_control;
+    if( m_slots != nullptr ) {
+        std::allocator<value_type>().deallocate( m_slots, m_capacity );
+    }
+    m_control = nullptr;
+    m_slots = nullptr;
+    m_capacity = 0;
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::iterator flat_map<key_size, mapped>::iterator_at( size_type index ) noexcept {
+    return iterator( m_control + index, m_control + m_capacity, m_slots + index );
+}
+template<std::size_t key_size, typename mapped>
+typename flat_map<key_size, mapped>::const_iterator flat_map<key_size, mapped>::iterator_at( size_type index ) const noexcept {
+    return const_iterator( m_control + index, m_control + m_capacity, m_slots + index );
+}
+
+} // namespace fl
+
+
+#endif // FLFLAT_MAP_HPP
@@ -0,0 +1,234 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flhash.hpp
+    Author  :   Jamie Taylor
+    Desc    :   Hash functions used by fl::string.
+                - mix64()/hash64(): fast, non-cryptographic hashes for
+                  hash-table keys (hash64() folds 16 bytes per multiply).
+                - crc32(): the usual (zlib/IEEE) CRC-32, slice-by-8.
+                - crc32c(): CRC-32C (Castagnoli), using the SSE4.2 crc32
+                  instruction when the CPU has it (checked at run-time,
+                  unless the target already guarantees it) and a
+                  slice-by-8 table otherwise.
+
+===============================================================================
+*/
+#ifndef FLHASH_HPP
+#define FLHASH_HPP
+
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "flsimd.hpp"
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && ( defined(__GNUC__) || defined(__clang__) )
+    #include <nmmintrin.h>
+    #define FL_HASH_HAS_SSE42_CRC32C 1
+#elif defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+    #define FL_HASH_HAS_SSE42_CRC32C 1
+#endif
+
+
+namespace fl {
+namespace hash {
+
+// murmur3's 64-bit finaliser
+constexpr std::uint64_t mix64( std::uint64_t h ) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+namespace detail {
+
+// 64x64 -> 128-bit multiply, folded back into 64 bits
+constexpr std::uint64_t multiply_fold( std::uint64_t lhs, std::uint64_t rhs ) {
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>( lhs ) * rhs;
+    return static_cast<std::uint64_t>( product ) ^ static_cast<std::uint64_t>( product >> 64 );
+#else
+    const std::uint64_t lhs_low = lhs & 0xFFFFFFFF, lhs_high = lhs >> 32;
+    const std::uint64_t rhs_low = rhs & 0xFFFFFFFF, rhs_high = rhs >> 32;
+    const std::uint64_t low_low = lhs_low * rhs_low;
+    const std::uint64_t high_low = lhs_high * rhs_low;
+    const std::uint64_t low_high = lhs_low * rhs_high;
+    const std::uint64_t high_high = lhs_high * rhs_high;
+    const std::uint64_t middle = ( low_low >> 32 ) + ( high_low & 0xFFFFFFFF ) + low_high;
+    const std::uint64_t low = ( middle << 32 ) | ( low_low & 0xFFFFFFFF );
+    const std::uint64_t high = high_high + ( high_low >> 32 ) + ( middle >> 32 );
+    return low ^ high;
+#endif
+}
+
+inline constexpr std::uint64_t hash_key0 = 0xa0761d6478bd642fULL;
+inline constexpr std::uint64_t hash_key1 = 0xe7037ed1a0b428dbULL;
+inline constexpr std::uint64_t hash_key2 = 0x8ebc6af09c88c6e3ULL;
+
+} // namespace detail
+
+// Hash of length bytes for hash-tables. 16 bytes are folded in per multiply;
+// the final (<= 16 byte) part is read with overlapping loads, so nothing
+// outside [p, p+length) is touched. Usable at compile-time, with the same
+// result as at run-time. 'max_length' is an upper bound on length, if one's
+// known at compile time, so that branches for longer input can be dropped.
+template<std::size_t max_length = static_cast<std::size_t>( -1 )>
+constexpr std::uint64_t hash64( const char* p, std::size_t length, std::uint64_t seed = 0 ) {
+    using simd::detail::load_u64;
+    using simd::detail::load_u32;
+
+    std::uint64_t h = seed ^ detail::multiply_fold( seed ^ detail::hash_key0, length ^ detail::hash_key1 );
+
+    std::size_t i = 0;
+    for( ; ( max_length > 16 ) && ( i+16 < length ); i += 16 ) {
+        h = detail::multiply_fold( load_u64( p + i ) ^ detail::hash_key1, load_u64( p + i+8 ) ^ h );
+    }
+
+    const std::size_t remaining = length - i;
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    if( ( max_length > 8 ) && ( remaining > 8 ) ) {
+        a = load_u64( p + i );
+        b = load_u64( p + length-8 );
+    } else if( ( max_length >= 4 ) && ( remaining >= 4 ) ) {
+        a = load_u32( p + i );
+        b = load_u32( p + length-4 );
+    } else if( remaining > 0 ) {
+        a = ( static_cast<std::uint64_t>( static_cast<unsigned char>( p[i] ) ) << 16 ) |
+            ( static_cast<std::uint64_t>( static_cast<unsigned char>( p[i + remaining/2] ) ) << 8 ) |
+            static_cast<std::uint64_t>( static_cast<unsigned char>( p[length-1] ) );
+    }
+    h = detail::multiply_fold( a ^ detail::hash_key1, b ^ h );
+
+    return detail::multiply_fold( h ^ detail::hash_key2, length ^ detail::hash_key1 );
+}
+
+namespace detail {
+
+inline constexpr std::uint32_t crc32_polynomial = 0xedb88320;   // IEEE 802.3 (reflected)
+inline constexpr std::uint32_t crc32c_polynomial = 0x82f63b78;  // Castagnoli (reflected)
+
+// Tables for slice-by-8: tables[0] is the classic byte-at-a-time table, and
+// tables[k][b] is the CRC of byte b followed by k zero bytes.
+template<std::uint32_t polynomial>
+constexpr std::array<std::array<std::uint32_t, 256>, 8> make_crc_tables() {
+    std::array<std::array<std::uint32_t, 256>, 8> tables = {};
+    for( std::uint32_t i=0; i<256; ++i ) {
+        std::uint32_t crc = i;
+        for( int bit=0; bit<8; ++bit ) {
+            crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? polynomial : 0 );
+        }
+        tables[0][i] = crc;
+    }
+    for( std::size_t k=1; k<8; ++k ) {
+        for( std::size_t i=0; i<256; ++i ) {
+            tables[k][i] = ( tables[k-1][i] >> 8 ) ^ tables[0][tables[k-1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+template<std::uint32_t polynomial>
+inline constexpr std::array<std::array<std::uint32_t, 256>, 8> crc_tables = make_crc_tables<polynomial>();
+
+// Eight bytes per step, as two independent 32-bit halves, each byte looked up
+// in its own table. The raw (un-inverted) CRC register is passed in and out.
+template<std::uint32_t polynomial>
+std::uint32_t crc_slice_by_8( const unsigned char* p, std::size_t length, std::uint32_t crc ) {
+    const auto& tables = crc_tables<polynomial>;
+
+    if constexpr( std::endian::native == std::endian::little ) {
+        for( ; length >= 8; p += 8, length -= 8 ) {
+            std::uint32_t one;
+            std::uint32_t two;
+            std::memcpy( &one, p, 4 );
+            std::memcpy( &two, p + 4, 4 );
+            one ^= crc;
+            crc = tables[7][one & 0xFF] ^ tables[6][( one >> 8 ) & 0xFF] ^
+                  tables[5][( one >> 16 ) & 0xFF] ^ tables[4][one >> 24] ^
+                  tables[3][two & 0xFF] ^ tables[2][( two >> 8 ) & 0xFF] ^
+                  tables[1][( two >> 16 ) & 0xFF] ^ tables[0][two >> 24];
+        }
+    }
+    for( ; length != 0; ++p, --length ) {
+        crc = ( crc >> 8 ) ^ tables[0][( crc ^ *p ) & 0xFF];
+    }
+
+    return crc;
+}
+
+#if defined(FL_HASH_HAS_SSE42_CRC32C)
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__(( target( "sse4.2" ) ))
+#endif
+inline std::uint32_t crc32c_sse42( const unsigned char* p, std::size_t length, std::uint32_t crc ) {
+#if defined(__x86_64__) || defined(_M_X64)
+    std::uint64_t crc64 = crc;
+    for( ; length >= 8; p += 8, length -= 8 ) {
+        std::uint64_t word;
+        std::memcpy( &word, p, 8 );
+        crc64 = _mm_crc32_u64( crc64, word );
+    }
+    crc = static_cast<std::uint32_t>( crc64 );
+#endif
+    for( ; length >= 4; p += 4, length -= 4 ) {
+        std::uint32_t word;
+        std::memcpy( &word, p, 4 );
+        crc = _mm_crc32_u32( crc, word );
+    }
+    for( ; length != 0; ++p, --length ) {
+        crc = _mm_crc32_u8( crc, *p );
+    }
+    return crc;
+}
+
+inline bool cpu_has_sse42() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid( info, 1 );
+    return ( info[2] & ( 1 << 20 ) ) != 0;
+#else
+    return __builtin_cpu_supports( "sse4.2" );
+#endif
+}
+#endif
+
+} // namespace detail
+
+// CRC-32 as used by zlib, gzip, PNG etc. Pass a previous result as crc to
+// continue it: crc32( b, n, crc32( a, m ) ) is the CRC of a followed by b.
+inline std::uint32_t crc32( const void* data, std::size_t length, std::uint32_t crc = 0 ) {
+    const unsigned char* p = static_cast<const unsigned char*>( data );
+    return ~detail::crc_slice_by_8<detail::crc32_polynomial>( p, length, ~crc );
+}
+
+// CRC-32C (iSCSI, ext4, ...), chained in the same way as crc32().
+inline std::uint32_t crc32c( const void* data, std::size_t length, std::uint32_t crc = 0 ) {
+    const unsigned char* p = static_cast<const unsigned char*>( data );
+#if defined(__SSE4_2__)
+    return ~detail::crc32c_sse42( p, length, ~crc );
+#elif defined(FL_HASH_HAS_SSE42_CRC32C)
+    static const bool has_sse42 = detail::cpu_has_sse42();
+    if( has_sse42 ) {
+        return ~detail::crc32c_sse42( p, length, ~crc );
+    }
+    return ~detail::crc_slice_by_8<detail::crc32c_polynomial>( p, length, ~crc );
+#else
+    return ~detail::crc_slice_by_8<detail::crc32c_polynomial>( p, length, ~crc );
+#endif
+}
+
+} // namespace hash
+} // namespace fl
+
+
+#endif // FLHASH_HPP
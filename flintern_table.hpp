@@ -0,0 +1,217 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flintern_table.hpp
+    Author  :   Jamie Taylor
+    Desc    :   A concurrent string interning table: maps fl::string<N>
+                to dense 32-bit IDs (0, 1, 2, ... in the order they were
+                first interned), and back again. Any number of threads
+                may intern() and find() at once, without locks.
+                - The strings are stored inline, in an array indexed by
+                  ID (the reverse mapping), so an ID is stable for the
+                  life of the table and costs no allocation.
+                - The forward mapping is an open-addressing table of
+                  64-bit words, each holding a hash tag and an ID, which
+                  are claimed and published with compare-and-swap.
+                - find() is wait-free: at most one pass over the slots,
+                  never waiting on a writer.
+                The capacity (the most strings the table will hold) is
+                fixed at construction, so nothing ever has to move.
+
+===============================================================================
+*/
+#ifndef FLINTERN_TABLE_HPP
+#define FLINTERN_TABLE_HPP
+
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "flstring.hpp"
+
+namespace fl {
+
+template<std::size_t string_size>
+class intern_table {
+                                template<typename T>
+    static constexpr bool       string_view_like = std::is_convertible_v<const T&, std::string_view> &&
+                                                   !std::is_same_v<T, string<string_size, zero_padding>>;
+
+public:
+
+                                // member types
+    using key_type              = string<string_size, zero_padding>;
+    using id_type               = std::uint32_t;
+    using size_type             = std::size_t;
+
+                                // returned by find() for a string that hasn't been interned
+    static constexpr id_type    npos = static_cast<id_type>( -1 );
+
+                                // construction; capacity is the most strings the table will hold
+    explicit                    intern_table( size_type capacity );
+                                intern_table( const intern_table& ) = delete;
+    intern_table&               operator=( const intern_table& ) = delete;
+
+                                // capacity
+    size_type                   size() const noexcept;
+    size_type                   capacity() const noexcept { return m_capacity; }
+
+                                // The ID of key, interning it first if it's new; throws std::length_error
+                                // if it's new and the table is full. Lock-free, except that a thread
+                                // interning a string that another thread is part way through interning
+                                // (or one with the same hash tag) waits for that to be published.
+    id_type                     intern( const key_type& key );
+                                // anything else that converts to a string_view (const char*,
+                                // std::string, ...); throws std::length_error if it's too long to intern
+                                template<typename T> requires string_view_like<T>
+    id_type                     intern( const T& str ) { return intern( key_of( str ) ); }
+                                // The ID of key, or npos; wait-free
+    id_type                     find( const key_type& key ) const noexcept;
+                                template<typename T> requires string_view_like<T>
+    id_type                     find( const T& str ) const noexcept {
+                                    const std::string_view sv( str );
+                                    return ( sv.length() < string_size ) ? find( key_type( sv ) ) : npos;
+                                }
+                                // The string with the given ID (as returned by intern() or find())
+    const key_type&             operator[]( id_type id ) const noexcept { return m_strings[id]; }
+    std::string_view            view( id_type id ) const noexcept { return std::string_view( m_strings[id].data(), m_strings[id].length() ); }
+
+private:
+                                // a slot is 0 (empty) or tag << 32 | state; the state is ID + 1 once
+                                // published, or claimed_state while the claiming thread writes the string
+    static constexpr id_type    claimed_state = 0xFFFFFFFF;
+    static constexpr id_type    full_state = 0xFFFFFFFE;    // claimed, then found no room for the string
+    static constexpr size_type  max_capacity = 0xFFFFFFFD;
+
+    static std::uint64_t        hash_of( const key_type& key ) noexcept { return static_cast<std::uint64_t>( hash_value( key ) ); }
+    static std::uint64_t        tag_of( std::uint64_t hash ) noexcept { return hash & 0xFFFFFFFF00000000ULL; }
+    static id_type              state_of( std::uint64_t slot ) noexcept { return static_cast<id_type>( slot ); }
+    static key_type             key_of( std::string_view sv );
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_slots;
+    std::unique_ptr<key_type[]> m_strings;
+    size_type                   m_capacity;
+    size_type                   m_mask;         // slot count - 1; at least twice the capacity, so probes stay short
+    std::atomic<size_type>      m_size = 0;     // IDs handed out (may pass capacity, by failed interns)
+};
+
+// construction
+template<std::size_t string_size>
+intern_table<string_size>::intern_table( size_type capacity ) :
+    m_capacity( capacity ) {
+    if( capacity > max_capacity ) {
+        throw std::length_error( "fl::intern_table capacity is too large for 32-bit IDs" );
+    }
+
+    const size_type slot_count = std::bit_ceil( 2 * ( capacity < 8 ? 8 : capacity ) );
+    m_slots = std::make_unique<std::atomic<std::uint64_t>[]>( slot_count );
+    m_strings = std::make_unique<key_type[]>( capacity );
+    m_mask = slot_count - 1;
+}
+
+// capacity
+template<std::size_t string_size>
+typename intern_table<string_size>::size_type intern_table<string_size>::size() const noexcept {
+    const size_type size = m_size.load( std::memory_order_relaxed );
+    return ( size < m_capacity ) ? size : m_capacity;
+}
+
+// interning and lookup
+template<std::size_t string_size>
+typename intern_table<string_size>::id_type intern_table<string_size>::intern( const key_type& key ) {
+    const std::uint64_t hash = hash_of( key );
+    const std::uint64_t tag = tag_of( hash );
+
+    size_type pos = static_cast<size_type>( hash ) & m_mask;
+    for( size_type probes=0; probes<=m_mask; ) {
+        std::uint64_t slot = m_slots[pos].load( std::memory_order_acquire );
+
+        if( slot == 0 ) {
+            if( m_size.load( std::memory_order_acquire ) >= m_capacity ) {
+                // Full, unless the last ID went to this very string, claiming this slot after
+                // it was read (the claim is ordered before the ID, so is visible by now)
+                if( m_slots[pos].load( std::memory_order_acquire ) != 0 ) {
+                    continue;
+                }
+                throw std::length_error( "fl::intern_table is full" );
+            }
+            // Claim the slot, so that nobody else can put the string anywhere else, then
+            // write the string and publish its ID. If the claim fails, look again at
+            // what's in the slot now (which may well be this same string).
+            if( !m_slots[pos].compare_exchange_strong( slot, tag | claimed_state, std::memory_order_acquire ) ) {
+                continue;
+            }
+            const size_type id = m_size.fetch_add( 1, std::memory_order_acq_rel );
+            if( id >= m_capacity ) {
+                m_slots[pos].store( tag | full_state, std::memory_order_release );
+                throw std::length_error( "fl::intern_table is full" );
+            }
+            m_strings[id] = key;
+            m_slots[pos].store( tag | ( id + 1 ), std::memory_order_release );
+            return static_cast<id_type>( id );
+        }
+
+        if( ( slot & 0xFFFFFFFF00000000ULL ) == tag ) {
+            // the string could be this one; wait for it to be published to find out
+            while( state_of( slot ) == claimed_state ) {
+                std::this_thread::yield();
+                slot = m_slots[pos].load( std::memory_order_acquire );
+            }
+            const id_type state = state_of( slot );
+            if( ( state != full_state ) && ( m_strings[state - 1] == key ) ) {
+                return state - 1;
+            }
+        }
+
+        pos = ( pos + 1 ) & m_mask;
+        ++probes;
+    }
+
+    throw std::length_error( "fl::intern_table is full" );
+}
+template<std::size_t string_size>
+typename intern_table<string_size>::id_type intern_table<string_size>::find( const key_type& key ) const noexcept {
+    const std::uint64_t hash = hash_of( key );
+    const std::uint64_t tag = tag_of( hash );
+
+    size_type pos = static_cast<size_type>( hash ) & m_mask;
+    for( size_type probes=0; probes<=m_mask; ++probes ) {
+        const std::uint64_t slot = m_slots[pos].load( std::memory_order_acquire );
+        if( slot == 0 ) {
+            return npos;
+        }
+
+        // a string still being interned hasn't been interned yet, so is skipped over
+        const id_type state = state_of( slot );
+        if( ( ( slot & 0xFFFFFFFF00000000ULL ) == tag ) && ( state < full_state ) && ( m_strings[state - 1] == key ) ) {
+            return state - 1;
+        }
+
+        pos = ( pos + 1 ) & m_mask;
+    }
+
+    return npos;
+}
+
+// internals
+template<std::size_t string_size>
+typename intern_table<string_size>::key_type intern_table<string_size>::key_of( std::string_view sv ) {
+    if( sv.length() >= string_size ) {
+        throw std::length_error( "fl::intern_table: string too long to intern" );
+    }
+    return key_type( sv );
+}
+
+} // namespace fl
+
+
+#endif // FLINTERN_TABLE_HPP
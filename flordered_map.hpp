@@ -0,0 +1,917 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flordered_map.hpp
+    Author  :   Jamie Taylor
+    Desc    :   Ordered maps keyed on fl::string<N>, in operator< order.
+                - btree_map: a B+-tree; keys (zero-padded) and values live
+                  inline in small nodes, rather than one heap node per key
+                  as in std::map. Each node also keeps the first 8 bytes
+                  of every key as a big-endian integer, in its own cache
+                  lines, so the search within a node is an (AVX2) count
+                  of the prefixes less than the one being looked for; the
+                  keys themselves are only read to break ties.
+                - sorted_vector_map: the same prefixes, and the entries,
+                  in sorted arrays; for read-mostly data, where inserts
+                  and erases (which shift the arrays) are rare.
+                Both support range scans over the keys starting with a
+                given prefix, prefix_range(), as well as lower_bound() etc.
+
+===============================================================================
+*/
+#ifndef FLORDERED_MAP_HPP
+#define FLORDERED_MAP_HPP
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "flstring.hpp"
+#include "flsimd.hpp"
+
+namespace fl {
+namespace detail {
+
+// The first (up to) 8 characters of a zero-padded key, loaded big-endian. The
+// order of the prefixes never disagrees with the order of the keys, so most
+// comparisons in a search can be made on the prefixes alone; only keys with
+// equal prefixes need comparing in full.
+template<std::size_t key_size>
+inline std::uint64_t order_prefix( const char* p ) {
+    constexpr std::size_t characters = ( key_size-1 < 8 ) ? key_size-1 : 8;
+    char bytes[8] = {};
+    std::memcpy( bytes, p, characters );
+    return simd::detail::load_u64_big_endian( bytes );
+}
+
+// The smallest string that's greater than every string starting with prefix,
+// i.e. the end of prefix's range, written to successor; or 0 if there's no
+// such string (an empty prefix, or one of all 0xFF characters).
+inline std::size_t prefix_successor( std::string_view prefix, char* successor ) {
+    std::size_t length = prefix.length();
+    while( ( length != 0 ) && ( static_cast<unsigned char>( prefix[length-1] ) == 0xFF ) ) {
+        --length;
+    }
+    if( length != 0 ) {
+        std::memcpy( successor, prefix.data(), length );
+        successor[length-1] = static_cast<char>( static_cast<unsigned char>( successor[length-1] ) + 1 );
+    }
+    return length;
+}
+
+// [lower_bound( prefix ), lower_bound( successor )) of a map, or an empty range
+// if prefix is too long to be the start of a key.
+template<typename key_type, std::size_t key_size, typename map_type>
+inline auto prefix_range( map_type& map, std::string_view prefix ) {
+    using iterator = decltype( map.end() );
+    if( prefix.length() >= key_size ) {
+        return std::pair<iterator, iterator>( map.end(), map.end() );
+    }
+
+    char successor[key_size];
+    const std::size_t successor_length = prefix_successor( prefix, successor );
+    const iterator last = ( successor_length == 0 ) ? map.end() : map.lower_bound( key_type( std::string_view( successor, successor_length ) ) );
+    return std::pair<iterator, iterator>( map.lower_bound( key_type( prefix ) ), last );
+}
+
+} // namespace detail
+
+template<std::size_t key_size, typename mapped>
+class btree_map {
+public:
+
+                                // member types
+    using key_type              = string<key_size, zero_padding>;
+    using mapped_type           = mapped;
+    using value_type            = std::pair<const key_type, mapped_type>;
+    using size_type             = std::size_t;
+    using reference             = value_type&;
+    using const_reference       = const value_type&;
+
+                                template<bool is_const>
+    class                       basic_iterator;
+    using iterator              = basic_iterator<false>;
+    using const_iterator        = basic_iterator<true>;
+
+                                // keys per node; a node's prefixes fill two cache lines
+    static constexpr size_type  node_capacity = 16;
+
+                                // construction and assignment
+                                btree_map() noexcept = default;
+                                btree_map( const btree_map& other );
+                                btree_map( btree_map&& other ) noexcept;
+                                ~btree_map();
+
+    btree_map&                  operator=( const btree_map& other );
+    btree_map&                  operator=( btree_map&& other ) noexcept;
+
+                                // iterators
+    iterator                    begin() noexcept { return iterator( m_first, 0 ); }
+    const_iterator              begin() const noexcept { return const_iterator( m_first, 0 ); }
+    const_iterator              cbegin() const noexcept { return begin(); }
+    iterator                    end() noexcept { return iterator(); }
+    const_iterator              end() const noexcept { return const_iterator(); }
+    const_iterator              cend() const noexcept { return end(); }
+
+                                // capacity
+    bool                        empty() const noexcept { return m_size == 0; }
+    size_type                   size() const noexcept { return m_size; }
+
+                                // modifiers
+    void                        clear() noexcept;
+    std::pair<iterator, bool>   insert( const value_type& value ) { return try_emplace( value.first, value.second ); }
+                                template<typename... args>
+    std::pair<iterator, bool>   try_emplace( const key_type& key, args&&... values );
+    mapped_type&                operator[]( const key_type& key ) { return try_emplace( key ).first->second; }
+                                // nodes aren't merged when they become sparse, only freed once empty
+    size_type                   erase( const key_type& key );
+    iterator                    erase( const_iterator pos );
+    void                        swap( btree_map& other ) noexcept;
+
+                                // lookup
+    iterator                    find( const key_type& key );
+    const_iterator              find( const key_type& key ) const;
+    bool                        contains( const key_type& key ) const { return find( key ) != end(); }
+    iterator                    lower_bound( const key_type& key );
+    const_iterator              lower_bound( const key_type& key ) const;
+    iterator                    upper_bound( const key_type& key );
+    const_iterator              upper_bound( const key_type& key ) const;
+                                // the keys that start with prefix
+    std::pair<iterator, iterator> prefix_range( std::string_view prefix ) { return detail::prefix_range<key_type, key_size>( *this, prefix ); }
+    std::pair<const_iterator, const_iterator> prefix_range( std::string_view prefix ) const { return detail::prefix_range<key_type, key_size>( *this, prefix ); }
+
+private:
+    struct                      node;
+    struct                      leaf_node;
+    struct                      inner_node;
+
+                                // where a key went, and the new right sibling if a node was split
+    struct                      insert_result {
+                                    leaf_node* leaf;
+                                    size_type index;
+                                    bool inserted;
+                                    node* split;
+                                    key_type split_key;
+                                };
+                                // Inner nodes allocated up front for the splits an insert will cause, so that
+                                // none has to be allocated once the tree is being changed (linked through
+                                // children[0]; whatever isn't used is freed)
+    struct                      spare_nodes {
+                                    spare_nodes() = default;
+                                    spare_nodes( const spare_nodes& ) = delete;
+                                    spare_nodes& operator=( const spare_nodes& ) = delete;
+                                    ~spare_nodes();
+                                    inner_node* take() noexcept;
+
+                                    inner_node* first = nullptr;
+                                };
+
+                                template<typename node_type>
+    static size_type            lower_bound_in( const node_type& n, std::uint64_t prefix, const key_type& key ) noexcept;
+                                template<typename node_type>
+    static size_type            upper_bound_in( const node_type& n, std::uint64_t prefix, const key_type& key ) noexcept;
+    leaf_node*                  leaf_for( std::uint64_t prefix, const key_type& key ) const noexcept;
+                                // how many inner nodes inserting key would split off or add as a new root
+    size_type                   splits_for( std::uint64_t prefix, const key_type& key ) const noexcept;
+    iterator                    iterator_at( leaf_node* leaf, size_type index ) const noexcept;
+
+    insert_result               insert_into( node* n, std::uint64_t prefix, const key_type& key, value_type&& value, spare_nodes& spares );
+    insert_result               insert_into_leaf( leaf_node* leaf, std::uint64_t prefix, const key_type& key, value_type&& value );
+    void                        insert_child( inner_node* inner, size_type pos, const key_type& key, node* child );
+    bool                        erase_from( node* n, std::uint64_t prefix, const key_type& key, bool& erased );
+    void                        clone( const node* from, node*& to, leaf_node*& last );
+    void                        free_node( node* n ) noexcept;
+
+    node*                       m_root = nullptr;
+    leaf_node*                  m_first = nullptr;  // the leaves are linked, in order, for iteration
+    size_type                   m_size = 0;
+};
+
+// Nodes. Prefixes past count are all-ones, so that a node's prefixes can always
+// be searched as a whole (and never count as less than the key searched for).
+template<std::size_t key_size, typename mapped>
+struct btree_map<key_size, mapped>::node {
+    explicit                    node( bool is_leaf ) noexcept : leaf( is_leaf ) { std::fill( prefixes, prefixes + node_capacity, ~std::uint64_t( 0 ) ); }
+
+    alignas( 64 ) std::uint64_t prefixes[node_capacity];
+    size_type                   count = 0;
+    const bool                  leaf;
+};
+template<std::size_t key_size, typename mapped>
+struct btree_map<key_size, mapped>::leaf_node : node {
+                                leaf_node() noexcept : node( true ) {}
+
+    value_type*                 values() noexcept { return std::launder( reinterpret_cast<value_type*>( storage ) ); }
+    const key_type&             key( size_type pos ) const noexcept { return std::launder( reinterpret_cast<const value_type*>( storage ) )[pos].first; }
+
+    alignas( value_type ) unsigned char storage[node_capacity * sizeof( value_type )];
+    leaf_node*                  previous = nullptr;
+    leaf_node*                  next = nullptr;
+};
+template<std::size_t key_size, typename mapped>
+struct btree_map<key_size, mapped>::inner_node : node {
+                                inner_node() noexcept : node( false ) {}
+
+    const key_type&             key( size_type pos ) const noexcept { return keys[pos]; }
+
+                                // keys[i] is the smallest key under children[i+1]
+    key_type                    keys[node_capacity];
+    node*                       children[node_capacity + 1] = {};
+};
+
+// Forward iterator over the entries, in order, leaf by leaf.
+template<std::size_t key_size, typename mapped>
+template<bool is_const>
+class btree_map<key_size, mapped>::basic_iterator {
+public:
+    using iterator_category     = std::forward_iterator_tag;
+    using value_type            = typename btree_map::value_type;
+    using difference_type       = std::ptrdiff_t;
+    using pointer               = std::conditional_t<is_const, const value_type*, value_type*>;
+    using reference             = std::conditional_t<is_const, const value_type&, value_type&>;
+
+                                basic_iterator() noexcept = default;
+                                // iterator -> const_iterator
+                                template<bool other_is_const> requires ( is_const && !other_is_const )
+                                basic_iterator( const basic_iterator<other_is_const>& other ) noexcept :
+                                    m_leaf( other.m_leaf ), m_index( other.m_index ) {}
+
+    reference                   operator*() const noexcept { return m_leaf->values()[m_index]; }
+    pointer                     operator->() const noexcept { return m_leaf->values() + m_index; }
+    basic_iterator&             operator++() noexcept {
+                                    if( ++m_index == m_leaf->count ) {
+                                        m_leaf = m_leaf->next;
+                                        m_index = 0;
+                                    }
+                                    return *this;
+                                }
+    basic_iterator              operator++( int ) noexcept {
+                                    basic_iterator previous = *this;
+                                    ++( *this );
+                                    return previous;
+                                }
+
+    friend bool                 operator==( const basic_iterator& lhs, const basic_iterator& rhs ) noexcept {
+                                    return ( lhs.m_leaf == rhs.m_leaf ) && ( lhs.m_index == rhs.m_index );
+                                }
+
+private:
+    friend class btree_map;
+                                template<bool>
+    friend class                basic_iterator;
+
+                                // never (leaf, leaf->count); end() is (nullptr, 0)
+                                basic_iterator( leaf_node* leaf, size_type index ) noexcept :
+                                    m_leaf( leaf ), m_index( index ) {}
+
+    leaf_node*                  m_leaf = nullptr;
+    size_type                   m_index = 0;
+};
+
+// construction and assignment
+template<std::size_t key_size, typename mapped>
+btree_map<key_size, mapped>::btree_map( const btree_map& other ) {
+    if( other.m_root == nullptr ) {
+        return;
+    }
+
+    leaf_node* last = nullptr;
+    try {
+        clone( other.m_root, m_root, last );
+    } catch( ... ) {
+        clear();
+        throw;
+    }
+    m_size = other.m_size;
+}
+template<std::size_t key_size, typename mapped>
+btree_map<key_size, mapped>::btree_map( btree_map&& other ) noexcept {
+    swap( other );
+}
+template<std::size_t key_size, typename mapped>
+btree_map<key_size, mapped>::~btree_map() {
+    clear();
+}
+template<std::size_t key_size, typename mapped>
+btree_map<key_size, mapped>& btree_map<key_size, mapped>::operator=( const btree_map& other ) {
+    if( this != &other ) {
+        btree_map copy( other );
+        swap( copy );
+    }
+    return *this;
+}
+template<std::size_t key_size, typename mapped>
+btree_map<key_size, mapped>& btree_map<key_size, mapped>::operator=( btree_map&& other ) noexcept {
+    btree_map moved( std::move( other ) );
+    swap( moved );
+    return *this;
+}
+
+// modifiers
+template<std::size_t key_size, typename mapped>
+void btree_map<key_size, mapped>::clear() noexcept {
+    free_node( m_root );
+    m_root = nullptr;
+    m_first = nullptr;
+    m_size = 0;
+}
+template<std::size_t key_size, typename mapped>
+template<typename... args>
+std::pair<typename btree_map<key_size, mapped>::iterator, bool> btree_map<key_size, mapped>::try_emplace( const key_type& key, args&&... values ) {
+    const std::uint64_t prefix = detail::order_prefix<key_size>( key.data() );
+
+    // The nodes and the value are made before anything is moved, in case that throws
+    // (an empty tree's first leaf only becomes the root once the value is in it)
+    std::unique_ptr<leaf_node> first_leaf;
+    spare_nodes spares;
+    if( m_root != nullptr ) {
+        leaf_node* leaf = leaf_for( prefix, key );
+        const size_type pos = lower_bound_in( *leaf, prefix, key );
+        if( ( pos < leaf->count ) && ( leaf->key( pos ) == key ) ) {
+            return { iterator( leaf, pos ), false };
+        }
+        for( size_type i=splits_for( prefix, key ); i>0; --i ) {
+            inner_node* spare = new inner_node;
+            spare->children[0] = spares.first;
+            spares.first = spare;
+        }
+    } else {
+        first_leaf = std::make_unique<leaf_node>();
+    }
+    insert_result result = insert_into( first_leaf ? first_leaf.get() : m_root, prefix, key,
+        value_type( std::piecewise_construct, std::forward_as_tuple( key ), std::forward_as_tuple( std::forward<args>( values )... ) ), spares );
+    if( first_leaf ) {
+        m_root = m_first = first_leaf.release();
+    } else if( result.split != nullptr ) {
+        inner_node* root = spares.take();
+        root->children[0] = m_root;
+        root->children[1] = result.split;
+        root->keys[0] = result.split_key;
+        root->prefixes[0] = detail::order_prefix<key_size>( result.split_key.data() );
+        root->count = 1;
+        m_root = root;
+    }
+    ++m_size;
+
+    return { iterator( result.leaf, result.index ), true };
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::size_type btree_map<key_size, mapped>::erase( const key_type& key ) {
+    if( m_root == nullptr ) {
+        return 0;
+    }
+
+    bool erased = false;
+    if( erase_from( m_root, detail::order_prefix<key_size>( key.data() ), key, erased ) ) {
+        m_root = nullptr;
+    } else {
+        // drop roots left with a single child
+        while( !m_root->leaf && ( m_root->count == 0 ) ) {
+            inner_node* root = static_cast<inner_node*>( m_root );
+            m_root = root->children[0];
+            delete root;
+        }
+    }
+
+    if( erased ) {
+        --m_size;
+    }
+    return erased ? 1 : 0;
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::iterator btree_map<key_size, mapped>::erase( const_iterator pos ) {
+    // the entry after pos shifts down into its place, unless pos was the last
+    // in its leaf (which is freed if that leaves it empty)
+    leaf_node* leaf = pos.m_leaf;
+    const size_type index = pos.m_index;
+    const bool last_in_leaf = ( index + 1 == leaf->count );
+    leaf_node* next = leaf->next;
+
+    const key_type key = pos->first;
+    erase( key );
+
+    return last_in_leaf ? iterator( next, 0 ) : iterator( leaf, index );
+}
+template<std::size_t key_size, typename mapped>
+void btree_map<key_size, mapped>::swap( btree_map& other ) noexcept {
+    std::swap( m_root, other.m_root );
+    std::swap( m_first, other.m_first );
+    std::swap( m_size, other.m_size );
+}
+
+// lookup
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::iterator btree_map<key_size, mapped>::find( const key_type& key ) {
+    if( m_root == nullptr ) {
+        return end();
+    }
+
+    const std::uint64_t prefix = detail::order_prefix<key_size>( key.data() );
+    leaf_node* leaf = leaf_for( prefix, key );
+    const size_type pos = lower_bound_in( *leaf, prefix, key );
+    return ( ( pos < leaf->count ) && ( leaf->key( pos ) == key ) ) ? iterator( leaf, pos ) : end();
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::const_iterator btree_map<key_size, mapped>::find( const key_type& key ) const {
+    return const_cast<btree_map*>( this )->find( key );
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::iterator btree_map<key_size, mapped>::lower_bound( const key_type& key ) {
+    if( m_root == nullptr ) {
+        return end();
+    }
+
+    const std::uint64_t prefix = detail::order_prefix<key_size>( key.data() );
+    leaf_node* leaf = leaf_for( prefix, key );
+    return iterator_at( leaf, lower_bound_in( *leaf, prefix, key ) );
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::const_iterator btree_map<key_size, mapped>::lower_bound( const key_type& key ) const {
+    return const_cast<btree_map*>( this )->lower_bound( key );
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::iterator btree_map<key_size, mapped>::upper_bound( const key_type& key ) {
+    if( m_root == nullptr ) {
+        return end();
+    }
+
+    const std::uint64_t prefix = detail::order_prefix<key_size>( key.data() );
+    leaf_node* leaf = leaf_for( prefix, key );
+    return iterator_at( leaf, upper_bound_in( *leaf, prefix, key ) );
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::const_iterator btree_map<key_size, mapped>::upper_bound( const key_type& key ) const {
+    return const_cast<btree_map*>( this )->upper_bound( key );
+}
+
+// internals
+template<std::size_t key_size, typename mapped>
+template<typename node_type>
+typename btree_map<key_size, mapped>::size_type btree_map<key_size, mapped>::lower_bound_in( const node_type& n, std::uint64_t prefix, const key_type& key ) noexcept {
+    size_type pos = simd::count_less( n.prefixes, node_capacity, prefix );
+    while( ( pos < n.count ) && ( n.prefixes[pos] == prefix ) && ( n.key( pos ) < key ) ) {
+        ++pos;
+    }
+    return pos;
+}
+template<std::size_t key_size, typename mapped>
+template<typename node_type>
+typename btree_map<key_size, mapped>::size_type btree_map<key_size, mapped>::upper_bound_in( const node_type& n, std::uint64_t prefix, const key_type& key ) noexcept {
+    size_type pos = simd::count_less( n.prefixes, node_capacity, prefix );
+    while( ( pos < n.count ) && ( n.prefixes[pos] == prefix ) && !( key < n.key( pos ) ) ) {
+        ++pos;
+    }
+    return pos;
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::leaf_node* btree_map<key_size, mapped>::leaf_for( std::uint64_t prefix, const key_type& key ) const noexcept {
+    node* n = m_root;
+    while( !n->leaf ) {
+        const inner_node* inner = static_cast<const inner_node*>( n );
+        n = inner->children[upper_bound_in( *inner, prefix, key )];
+    }
+    return static_cast<leaf_node*>( n );
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::size_type btree_map<key_size, mapped>::splits_for( std::uint64_t prefix, const key_type& key ) const noexcept {
+    // A full leaf splits, and so does each full inner node above it, up to the first
+    // that isn't (or past the root, which then needs a new one above it)
+    size_type full_run = 0;
+    bool from_root = true;
+    node* n = m_root;
+    while( !n->leaf ) {
+        const inner_node* inner = static_cast<const inner_node*>( n );
+        if( inner->count == node_capacity ) {
+            ++full_run;
+        } else {
+            full_run = 0;
+            from_root = false;
+        }
+        n = inner->children[upper_bound_in( *inner, prefix, key )];
+    }
+    if( n->count < node_capacity ) {
+        return 0;
+    }
+    return full_run + ( from_root ? 1 : 0 );
+}
+template<std::size_t key_size, typename mapped>
+btree_map<key_size, mapped>::spare_nodes::~spare_nodes() {
+    while( first != nullptr ) {
+        delete take();
+    }
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::inner_node* btree_map<key_size, mapped>::spare_nodes::take() noexcept {
+    inner_node* spare = first;
+    first = static_cast<inner_node*>( spare->children[0] );
+    spare->children[0] = nullptr;
+    return spare;
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::iterator btree_map<key_size, mapped>::iterator_at( leaf_node* leaf, size_type index ) const noexcept {
+    // everything in the following leaves is greater than everything in this one
+    return ( index < leaf->count ) ? iterator( leaf, index ) : iterator( leaf->next, 0 );
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::insert_result btree_map<key_size, mapped>::insert_into( node* n, std::uint64_t prefix, const key_type& key, value_type&& value, spare_nodes& spares ) {
+    if( n->leaf ) {
+        return insert_into_leaf( static_cast<leaf_node*>( n ), prefix, key, std::move( value ) );
+    }
+
+    inner_node* inner = static_cast<inner_node*>( n );
+    const size_type child = upper_bound_in( *inner, prefix, key );
+    insert_result result = insert_into( inner->children[child], prefix, key, std::move( value ), spares );
+    if( result.split == nullptr ) {
+        return result;
+    }
+
+    if( inner->count < node_capacity ) {
+        insert_child( inner, child, result.split_key, result.split );
+        result.split = nullptr;
+        return result;
+    }
+
+    // Full: split around the middle key, which moves up (it's in neither half)
+    key_type keys[node_capacity + 1];
+    node* children[node_capacity + 2];
+    std::copy( inner->keys, inner->keys + child, keys );
+    keys[child] = result.split_key;
+    std::copy( inner->keys + child, inner->keys + node_capacity, keys + child+1 );
+    std::copy( inner->children, inner->children + child+1, children );
+    children[child+1] = result.split;
+    std::copy( inner->children + child+1, inner->children + node_capacity+1, children + child+2 );
+
+    const size_type middle = ( node_capacity + 1 ) / 2;
+    inner_node* right = spares.take();
+    std::fill( inner->prefixes, inner->prefixes + node_capacity, ~std::uint64_t( 0 ) );
+    for( size_type i=0; i<middle; ++i ) {
+        inner->keys[i] = keys[i];
+        inner->prefixes[i] = detail::order_prefix<key_size>( keys[i].data() );
+        inner->children[i] = children[i];
+    }
+    inner->children[middle] = children[middle];
+    inner->count = middle;
+    for( size_type i=middle+1; i<node_capacity+1; ++i ) {
+        right->keys[i - ( middle+1 )] = keys[i];
+        right->prefixes[i - ( middle+1 )] = detail::order_prefix<key_size>( keys[i].data() );
+        right->children[i - ( middle+1 )] = children[i];
+    }
+    right->children[node_capacity - middle] = children[node_capacity + 1];
+    right->count = node_capacity - middle;
+
+    result.split = right;
+    result.split_key = keys[middle];
+    return result;
+}
+template<std::size_t key_size, typename mapped>
+typename btree_map<key_size, mapped>::insert_result btree_map<key_size, mapped>::insert_into_leaf( leaf_node* leaf, std::uint64_t prefix, const key_type& key, value_type&& value ) {
+    size_type pos = lower_bound_in( *leaf, prefix, key );
+
+    // moves an entry, within or between leaves
+    const auto relocate = []( leaf_node* to, size_type to_pos, leaf_node* from, size_type from_pos ) {
+        std::construct_at( to->values() + to_pos, std::move( from->values()[from_pos] ) );
+        std::destroy_at( from->values() + from_pos );
+        to->prefixes[to_pos] = from->prefixes[from_pos];
+    };
+
+    insert_result result = { leaf, pos, true, nullptr, key_type() };
+    if( leaf->count == node_capacity ) {
+        // Full: the top half moves to a new leaf, linked in after this one
+        leaf_node* right = new leaf_node;
+        const size_type half = node_capacity / 2;
+        for( size_type i=half; i<node_capacity; ++i ) {
+            relocate( right, i - half, leaf, i );
+            leaf->prefixes[i] = ~std::uint64_t( 0 );
+        }
+        leaf->count = half;
+        right->count = node_capacity - half;
+        right->previous = leaf;
+        right->next = leaf->next;
+        if( leaf->next != nullptr ) {
+            leaf->next->previous = right;
+        }
+        leaf->next = right;
+
+        if( pos >= half ) {
+            pos -= half;
+            result.leaf = right;
+            result.index = pos;
+        }
+        result.split = right;
+    }
+
+    leaf_node* target = result.leaf;
+    for( size_type i=target->count; i>pos; --i ) {
+        relocate( target, i, target, i-1 );
+    }
+    std::construct_at( target->values() + pos, std::move( value ) );
+    target->prefixes[pos] = prefix;
+    ++target->count;
+
+    if( result.split != nullptr ) {
+        result.split_key = static_cast<leaf_node*>( result.split )->key( 0 );
+    }
+    return result;
+}
+template<std::size_t key_size, typename mapped>
+void btree_map<key_size, mapped>::insert_child( inner_node* inner, size_type pos, const key_type& key, node* child ) {
+    for( size_type i=inner->count; i>pos; --i ) {
+        inner->keys[i] = inner->keys[i-1];
+        inner->prefixes[i] = inner->prefixes[i-1];
+        inner->children[i+1] = inner->children[i];
+    }
+    inner->keys[pos] = key;
+    inner->prefixes[pos] = detail::order_prefix<key_size>( key.data() );
+    inner->children[pos+1] = child;
+    ++inner->count;
+}
+template<std::size_t key_size, typename mapped>
+bool btree_map<key_size, mapped>::erase_from( node* n, std::uint64_t prefix, const key_type& key, bool& erased ) {
+    if( n->leaf ) {
+        leaf_node* leaf = static_cast<leaf_node*>( n );
+        const size_type pos = lower_bound_in( *leaf, prefix, key );
+        if( ( pos == leaf->count ) || !( leaf->key( pos ) == key ) ) {
+            return false;
+        }
+
+        erased = true;
+        std::destroy_at( leaf->values() + pos );
+        for( size_type i=pos+1; i<leaf->count; ++i ) {
+            std::construct_at( leaf->values() + i-1, std::move( leaf->values()[i] ) );
+            std::destroy_at( leaf->values() + i );
+            leaf->prefixes[i-1] = leaf->prefixes[i];
+        }
+        leaf->prefixes[--leaf->count] = ~std::uint64_t( 0 );
+        if( leaf->count != 0 ) {
+            return false;
+        }
+
+        // Empty: unlink and free it
+        if( leaf->previous != nullptr ) {
+            leaf->previous->next = leaf->next;
+        } else {
+            m_first = leaf->next;
+        }
+        if( leaf->next != nullptr ) {
+            leaf->next->previous = leaf->previous;
+        }
+        delete leaf;
+        return true;
+    }
+
+    inner_node* inner = static_cast<inner_node*>( n );
+    const size_type child = upper_bound_in( *inner, prefix, key );
+    if( !erase_from( inner->children[child], prefix, key, erased ) ) {
+        return false;
+    }
+
+    // The child was freed. With it goes the separator to its left (or, for the
+    // first child, to its right; its keys were all below that anyway)
+    if( inner->count == 0 ) {
+        delete inner;
+        return true;
+    }
+    const size_type separator = ( child == 0 ) ? 0 : child-1;
+    for( size_type i=separator+1; i<inner->count; ++i ) {
+        inner->keys[i-1] = inner->keys[i];
+        inner->prefixes[i-1] = inner->prefixes[i];
+    }
+    for( size_type i=child+1; i<=inner->count; ++i ) {
+        inner->children[i-1] = inner->children[i];
+    }
+    inner->children[inner->count] = nullptr;
+    inner->prefixes[--inner->count] = ~std::uint64_t( 0 );
+    return false;
+}
+template<std::size_t key_size, typename mapped>
+void btree_map<key_size, mapped>::clone( const node* from, node*& to, leaf_node*& last ) {
+    if( from->leaf ) {
+        const leaf_node* from_leaf = static_cast<const leaf_node*>( from );
+        leaf_node* leaf = new leaf_node;
+        leaf->previous = last;
+        if( last != nullptr ) {
+            last->next = leaf;
+        } else {
+            m_first = leaf;
+        }
+        last = leaf;
+        to = leaf;
+
+        for( size_type i=0; i<from_leaf->count; ++i ) {
+            std::construct_at( leaf->values() + i, const_cast<leaf_node*>( from_leaf )->values()[i] );
+            leaf->prefixes[i] = from_leaf->prefixes[i];
+            ++leaf->count;
+        }
+        return;
+    }
+
+    const inner_node* from_inner = static_cast<const inner_node*>( from );
+    inner_node* inner = new inner_node;
+    std::copy( from_inner->keys, from_inner->keys + from_inner->count, inner->keys );
+    std::copy( from_inner->prefixes, from_inner->prefixes + from_inner->count, inner->prefixes );
+    inner->count = from_inner->count;
+    to = inner;
+    for( size_type i=0; i<=from_inner->count; ++i ) {
+        clone( from_inner->children[i], inner->children[i], last );
+    }
+}
+template<std::size_t key_size, typename mapped>
+void btree_map<key_size, mapped>::free_node( node* n ) noexcept {
+    if( n == nullptr ) {
+        return;
+    }
+
+    if( n->leaf ) {
+        leaf_node* leaf = static_cast<leaf_node*>( n );
+        std::destroy( leaf->values(), leaf->values() + leaf->count );
+        delete leaf;
+    } else {
+        // (a partly cloned node may have null children)
+        inner_node* inner = static_cast<inner_node*>( n );
+        for( size_type i=0; i<=inner->count; ++i ) {
+            free_node( inner->children[i] );
+        }
+        delete inner;
+    }
+}
+
+template<std::size_t key_size, typename mapped>
+class sorted_vector_map {
+public:
+
+                                // member types; keys mustn't be changed through iterators
+    using key_type              = string<key_size, zero_padding>;
+    using mapped_type           = mapped;
+    using value_type            = std::pair<key_type, mapped_type>;
+    using size_type             = std::size_t;
+    using reference             = value_type&;
+    using const_reference       = const value_type&;
+    using iterator              = typename std::vector<value_type>::iterator;
+    using const_iterator        = typename std::vector<value_type>::const_iterator;
+
+                                // construction; from unsorted entries (the first of any equal keys is kept)
+                                sorted_vector_map() noexcept = default;
+    explicit                    sorted_vector_map( std::vector<value_type> values );
+                                sorted_vector_map( std::initializer_list<value_type> values ) :
+                                    sorted_vector_map( std::vector<value_type>( values ) ) {}
+
+                                // iterators
+    iterator                    begin() noexcept { return m_values.begin(); }
+    const_iterator              begin() const noexcept { return m_values.begin(); }
+    const_iterator              cbegin() const noexcept { return begin(); }
+    iterator                    end() noexcept { return m_values.end(); }
+    const_iterator              end() const noexcept { return m_values.end(); }
+    const_iterator              cend() const noexcept { return end(); }
+
+                                // capacity
+    bool                        empty() const noexcept { return m_values.empty(); }
+    size_type                   size() const noexcept { return m_values.size(); }
+    void                        reserve( size_type count );
+
+                                // modifiers
+    void                        clear() noexcept;
+    std::pair<iterator, bool>   insert( const value_type& value ) { return try_emplace( value.first, value.second ); }
+                                template<typename... args>
+    std::pair<iterator, bool>   try_emplace( const key_type& key, args&&... values );
+    mapped_type&                operator[]( const key_type& key ) { return try_emplace( key ).first->second; }
+    size_type                   erase( const key_type& key );
+    iterator                    erase( const_iterator pos );
+    void                        swap( sorted_vector_map& other ) noexcept;
+
+                                // lookup
+    iterator                    find( const key_type& key );
+    const_iterator              find( const key_type& key ) const;
+    bool                        contains( const key_type& key ) const { return find( key ) != end(); }
+    iterator                    lower_bound( const key_type& key ) { return begin() + lower_bound_index( key ); }
+    const_iterator              lower_bound( const key_type& key ) const { return begin() + lower_bound_index( key ); }
+    iterator                    upper_bound( const key_type& key ) { return begin() + upper_bound_index( key ); }
+    const_iterator              upper_bound( const key_type& key ) const { return begin() + upper_bound_index( key ); }
+                                // the keys that start with prefix
+    std::pair<iterator, iterator> prefix_range( std::string_view prefix ) { return detail::prefix_range<key_type, key_size>( *this, prefix ); }
+    std::pair<const_iterator, const_iterator> prefix_range( std::string_view prefix ) const { return detail::prefix_range<key_type, key_size>( *this, prefix ); }
+
+private:
+                                // binary searches over the prefixes, then over just the keys that share key's prefix
+    size_type                   lower_bound_index( const key_type& key ) const;
+    size_type                   upper_bound_index( const key_type& key ) const;
+
+    std::vector<std::uint64_t>  m_prefixes;
+    std::vector<value_type>     m_values;
+};
+
+// construction
+template<std::size_t key_size, typename mapped>
+sorted_vector_map<key_size, mapped>::sorted_vector_map( std::vector<value_type> values ) :
+    m_values( std::move( values ) ) {
+    std::stable_sort( m_values.begin(), m_values.end(), []( const value_type& lhs, const value_type& rhs ) {
+        return lhs.first < rhs.first;
+    } );
+    m_values.erase( std::unique( m_values.begin(), m_values.end(), []( const value_type& lhs, const value_type& rhs ) {
+        return lhs.first == rhs.first;
+    } ), m_values.end() );
+
+    m_prefixes.resize( m_values.size() );
+    for( size_type i=0; i<m_values.size(); ++i ) {
+        m_prefixes[i] = detail::order_prefix<key_size>( m_values[i].first.data() );
+    }
+}
+
+// capacity
+template<std::size_t key_size, typename mapped>
+void sorted_vector_map<key_size, mapped>::reserve( size_type count ) {
+    m_prefixes.reserve( count );
+    m_values.reserve( count );
+}
+
+// modifiers
+template<std::size_t key_size, typename mapped>
+void sorted_vector_map<key_size, mapped>::clear() noexcept {
+    m_prefixes.clear();
+    m_values.clear();
+}
+template<std::size_t key_size, typename mapped>
+template<typename... args>
+std::pair<typename sorted_vector_map<key_size, mapped>::iterator, bool> sorted_vector_map<key_size, mapped>::try_emplace( const key_type& key, args&&... values ) {
+    const size_type pos = lower_bound_index( key );
+    if( ( pos < m_values.size() ) && ( m_values[pos].first == key ) ) {
+        return { begin() + pos, false };
+    }
+
+    // with room for the prefix reserved first, the second insert can't throw (growing
+    // geometrically, as the insert itself would: reserve() allocates just what it's asked for)
+    if( m_prefixes.size() == m_prefixes.capacity() ) {
+        m_prefixes.reserve( std::max<size_type>( 2 * m_prefixes.capacity(), 8 ) );
+    }
+    const iterator it = m_values.emplace( begin() + pos, std::piecewise_construct, std::forward_as_tuple( key ), std::forward_as_tuple( std::forward<args>( values )... ) );
+    m_prefixes.insert( m_prefixes.begin() + pos, detail::order_prefix<key_size>( key.data() ) );
+    return { it, true };
+}
+template<std::size_t key_size, typename mapped>
+typename sorted_vector_map<key_size, mapped>::size_type sorted_vector_map<key_size, mapped>::erase( const key_type& key ) {
+    const iterator it = find( key );
+    if( it == end() ) {
+        return 0;
+    }
+    erase( it );
+    return 1;
+}
+template<std::size_t key_size, typename mapped>
+typename sorted_vector_map<key_size, mapped>::iterator sorted_vector_map<key_size, mapped>::erase( const_iterator pos ) {
+    const size_type index = static_cast<size_type>( pos - m_values.cbegin() );
+    m_prefixes.erase( m_prefixes.begin() + index );
+    return m_values.erase( pos );
+}
+template<std::size_t key_size, typename mapped>
+void sorted_vector_map<key_size, mapped>::swap( sorted_vector_map& other ) noexcept {
+    m_prefixes.swap( other.m_prefixes );
+    m_values.swap( other.m_values );
+}
+
+// lookup
+template<std::size_t key_size, typename mapped>
+typename sorted_vector_map<key_size, mapped>::iterator sorted_vector_map<key_size, mapped>::find( const key_type& key ) {
+    const size_type pos = lower_bound_index( key );
+    return ( ( pos < m_values.size() ) && ( m_values[pos].first == key ) ) ? begin() + pos : end();
+}
+template<std::size_t key_size, typename mapped>
+typename sorted_vector_map<key_size, mapped>::const_iterator sorted_vector_map<key_size, mapped>::find( const key_type& key ) const {
+    return const_cast<sorted_vector_map*>( this )->find( key );
+}
+
+// internals
+template<std::size_t key_size, typename mapped>
+typename sorted_vector_map<key_size, mapped>::size_type sorted_vector_map<key_size, mapped>::lower_bound_index( const key_type& key ) const {
+    const auto equal = std::equal_range( m_prefixes.begin(), m_prefixes.end(), detail::order_prefix<key_size>( key.data() ) );
+    const auto first = m_values.begin() + ( equal.first - m_prefixes.begin() );
+    const auto last = m_values.begin() + ( equal.second - m_prefixes.begin() );
+    return static_cast<size_type>( std::partition_point( first, last, [&]( const value_type& value ) {
+        return value.first < key;
+    } ) - m_values.begin() );
+}
+template<std::size_t key_size, typename mapped>
+typename sorted_vector_map<key_size, mapped>::size_type sorted_vector_map<key_size, mapped>::upper_bound_index( const key_type& key ) const {
+    const auto equal = std::equal_range( m_prefixes.begin(), m_prefixes.end(), detail::order_prefix<key_size>( key.data() ) );
+    const auto first = m_values.begin() + ( equal.first - m_prefixes.begin() );
+    const auto last = m_values.begin() + ( equal.second - m_prefixes.begin() );
+    return static_cast<size_type>( std::partition_point( first, last, [&]( const value_type& value ) {
+        return !( key < value.first );
+    } ) - m_values.begin() );
+}
+
+} // namespace fl
+
+
+#endif // FLORDERED_MAP_HPP
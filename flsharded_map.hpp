@@ -0,0 +1,283 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flsharded_map.hpp
+    Author  :   Jamie Taylor
+    Desc    :   A concurrent hash map keyed on fl::string<N>, split into
+                2^shard_bits independent shards, each an fl::flat_map
+                behind its own reader-writer lock. A key's shard is picked
+                from the top bits of its hash (fl::flat_map places keys
+                with the low bits, so the two don't interfere), and each
+                shard header (lock and map) is padded out to whole cache
+                lines, so that threads working on different shards never
+                share a line.
+                insert_many() and find_many() hash a batch of keys up
+                front, group them by shard, and then take each shard's
+                lock once for its whole group rather than once per key,
+                handing the shard's fl::flat_map the hashes already taken;
+                they work through batch_limit keys at a time, in buffers on
+                the stack, so that a batch never touches the heap itself.
+                Lookups copy the value out, since a reference into a
+                shard would outlive its lock.
+
+===============================================================================
+*/
+#ifndef FLSHARDED_MAP_HPP
+#define FLSHARDED_MAP_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+#include "flstring.hpp"
+#include "flflat_map.hpp"
+
+namespace fl {
+
+template<std::size_t key_size, typename mapped, unsigned int shard_bits = 6>
+class sharded_map {
+    static_assert( shard_bits > 0 && shard_bits <= 10, "fl::sharded_map needs between 2 and 1024 shards" );
+
+public:
+
+                                // member types
+    using key_type              = string<key_size, zero_padding>;
+    using mapped_type           = mapped;
+    using size_type             = std::size_t;
+
+    static constexpr size_type  shard_count = size_type( 1 ) << shard_bits;
+    static constexpr size_type  cache_line_size = 64;
+                                // the most keys insert_many() and find_many() group at once (larger
+                                // batches are taken this many at a time)
+    static constexpr size_type  batch_limit = 256;
+
+                                // construction and assignment
+                                sharded_map() = default;
+                                sharded_map( const sharded_map& ) = delete;
+    sharded_map&                operator=( const sharded_map& ) = delete;
+
+                                // capacity (a snapshot, taking each shard's lock in turn)
+    bool                        empty() const;
+    size_type                   size() const;
+                                // room for count keys in all, spread evenly over the shards
+    void                        reserve( size_type count );
+
+                                // modifiers; true if the key was inserted (or erased)
+                                template<typename... args>
+    bool                        try_emplace( const key_type& key, args&&... values );
+    bool                        insert_or_assign( const key_type& key, const mapped_type& value );
+    bool                        erase( const key_type& key );
+    void                        clear();
+                                // try_emplace( keys[i], values[i] ) for each i; returns the number inserted
+    size_type                   insert_many( const key_type* keys, const mapped_type* values, size_type count );
+
+                                // lookup
+    std::optional<mapped_type>  find( const key_type& key ) const;
+    bool                        contains( const key_type& key ) const;
+                                // values[i] = the value of keys[i], and found[i] = whether it was there
+                                // (values[i] is left alone if not); returns the number found
+    size_type                   find_many( const key_type* keys, size_type count, mapped_type* values, bool* found ) const;
+                                // call f( mapped_type& ) on the key's value under the shard's write lock;
+                                // false (and f not called) if the key isn't there
+                                template<typename function>
+    bool                        update( const key_type& key, function f );
+
+private:
+    using map_type              = flat_map<key_size, mapped>;
+
+    struct alignas( cache_line_size ) shard {
+        mutable std::shared_mutex mutex;
+        map_type                map;
+    };
+    static_assert( sizeof( shard ) % cache_line_size == 0 );
+
+    static size_type            shard_of( std::uint64_t hash ) noexcept { return static_cast<size_type>( hash >> ( 64 - shard_bits ) ); }
+    static size_type            shard_of( const key_type& key ) noexcept { return shard_of( static_cast<std::uint64_t>( hash_value( key ) ) ); }
+    using batch_hashes          = std::array<std::uint64_t, batch_limit>;
+    using batch_order           = std::array<size_type, batch_limit>;
+    using batch_bounds          = std::array<size_type, shard_count + 1>;
+                                // hashes[i] = the hash of keys[i], and order[first[s], first[s+1]) = the indices
+                                // of the keys in shard s (count <= batch_limit)
+    static void                 group_by_shard( const key_type* keys, size_type count, batch_hashes& hashes, batch_order& order,
+                                                batch_bounds& first );
+
+    std::array<shard, shard_count> m_shards;
+};
+
+// capacity
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+bool sharded_map<key_size, mapped, shard_bits>::empty() const {
+    for( const shard& s : m_shards ) {
+        const std::shared_lock lock( s.mutex );
+        if( !s.map.empty() ) {
+            return false;
+        }
+    }
+    return true;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+typename sharded_map<key_size, mapped, shard_bits>::size_type sharded_map<key_size, mapped, shard_bits>::size() const {
+    size_type size = 0;
+    for( const shard& s : m_shards ) {
+        const std::shared_lock lock( s.mutex );
+        size += s.map.size();
+    }
+    return size;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+void sharded_map<key_size, mapped, shard_bits>::reserve( size_type count ) {
+    // a little over an even share, as the keys won't split exactly evenly
+    const size_type per_shard = count/shard_count + count/( shard_count*8 ) + 1;
+    for( shard& s : m_shards ) {
+        const std::unique_lock lock( s.mutex );
+        s.map.reserve( per_shard );
+    }
+}
+
+// modifiers
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+template<typename... args>
+bool sharded_map<key_size, mapped, shard_bits>::try_emplace( const key_type& key, args&&... values ) {
+    shard& s = m_shards[shard_of( key )];
+    const std::unique_lock lock( s.mutex );
+    return s.map.try_emplace( key, std::forward<args>( values )... ).second;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+bool sharded_map<key_size, mapped, shard_bits>::insert_or_assign( const key_type& key, const mapped_type& value ) {
+    shard& s = m_shards[shard_of( key )];
+    const std::unique_lock lock( s.mutex );
+    const auto [it, inserted] = s.map.try_emplace( key, value );
+    if( !inserted ) {
+        it->second = value;
+    }
+    return inserted;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+bool sharded_map<key_size, mapped, shard_bits>::erase( const key_type& key ) {
+    shard& s = m_shards[shard_of( key )];
+    const std::unique_lock lock( s.mutex );
+    return s.map.erase( key ) != 0;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+void sharded_map<key_size, mapped, shard_bits>::clear() {
+    for( shard& s : m_shards ) {
+        const std::unique_lock lock( s.mutex );
+        s.map.clear();
+    }
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+typename sharded_map<key_size, mapped, shard_bits>::size_type sharded_map<key_size, mapped, shard_bits>::insert_many( const key_type* keys, const mapped_type* values, size_type count ) {
+    size_type inserted = 0;
+    for( size_type done=0; done<count; done+=batch_limit ) {
+        batch_hashes hashes;
+        batch_order order;
+        batch_bounds first;
+        group_by_shard( keys + done, std::min( count - done, batch_limit ), hashes, order, first );
+
+        for( size_type shard_index=0; shard_index<shard_count; ++shard_index ) {
+            if( first[shard_index] == first[shard_index + 1] ) {
+                continue;
+            }
+            shard& s = m_shards[shard_index];
+            const std::unique_lock lock( s.mutex );
+            for( size_type i=first[shard_index]; i<first[shard_index + 1]; ++i ) {
+                const size_type index = done + order[i];
+                inserted += s.map.try_emplace_hashed( keys[index], static_cast<size_type>( hashes[order[i]] ), values[index] ).second;
+            }
+        }
+    }
+    return inserted;
+}
+
+// lookup
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+std::optional<mapped> sharded_map<key_size, mapped, shard_bits>::find( const key_type& key ) const {
+    const shard& s = m_shards[shard_of( key )];
+    const std::shared_lock lock( s.mutex );
+    const auto it = s.map.find( key );
+    if( it == s.map.end() ) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+bool sharded_map<key_size, mapped, shard_bits>::contains( const key_type& key ) const {
+    const shard& s = m_shards[shard_of( key )];
+    const std::shared_lock lock( s.mutex );
+    return s.map.contains( key );
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+typename sharded_map<key_size, mapped, shard_bits>::size_type sharded_map<key_size, mapped, shard_bits>::find_many( const key_type* keys, size_type count, mapped_type* values, bool* found ) const {
+    size_type found_count = 0;
+    for( size_type done=0; done<count; done+=batch_limit ) {
+        batch_hashes hashes;
+        batch_order order;
+        batch_bounds first;
+        group_by_shard( keys + done, std::min( count - done, batch_limit ), hashes, order, first );
+
+        for( size_type shard_index=0; shard_index<shard_count; ++shard_index ) {
+            if( first[shard_index] == first[shard_index + 1] ) {
+                continue;
+            }
+            const shard& s = m_shards[shard_index];
+            const std::shared_lock lock( s.mutex );
+            for( size_type i=first[shard_index]; i<first[shard_index + 1]; ++i ) {
+                const size_type index = done + order[i];
+                const auto it = s.map.find_hashed( keys[index], static_cast<size_type>( hashes[order[i]] ) );
+                found[index] = ( it != s.map.end() );
+                if( found[index] ) {
+                    values[index] = it->second;
+                    ++found_count;
+                }
+            }
+        }
+    }
+    return found_count;
+}
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+template<typename function>
+bool sharded_map<key_size, mapped, shard_bits>::update( const key_type& key, function f ) {
+    shard& s = m_shards[shard_of( key )];
+    const std::unique_lock lock( s.mutex );
+    const auto it = s.map.find( key );
+    if( it == s.map.end() ) {
+        return false;
+    }
+    f( it->second );
+    return true;
+}
+
+// internals
+template<std::size_t key_size, typename mapped, unsigned int shard_bits>
+void sharded_map<key_size, mapped, shard_bits>::group_by_shard( const key_type* keys, size_type count, batch_hashes& hashes, batch_order& order,
+                                                                batch_bounds& first ) {
+    // a counting sort on the shard index, which keeps each shard's keys in batch order
+    hash_batch( keys, count, hashes.data() );
+
+    first.fill( 0 );
+    for( size_type i=0; i<count; ++i ) {
+        ++first[shard_of( hashes[i] ) + 1];
+    }
+    for( size_type shard_index=0; shard_index<shard_count; ++shard_index ) {
+        first[shard_index + 1] += first[shard_index];
+    }
+
+    std::array<size_type, shard_count> next;
+    std::copy( first.begin(), first.end() - 1, next.begin() );
+    for( size_type i=0; i<count; ++i ) {
+        order[next[shard_of( hashes[i] )]++] = i;
+    }
+}
+
+} // namespace fl
+
+
+#endif // FLSHARDED_MAP_HPP
@@ -0,0 +1,779 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flsimd.hpp
+    Author  :   Jamie Taylor
+    Desc    :   SIMD search kernels used by fl::string.
+                AVX2 (32 bytes per step) when the target supports it,
+                SSE2 (16 bytes per step) as the x86-64 baseline and a
+                plain scalar loop everywhere else. Character-set lookups
+                use a nibble-LUT shuffle (AVX2/SSSE3) and fall back to a
+                256-bit bitmap. Also the 16-wide control-byte
+                matching for fl::flat_map, the many-strings-at-once
+                matching used by the batch selections (flbatch.hpp), and
+                the in-node key search of fl::btree_map.
+
+===============================================================================
+*/
+#ifndef FLSIMD_HPP
+#define FLSIMD_HPP
+
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSSE3__)
+    #include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+
+namespace fl {
+namespace simd {
+
+inline constexpr std::size_t npos = static_cast<std::size_t>( -1 );
+
+namespace detail {
+
+inline unsigned int count_trailing_zeros( unsigned int mask ) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return static_cast<unsigned int>( index );
+#else
+    return static_cast<unsigned int>( __builtin_ctz( mask ) );
+#endif
+}
+
+inline unsigned int highest_set_bit( unsigned int mask ) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse( &index, mask );
+    return static_cast<unsigned int>( index );
+#else
+    return static_cast<unsigned int>( 31 - __builtin_clz( mask ) );
+#endif
+}
+
+// Unaligned load of a whole word in native byte order. At compile-time (where
+// memcpy() isn't available) the word is assembled byte-by-byte, giving the
+// same value.
+template<typename word_type>
+constexpr word_type load_word( const char* p ) {
+    if( std::is_constant_evaluated() ) {
+        word_type word = 0;
+        for( std::size_t i=0; i<sizeof( word_type ); ++i ) {
+            const std::size_t byte = ( std::endian::native == std::endian::little ) ? i : sizeof( word_type )-1 - i;
+            word |= static_cast<word_type>( static_cast<unsigned char>( p[i] ) ) << ( 8 * byte );
+        }
+        return word;
+    }
+
+    word_type word;
+    std::memcpy( &word, p, sizeof( word ) );
+    return word;
+}
+constexpr std::uint64_t load_u64( const char* p ) {
+    return load_word<std::uint64_t>( p );
+}
+constexpr std::uint32_t load_u32( const char* p ) {
+    return load_word<std::uint32_t>( p );
+}
+
+constexpr std::uint64_t byteswap( std::uint64_t value ) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    value = ( ( value & 0x00FF00FF00FF00FFULL ) << 8 ) | ( ( value >> 8 ) & 0x00FF00FF00FF00FFULL );
+    value = ( ( value & 0x0000FFFF0000FFFFULL ) << 16 ) | ( ( value >> 16 ) & 0x0000FFFF0000FFFFULL );
+    return ( value << 32 ) | ( value >> 32 );
+#else
+    return __builtin_bswap64( value );
+#endif
+}
+constexpr std::uint32_t byteswap( std::uint32_t value ) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    value = ( ( value & 0x00FF00FFU ) << 8 ) | ( ( value >> 8 ) & 0x00FF00FFU );
+    return ( value << 16 ) | ( value >> 16 );
+#else
+    return __builtin_bswap32( value );
+#endif
+}
+
+// load so that integer order matches byte (memcmp) order
+constexpr std::uint64_t load_u64_big_endian( const char* p ) {
+    if constexpr( std::endian::native == std::endian::big ) {
+        return load_u64( p );
+    } else {
+        return byteswap( load_u64( p ) );
+    }
+}
+constexpr std::uint32_t load_u32_big_endian( const char* p ) {
+    if constexpr( std::endian::native == std::endian::big ) {
+        return load_u32( p );
+    } else {
+        return byteswap( load_u32( p ) );
+    }
+}
+
+// only the low 'count' bits of a block's mask refer to valid positions
+inline unsigned int low_bits( unsigned int mask, std::size_t count, std::size_t width ) {
+    if( count < width ) {
+        mask &= ( 1u << count ) - 1;
+    }
+    return mask;
+}
+
+// check each candidate position flagged in mask (first and last needle bytes
+// already matched), returning the first full match or npos.
+inline std::size_t verify_candidates( unsigned int mask, const char* haystack, std::size_t offset,
+                                      const char* needle, std::size_t needle_length ) {
+    // the first and last bytes are known to match, only the middle is left
+    const std::size_t middle_length = needle_length < 2 ? 0 : needle_length-2;
+
+    while( mask ) {
+        const std::size_t index = offset + count_trailing_zeros( mask );
+        if( std::memcmp( haystack + index + 1, needle + 1, middle_length ) == 0 ) {
+            return index;
+        }
+        mask &= mask - 1;
+    }
+
+    return npos;
+}
+
+// keep only the candidate bits for start positions <= last_start
+inline unsigned int mask_candidates( unsigned int mask, std::size_t offset, std::size_t last_start, std::size_t width ) {
+    const std::size_t remaining = last_start - offset + 1;
+    if( remaining < width ) {
+        mask &= ( 1u << remaining ) - 1;
+    }
+    return mask;
+}
+
+} // namespace detail
+
+namespace detail {
+
+// The vectorised part of find(): returns the first match within whole blocks,
+// or npos with i advanced to the first position not yet covered.
+inline std::size_t find_blocks( const char* haystack, std::size_t readable, std::size_t last_start,
+                                const char* needle, std::size_t needle_length, std::size_t& i ) {
+#if defined(__AVX2__)
+    {
+        const __m256i first = _mm256_set1_epi8( needle[0] );
+        const __m256i last = _mm256_set1_epi8( needle[needle_length-1] );
+
+        for( ; ( readable >= 32 ) && ( i <= last_start ) && ( i + needle_length-1 <= readable-32 ); i += 32 ) {
+            const __m256i block_first = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( haystack + i ) );
+            const __m256i block_last = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( haystack + i + needle_length-1 ) );
+            const __m256i matches = _mm256_and_si256( _mm256_cmpeq_epi8( first, block_first ),
+                                                      _mm256_cmpeq_epi8( last, block_last ) );
+
+            unsigned int mask = static_cast<unsigned int>( _mm256_movemask_epi8( matches ) );
+            mask = mask_candidates( mask, i, last_start, 32 );
+
+            const std::size_t index = verify_candidates( mask, haystack, i, needle, needle_length );
+            if( index != npos ) {
+                return index;
+            }
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128i first = _mm_set1_epi8( needle[0] );
+        const __m128i last = _mm_set1_epi8( needle[needle_length-1] );
+
+        for( ; ( readable >= 16 ) && ( i <= last_start ) && ( i + needle_length-1 <= readable-16 ); i += 16 ) {
+            const __m128i block_first = _mm_loadu_si128( reinterpret_cast<const __m128i*>( haystack + i ) );
+            const __m128i block_last = _mm_loadu_si128( reinterpret_cast<const __m128i*>( haystack + i + needle_length-1 ) );
+            const __m128i matches = _mm_and_si128( _mm_cmpeq_epi8( first, block_first ),
+                                                   _mm_cmpeq_epi8( last, block_last ) );
+
+            unsigned int mask = static_cast<unsigned int>( _mm_movemask_epi8( matches ) );
+            mask = mask_candidates( mask, i, last_start, 16 );
+
+            const std::size_t index = verify_candidates( mask, haystack, i, needle, needle_length );
+            if( index != npos ) {
+                return index;
+            }
+        }
+    }
+#else
+    (void)haystack; (void)readable; (void)last_start; (void)needle; (void)needle_length; (void)i;
+#endif
+
+    return npos;
+}
+
+} // namespace detail
+
+// Find needle[0, needle_length) in haystack[0, length), starting at pos.
+//
+// 'readable' is the number of bytes from haystack which can safely be loaded
+// (i.e. the size of the owning buffer, >= length). Whole blocks are loaded up
+// to that bound and any candidates past length are masked off, which lets a
+// fixed-length string search its unused tail-space without a scalar epilogue.
+//
+// The first and last bytes of the needle are broadcast and compared against
+// two overlapping blocks of the haystack; only positions where both match are
+// verified with memcmp(). Constant evaluation only takes the scalar loop.
+constexpr std::size_t find( const char* haystack, std::size_t length, std::size_t readable,
+                            const char* needle, std::size_t needle_length, std::size_t pos ) {
+    if( pos > length ) {
+        return npos;
+    }
+    if( needle_length == 0 ) {
+        return pos;
+    }
+    if( needle_length > length - pos ) {
+        return npos;
+    }
+
+    const std::size_t last_start = length - needle_length;
+    std::size_t i = pos;
+
+    if( !std::is_constant_evaluated() ) {
+        const std::size_t index = detail::find_blocks( haystack, readable, last_start, needle, needle_length, i );
+        if( index != npos ) {
+            return index;
+        }
+    }
+
+    // whatever couldn't be covered by a full block
+    for( ; i <= last_start; ++i ) {
+        if( ( haystack[i] == needle[0] ) &&
+            ( std::char_traits<char>::compare( haystack + i + 1, needle + 1, needle_length-1 ) == 0 ) ) {
+            return i;
+        }
+    }
+
+    return npos;
+}
+
+// Matches a single character.
+class char_matcher {
+public:
+    explicit                    char_matcher( char c ) :
+                                    m_char( c )
+#if defined(__AVX2__)
+                                    , m_char32( _mm256_set1_epi8( c ) )
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+                                    , m_char16( _mm_set1_epi8( c ) )
+#endif
+                                {}
+
+    bool                        contains( char c ) const { return c == m_char; }
+#if defined(__AVX2__)
+    unsigned int                match32( const char* p ) const {
+                                    const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+                                    return static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, m_char32 ) ) );
+                                }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    unsigned int                match16( const char* p ) const {
+                                    const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                                    return static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, m_char16 ) ) );
+                                }
+#endif
+
+private:
+    char                        m_char;
+#if defined(__AVX2__)
+    __m256i                     m_char32;
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128i                     m_char16;
+#endif
+};
+
+// Matches any character from a set, built once per search.
+//
+// Scalar lookups use a 256-bit bitmap. The vector paths split each byte into
+// nibbles: the low nibble selects a row from one of two 16-entry tables (one
+// for high nibbles 0-7, one for 8-15) and the high nibble selects the bit in
+// that row, so a set of any size costs the same three shuffles per block.
+class char_set {
+public:
+                                char_set( const char* s, std::size_t n ) {
+                                    std::memset( m_bitmap, 0, sizeof( m_bitmap ) );
+                                    unsigned char rows_low[16] = {};
+                                    unsigned char rows_high[16] = {};
+
+                                    for( std::size_t i=0; i<n; ++i ) {
+                                        const unsigned char c = static_cast<unsigned char>( s[i] );
+                                        m_bitmap[c >> 6] |= std::uint64_t( 1 ) << ( c & 63 );
+                                        if( c < 0x80 ) {
+                                            rows_low[c & 0x0F] |= static_cast<unsigned char>( 1u << ( c >> 4 ) );
+                                        } else {
+                                            rows_high[c & 0x0F] |= static_cast<unsigned char>( 1u << ( ( c >> 4 ) - 8 ) );
+                                        }
+                                    }
+#if defined(__AVX2__)
+                                    const __m128i low = _mm_loadu_si128( reinterpret_cast<const __m128i*>( rows_low ) );
+                                    const __m128i high = _mm_loadu_si128( reinterpret_cast<const __m128i*>( rows_high ) );
+                                    m_rows_low32 = _mm256_broadcastsi128_si256( low );
+                                    m_rows_high32 = _mm256_broadcastsi128_si256( high );
+#endif
+#if defined(__SSSE3__)
+                                    m_rows_low16 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( rows_low ) );
+                                    m_rows_high16 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( rows_high ) );
+#endif
+                                }
+
+    bool                        contains( char c ) const {
+                                    const unsigned char uc = static_cast<unsigned char>( c );
+                                    return ( m_bitmap[uc >> 6] >> ( uc & 63 ) ) & 1;
+                                }
+#if defined(__AVX2__)
+    unsigned int                match32( const char* p ) const {
+                                    const __m256i bits = _mm256_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                                                           1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+                                    const __m256i nibble = _mm256_set1_epi8( 0x0F );
+
+                                    const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+                                    const __m256i low = _mm256_and_si256( block, nibble );
+                                    const __m256i high = _mm256_and_si256( _mm256_srli_epi16( block, 4 ), nibble );
+
+                                    const __m256i rows = _mm256_blendv_epi8( _mm256_shuffle_epi8( m_rows_low32, low ),
+                                                                             _mm256_shuffle_epi8( m_rows_high32, low ),
+                                                                             _mm256_cmpgt_epi8( high, _mm256_set1_epi8( 7 ) ) );
+                                    const __m256i bit = _mm256_shuffle_epi8( bits, high );
+
+                                    return static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_and_si256( rows, bit ), bit ) ) );
+                                }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    unsigned int                match16( const char* p ) const {
+#if defined(__SSSE3__)
+                                    const __m128i bits = _mm_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+                                    const __m128i nibble = _mm_set1_epi8( 0x0F );
+
+                                    const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                                    const __m128i low = _mm_and_si128( block, nibble );
+                                    const __m128i high = _mm_and_si128( _mm_srli_epi16( block, 4 ), nibble );
+
+                                    const __m128i use_high = _mm_cmpgt_epi8( high, _mm_set1_epi8( 7 ) );
+                                    const __m128i rows = _mm_or_si128( _mm_andnot_si128( use_high, _mm_shuffle_epi8( m_rows_low16, low ) ),
+                                                                       _mm_and_si128( use_high, _mm_shuffle_epi8( m_rows_high16, low ) ) );
+                                    const __m128i bit = _mm_shuffle_epi8( bits, high );
+
+                                    return static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_and_si128( rows, bit ), bit ) ) );
+#else
+                                    // no byte shuffle on plain SSE2, use the bitmap
+                                    unsigned int mask = 0;
+                                    for( unsigned int i=0; i<16; ++i ) {
+                                        mask |= static_cast<unsigned int>( contains( p[i] ) ) << i;
+                                    }
+                                    return mask;
+#endif
+                                }
+#endif
+
+private:
+    std::uint64_t               m_bitmap[4];
+#if defined(__AVX2__)
+    __m256i                     m_rows_low32;
+    __m256i                     m_rows_high32;
+#endif
+#if defined(__SSSE3__)
+    __m128i                     m_rows_low16;
+    __m128i                     m_rows_high16;
+#endif
+};
+
+// First position in [pos, length) which matches (or, when negate is set,
+// doesn't match) the matcher. As with find(), whole blocks are loaded up to
+// 'readable' and the results masked off at length.
+template<typename matcher>
+inline std::size_t find_first( const char* haystack, std::size_t length, std::size_t readable,
+                               const matcher& m, std::size_t pos, bool negate ) {
+    std::size_t i = pos;
+
+#if defined(__AVX2__)
+    for( ; ( readable >= 32 ) && ( i < length ) && ( i <= readable-32 ); i += 32 ) {
+        unsigned int mask = m.match32( haystack + i );
+        mask = negate ? ~mask : mask;
+        mask = detail::low_bits( mask, length - i, 32 );
+        if( mask ) {
+            return i + detail::count_trailing_zeros( mask );
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    for( ; ( readable >= 16 ) && ( i < length ) && ( i <= readable-16 ); i += 16 ) {
+        unsigned int mask = m.match16( haystack + i );
+        mask = negate ? ~mask & 0xFFFF : mask;
+        mask = detail::low_bits( mask, length - i, 16 );
+        if( mask ) {
+            return i + detail::count_trailing_zeros( mask );
+        }
+    }
+#endif
+
+    for( ; i < length; ++i ) {
+        if( m.contains( haystack[i] ) != negate ) {
+            return i;
+        }
+    }
+
+    return npos;
+}
+
+// Last position in [0, min(pos, length-1)] which matches (or doesn't match).
+// Blocks are loaded back-to-front, ending at the current position (the
+// readable checks are redundant, end <= length, but let fixed-size callers
+// drop loops for blocks which could never fit).
+template<typename matcher>
+inline std::size_t find_last( const char* haystack, std::size_t length, std::size_t readable,
+                              const matcher& m, std::size_t pos, bool negate ) {
+    if( length == 0 ) {
+        return npos;
+    }
+
+    // one past the last position to consider
+    std::size_t end = ( pos < length ) ? pos+1 : length;
+
+#if defined(__AVX2__)
+    for( ; ( readable >= 32 ) && ( end >= 32 ); end -= 32 ) {
+        unsigned int mask = m.match32( haystack + end-32 );
+        mask = negate ? ~mask : mask;
+        if( mask ) {
+            return end-32 + detail::highest_set_bit( mask );
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    for( ; ( readable >= 16 ) && ( end >= 16 ); end -= 16 ) {
+        unsigned int mask = m.match16( haystack + end-16 );
+        mask = negate ? ~mask & 0xFFFF : mask;
+        if( mask ) {
+            return end-16 + detail::highest_set_bit( mask );
+        }
+    }
+    // the remainder sits at the front of the buffer, so a single block
+    // loaded from the start covers it if the buffer is big enough
+    if( ( end > 0 ) && ( readable >= 16 ) ) {
+        unsigned int mask = m.match16( haystack );
+        mask = negate ? ~mask & 0xFFFF : mask;
+        mask = detail::low_bits( mask, end, 16 );
+        return mask ? detail::highest_set_bit( mask ) : npos;
+    }
+#else
+    (void)readable;
+#endif
+
+    while( end-- > 0 ) {
+        if( m.contains( haystack[end] ) != negate ) {
+            return end;
+        }
+    }
+
+    return npos;
+}
+
+namespace detail {
+
+// vectorised prefix of block_equal(), advancing i past the blocks it covered
+template<std::size_t size>
+inline bool block_equal_vector( const char* lhs, const char* rhs, std::size_t& i ) {
+#if defined(__AVX2__)
+    for( ; i+32 <= size; i += 32 ) {
+        const __m256i difference = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( lhs + i ) ),
+                                                     _mm256_loadu_si256( reinterpret_cast<const __m256i*>( rhs + i ) ) );
+        if( !_mm256_testz_si256( difference, difference ) ) {
+            return false;
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    for( ; i+16 <= size; i += 16 ) {
+        const __m128i equal = _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( lhs + i ) ),
+                                              _mm_loadu_si128( reinterpret_cast<const __m128i*>( rhs + i ) ) );
+        if( _mm_movemask_epi8( equal ) != 0xFFFF ) {
+            return false;
+        }
+    }
+#else
+    (void)lhs; (void)rhs; (void)i;
+#endif
+    return true;
+}
+
+} // namespace detail
+
+// Whole-buffer equality for buffers of a fixed size, without looking for a
+// terminator. Only meaningful for strings whose unused bytes are zeroed.
+template<std::size_t size>
+constexpr bool block_equal( const char* lhs, const char* rhs ) {
+    std::size_t i = 0;
+
+    if( !std::is_constant_evaluated() && !detail::block_equal_vector<size>( lhs, rhs, i ) ) {
+        return false;
+    }
+
+    // fold whatever's left into one word and test it once
+    std::uint64_t difference = 0;
+    for( ; i+8 <= size; i += 8 ) {
+        difference |= detail::load_u64( lhs + i ) ^ detail::load_u64( rhs + i );
+    }
+    for( ; i+4 <= size; i += 4 ) {
+        difference |= detail::load_u32( lhs + i ) ^ detail::load_u32( rhs + i );
+    }
+    for( ; i < size; ++i ) {
+        difference |= static_cast<unsigned char>( lhs[i] ^ rhs[i] );
+    }
+
+    return difference == 0;
+}
+
+// Whole-buffer three-way comparison (-1, 0, 1), in memcmp() order. Words are
+// loaded big-endian so the first differing byte decides the integer compare.
+template<std::size_t size>
+constexpr int block_compare( const char* lhs, const char* rhs ) {
+    std::size_t i = 0;
+
+    for( ; i+8 <= size; i += 8 ) {
+        const std::uint64_t l = detail::load_u64_big_endian( lhs + i );
+        const std::uint64_t r = detail::load_u64_big_endian( rhs + i );
+        if( l != r ) {
+            return l < r ? -1 : 1;
+        }
+    }
+    for( ; i < size; ++i ) {
+        const unsigned char l = static_cast<unsigned char>( lhs[i] );
+        const unsigned char r = static_cast<unsigned char>( rhs[i] );
+        if( l != r ) {
+            return l < r ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+// Hash-table control bytes (see fl::flat_map) are probed 16 at a time. Bit i
+// of the result is set if byte i of the group matches.
+inline unsigned int match_group16( const char* group, char c ) {
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( group ) );
+    return static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, _mm_set1_epi8( c ) ) ) );
+#else
+    unsigned int mask = 0;
+    for( unsigned int i=0; i<16; ++i ) {
+        mask |= static_cast<unsigned int>( group[i] == c ) << i;
+    }
+    return mask;
+#endif
+}
+// bytes in the group with their top bit set
+inline unsigned int match_group16_high_bit( const char* group ) {
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( group ) );
+    return static_cast<unsigned int>( _mm_movemask_epi8( block ) );
+#else
+    unsigned int mask = 0;
+    for( unsigned int i=0; i<16; ++i ) {
+        mask |= static_cast<unsigned int>( ( static_cast<unsigned char>( group[i] ) & 0x80 ) != 0 ) << i;
+    }
+    return mask;
+#endif
+}
+
+// Batch matching of many fixed-width blocks (whole fl::strings, or rows of a
+// string column) at once. Bit i of the result is set if block i matches, for
+// up to 64 blocks.
+//
+// A block matches if ( block & mask ) == pattern, byte-wise. Blocks of 4 and 8
+// bytes are compared 8 and 4 to a register (AVX2), 16 and 32 byte blocks take
+// one compare each; any other size (or a partial final register) is compared
+// byte-by-byte.
+template<std::size_t size>
+inline std::uint64_t match_blocks( const char* blocks, std::size_t count, const char* pattern, const char* mask ) {
+    std::uint64_t matches = 0;
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    if constexpr( ( size == 4 ) || ( size == 8 ) || ( size == 16 ) || ( size == 32 ) ) {
+        const std::size_t per_step = 32 / size;
+        char pattern_bytes[32];
+        char mask_bytes[32];
+        for( std::size_t j=0; j<32; j += size ) {
+            std::memcpy( pattern_bytes + j, pattern, size );
+            std::memcpy( mask_bytes + j, mask, size );
+        }
+        const __m256i pattern_block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pattern_bytes ) );
+        const __m256i mask_block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( mask_bytes ) );
+
+        for( ; i + per_step <= count; i += per_step ) {
+            const __m256i block = _mm256_and_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( blocks + i*size ) ), mask_block );
+            std::uint64_t bits;
+            if constexpr( size == 4 ) {
+                bits = static_cast<unsigned int>( _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( block, pattern_block ) ) ) );
+            } else if constexpr( size == 8 ) {
+                bits = static_cast<unsigned int>( _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpeq_epi64( block, pattern_block ) ) ) );
+            } else if constexpr( size == 16 ) {
+                const unsigned int bytes = static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, pattern_block ) ) );
+                bits = static_cast<unsigned int>( ( bytes & 0xFFFF ) == 0xFFFF ) | ( static_cast<unsigned int>( ( bytes >> 16 ) == 0xFFFF ) << 1 );
+            } else {
+                bits = static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, pattern_block ) ) ) == 0xFFFFFFFFu;
+            }
+            matches |= bits << i;
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    if constexpr( ( size == 4 ) || ( size == 8 ) || ( size == 16 ) ) {
+        const std::size_t per_step = 16 / size;
+        char pattern_bytes[16];
+        char mask_bytes[16];
+        for( std::size_t j=0; j<16; j += size ) {
+            std::memcpy( pattern_bytes + j, pattern, size );
+            std::memcpy( mask_bytes + j, mask, size );
+        }
+        const __m128i pattern_block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pattern_bytes ) );
+        const __m128i mask_block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( mask_bytes ) );
+
+        for( ; i + per_step <= count; i += per_step ) {
+            const __m128i block = _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( blocks + i*size ) ), mask_block );
+            std::uint64_t bits;
+            if constexpr( size == 4 ) {
+                bits = static_cast<unsigned int>( _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( block, pattern_block ) ) ) );
+            } else if constexpr( size == 8 ) {
+                // no 64-bit compare in SSE2: both halves of a block have to match
+                unsigned int halves = static_cast<unsigned int>( _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( block, pattern_block ) ) ) );
+                halves &= halves >> 1;
+                bits = ( halves & 1 ) | ( ( halves >> 1 ) & 2 );
+            } else {
+                bits = static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, pattern_block ) ) ) == 0xFFFFu;
+            }
+            matches |= bits << i;
+        }
+    }
+#endif
+
+    for( ; i<count; ++i ) {
+        const char* block = blocks + i*size;
+        bool match = true;
+        for( std::size_t j=0; j<size; ++j ) {
+            match &= ( ( block[j] & mask[j] ) == pattern[j] );
+        }
+        matches |= static_cast<std::uint64_t>( match ) << i;
+    }
+
+    return matches;
+}
+
+// Bit i is set if lengths[i] == length (or >= length, with at_least), for up
+// to 64 lengths; 32 per compare with AVX2, 16 with SSE2.
+inline std::uint64_t match_lengths( const std::uint8_t* lengths, std::size_t count, std::uint8_t length, bool at_least ) {
+    std::uint64_t matches = 0;
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    {
+        const __m256i value = _mm256_set1_epi8( static_cast<char>( length ) );
+        for( ; i+32 <= count; i += 32 ) {
+            const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( lengths + i ) );
+            const __m256i match = at_least ? _mm256_cmpeq_epi8( _mm256_max_epu8( block, value ), block )
+                                           : _mm256_cmpeq_epi8( block, value );
+            matches |= static_cast<std::uint64_t>( static_cast<unsigned int>( _mm256_movemask_epi8( match ) ) ) << i;
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128i value = _mm_set1_epi8( static_cast<char>( length ) );
+        for( ; i+16 <= count; i += 16 ) {
+            const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( lengths + i ) );
+            const __m128i match = at_least ? _mm_cmpeq_epi8( _mm_max_epu8( block, value ), block )
+                                           : _mm_cmpeq_epi8( block, value );
+            matches |= static_cast<std::uint64_t>( static_cast<unsigned int>( _mm_movemask_epi8( match ) ) ) << i;
+        }
+    }
+#endif
+
+    for( ; i<count; ++i ) {
+        const bool match = at_least ? ( lengths[i] >= length ) : ( lengths[i] == length );
+        matches |= static_cast<std::uint64_t>( match ) << i;
+    }
+
+    return matches;
+}
+
+// Start positions in a single block of 16 or 32 bytes where the first and last
+// bytes of a needle ('distance' apart) both match: bit i is set if block[i] is
+// first and block[i + distance] is last. Candidates still need their middle
+// bytes checked (as with find()), and masking to the valid start positions.
+template<std::size_t width>
+inline unsigned int match_first_last( const char* block, char first, char last, std::size_t distance ) {
+    static_assert( ( width == 16 ) || ( width == 32 ), "blocks are 16 or 32 bytes" );
+#if defined(__AVX2__)
+    if constexpr( width == 32 ) {
+        const __m256i bytes = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( block ) );
+        const unsigned int firsts = static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( bytes, _mm256_set1_epi8( first ) ) ) );
+        const unsigned int lasts = static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( bytes, _mm256_set1_epi8( last ) ) ) );
+        return firsts & ( lasts >> distance );
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    unsigned int firsts = 0;
+    unsigned int lasts = 0;
+    for( std::size_t i=0; i<width; i += 16 ) {
+        const __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( block + i ) );
+        firsts |= static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( bytes, _mm_set1_epi8( first ) ) ) ) << i;
+        lasts |= static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( bytes, _mm_set1_epi8( last ) ) ) ) << i;
+    }
+    return firsts & ( lasts >> distance );
+#else
+    unsigned int mask = 0;
+    for( std::size_t i=0; i+distance<width; ++i ) {
+        mask |= static_cast<unsigned int>( ( block[i] == first ) && ( block[i + distance] == last ) ) << i;
+    }
+    return mask;
+#endif
+}
+
+// How many of values[0, count) are less than key (unsigned), e.g. the position
+// of key in a sorted array of big-endian prefixes; 4 per compare with AVX2.
+// SSE2 has no 64-bit compare, so elsewhere this is a branch-free scalar count.
+inline std::size_t count_less( const std::uint64_t* values, std::size_t count, std::uint64_t key ) {
+    std::size_t less = 0;
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    {
+        // the compare is signed; flipping the top bits makes it unsigned
+        const __m256i sign = _mm256_set1_epi64x( static_cast<long long>( 0x8000000000000000ULL ) );
+        const __m256i probe = _mm256_xor_si256( _mm256_set1_epi64x( static_cast<long long>( key ) ), sign );
+        const std::size_t whole = count & ~std::size_t( 3 );
+        for( ; i<whole; i += 4 ) {
+            const __m256i block = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( values + i ) ), sign );
+            const int mask = _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( probe, block ) ) );
+            less += static_cast<std::size_t>( std::popcount( static_cast<unsigned int>( mask ) ) );
+        }
+    }
+#endif
+
+    for( ; i<count; ++i ) {
+        less += static_cast<std::size_t>( values[i] < key );
+    }
+
+    return less;
+}
+
+} // namespace simd
+} // namespace fl
+
+
+#endif // FLSIMD_HPP
@@ -0,0 +1,374 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flsort.hpp
+    Author  :   Jamie Taylor
+    Desc    :   Radix sorts for contiguous ranges of fl::string<N>, giving
+                the same order as operator< (and std::sort).
+                - sort(): for N <= 16, a least-significant-digit radix
+                  sort over the fixed bytes (one counting pass, then one
+                  scatter per byte position which isn't constant),
+                  after large ranges have been split by their leading
+                  bytes into cache-sized buckets. For larger N, a
+                  most-significant-digit radix sort, which
+                  only looks at as many bytes as needed to separate the
+                  strings, with insertion sort for small buckets.
+                - parallel_sort(): splits the range by its first
+                  distinguishing byte using all threads, then sorts the
+                  buckets concurrently.
+                Both need a scratch buffer the size of the range.
+
+===============================================================================
+*/
+#ifndef FLSORT_HPP
+#define FLSORT_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "flstring.hpp"
+
+namespace fl {
+
+namespace detail {
+
+template<typename T>
+struct sort_traits {
+    static const bool is_string = false;
+};
+template<std::size_t string_size, typename... policies>
+struct sort_traits<string<string_size, policies...>> {
+    static const bool is_string = true;
+    static const std::size_t size = string_size;
+    static const bool zero_padded = string<string_size, policies...>::policy_type::zero_padded;
+};
+
+// Strings order by their bytes with everything from the terminator on read as
+// zero, then by length (which only matters for embedded nulls); the byte sort
+// key at each position is therefore the character or zero.
+template<typename string_type>
+inline unsigned int radix_byte( const string_type& str, std::size_t pos ) {
+    if constexpr( sort_traits<string_type>::zero_padded && ( sort_traits<string_type>::size <= 256 ) ) {
+        // the padding is already zero, and the capacity trailer is never read
+        return static_cast<unsigned char>( str.data()[pos] );
+    } else {
+        return ( pos < str.length() ) ? static_cast<unsigned char>( str.data()[pos] ) : 0;
+    }
+}
+
+// For the MSD sort, 0 is the 'ended here' bucket, and 1-256 are the characters
+// (so embedded nulls are kept apart from the end of the string).
+inline constexpr std::size_t msd_bucket_count = 257;
+template<typename string_type>
+inline unsigned int msd_bucket( const string_type& str, std::size_t depth ) {
+    return ( depth < str.length() ) ? 1u + static_cast<unsigned char>( str.data()[depth] ) : 0u;
+}
+
+// Below insertion_sort_threshold (or lsd_sort_threshold, for the LSD sort),
+// radix sorting costs more than it saves. Above msd_sort_threshold, even short
+// strings are first split MSD-wise, so that each LSD sort's scatters stay in cache.
+inline constexpr std::size_t insertion_sort_threshold = 32;
+inline constexpr std::size_t lsd_sort_threshold = 256;
+inline constexpr std::size_t msd_sort_threshold = 65536;
+
+template<typename string_type>
+void insertion_sort( string_type* data, std::size_t count ) {
+    for( std::size_t i=1; i<count; ++i ) {
+        const string_type str = data[i];
+        std::size_t j = i;
+        for( ; ( j > 0 ) && ( str.compare( data[j-1] ) < 0 ); --j ) {
+            data[j] = data[j-1];
+        }
+        data[j] = str;
+    }
+}
+
+// Scratch space for count strings. fl::string is trivially copyable, so it's
+// left uninitialised and written with plain copies.
+template<typename string_type>
+struct sort_buffer {
+    static_assert( std::is_trivially_copyable_v<string_type>, "fl::sort needs trivially copyable elements" );
+
+    explicit                    sort_buffer( std::size_t count ) :
+                                    m_data( std::allocator<string_type>().allocate( count ) ), m_count( count ) {}
+                                sort_buffer( const sort_buffer& ) = delete;
+    sort_buffer&                operator=( const sort_buffer& ) = delete;
+                                ~sort_buffer() { std::allocator<string_type>().deallocate( m_data, m_count ); }
+
+    string_type*                data() const noexcept { return m_data; }
+
+private:
+    string_type*                m_data;
+    std::size_t                 m_count;
+};
+
+template<typename string_type>
+void radix_sort( string_type* data, string_type* buffer, std::size_t count, std::size_t depth );
+
+// LSD radix sort: the length first (the least significant key), then each byte
+// from the last to the first. Positions where every string has the same byte
+// are skipped, which for typical keys (common prefixes, short values in a
+// wider string) is most of them. Keys before 'depth' are known to be equal.
+template<typename string_type>
+void lsd_sort( string_type* data, string_type* buffer, std::size_t count, std::size_t depth ) {
+    const std::size_t key_count = sort_traits<string_type>::size;   // bytes [0, N-1) and the length
+    const std::size_t length_key = key_count - 1;
+
+    std::vector<std::array<std::size_t, 256>> histograms( key_count );
+    for( std::size_t i=0; i<count; ++i ) {
+        const string_type& str = data[i];
+        for( std::size_t pos=depth; pos<length_key; ++pos ) {
+            ++histograms[pos][radix_byte( str, pos )];
+        }
+        ++histograms[length_key][str.length()];
+    }
+
+    string_type* src = data;
+    string_type* dst = buffer;
+    for( std::size_t key=key_count; key-- > depth; ) {
+        std::array<std::size_t, 256>& histogram = histograms[key];
+        if( std::find( histogram.begin(), histogram.end(), count ) != histogram.end() ) {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for( std::size_t& bucket : histogram ) {
+            const std::size_t bucket_count = bucket;
+            bucket = offset;
+            offset += bucket_count;
+        }
+        if( key == length_key ) {
+            for( std::size_t i=0; i<count; ++i ) {
+                dst[histogram[src[i].length()]++] = src[i];
+            }
+        } else {
+            for( std::size_t i=0; i<count; ++i ) {
+                dst[histogram[radix_byte( src[i], key )]++] = src[i];
+            }
+        }
+        std::swap( src, dst );
+    }
+
+    if( src != data ) {
+        copy_n( src, count, data );
+    }
+}
+
+// Sorts a range small enough not to be split any further
+template<typename string_type>
+void small_sort( string_type* data, string_type* buffer, std::size_t count, std::size_t depth ) {
+    if( ( count <= insertion_sort_threshold ) || ( sort_traits<string_type>::size > 16 ) ) {
+        insertion_sort( data, count );
+    } else if( count < lsd_sort_threshold ) {
+        std::sort( data, data + count );
+    } else {
+        lsd_sort( data, buffer, count, depth );
+    }
+}
+
+// MSD radix sort: split on the byte at 'depth', then sort each bucket on the
+// next. The largest bucket is carried on in the loop (rather than recursed
+// into) so the stack only grows by one frame each time a bucket halves.
+template<typename string_type>
+void msd_sort( string_type* data, string_type* buffer, std::size_t count, std::size_t depth ) {
+    const std::size_t max_depth = sort_traits<string_type>::size - 1;
+    const std::size_t threshold = ( sort_traits<string_type>::size > 16 ) ? insertion_sort_threshold : msd_sort_threshold;
+
+    while( ( count > threshold ) && ( depth < max_depth ) ) {
+        std::array<std::size_t, msd_bucket_count> histogram = {};
+        for( std::size_t i=0; i<count; ++i ) {
+            ++histogram[msd_bucket( data[i], depth )];
+        }
+        if( histogram[0] == count ) {
+            // all ended at the same length, so they're equal
+            return;
+        }
+        if( std::find( histogram.begin() + 1, histogram.end(), count ) != histogram.end() ) {
+            ++depth;
+            continue;
+        }
+
+        std::array<std::size_t, msd_bucket_count> offsets;
+        std::size_t offset = 0;
+        for( std::size_t bucket=0; bucket<msd_bucket_count; ++bucket ) {
+            offsets[bucket] = offset;
+            offset += histogram[bucket];
+        }
+        for( std::size_t i=0; i<count; ++i ) {
+            buffer[offsets[msd_bucket( data[i], depth )]++] = data[i];
+        }
+        copy_n( buffer, count, data );
+
+        // bucket 0 (strings ending here) is already in place, and all equal
+        std::size_t largest = 1;
+        for( std::size_t bucket=2; bucket<msd_bucket_count; ++bucket ) {
+            if( histogram[bucket] > histogram[largest] ) {
+                largest = bucket;
+            }
+        }
+        for( std::size_t bucket=1; bucket<msd_bucket_count; ++bucket ) {
+            if( ( bucket != largest ) && ( histogram[bucket] > 1 ) ) {
+                const std::size_t first = offsets[bucket] - histogram[bucket];
+                radix_sort( data + first, buffer + first, histogram[bucket], depth+1 );
+            }
+        }
+        const std::size_t first = offsets[largest] - histogram[largest];
+        data += first;
+        buffer += first;
+        count = histogram[largest];
+        ++depth;
+    }
+
+    if( depth < max_depth ) {
+        small_sort( data, buffer, count, depth );
+    }
+}
+
+// Sort data[0, count), which is known to be equal before 'depth'
+template<typename string_type>
+void radix_sort( string_type* data, string_type* buffer, std::size_t count, std::size_t depth ) {
+    const std::size_t threshold = ( sort_traits<string_type>::size > 16 ) ? insertion_sort_threshold : msd_sort_threshold;
+    if( count > threshold ) {
+        msd_sort( data, buffer, count, depth );
+    } else {
+        small_sort( data, buffer, count, depth );
+    }
+}
+
+// Runs body( thread_index ) on thread_count threads (including this one)
+template<typename function>
+void run_on_threads( unsigned int thread_count, function body ) {
+    std::vector<std::jthread> threads;
+    threads.reserve( thread_count - 1 );
+    for( unsigned int thread=1; thread<thread_count; ++thread ) {
+        threads.emplace_back( body, thread );
+    }
+    body( 0u );
+}
+
+} // namespace detail
+
+// Sorts [first, last) into the order given by operator<. Not stable, though
+// strings which compare equal are identical anyway.
+template<std::contiguous_iterator iterator>
+    requires detail::sort_traits<std::iter_value_t<iterator>>::is_string
+void sort( iterator first, iterator last ) {
+    using string_type = std::iter_value_t<iterator>;
+
+    const std::size_t count = static_cast<std::size_t>( last - first );
+    if( count <= detail::insertion_sort_threshold ) {
+        detail::insertion_sort( std::to_address( first ), count );
+        return;
+    }
+
+    detail::sort_buffer<string_type> buffer( count );
+    detail::radix_sort( std::to_address( first ), buffer.data(), count, 0 );
+}
+
+// As sort(), using up to thread_count threads. The strings are first split on
+// the first byte at which they differ (each thread counting and then scattering
+// its own slice of the range), and the resulting buckets are then handed out,
+// largest first, to be sorted independently. How well this scales depends on
+// how evenly that byte is distributed.
+template<std::contiguous_iterator iterator>
+    requires detail::sort_traits<std::iter_value_t<iterator>>::is_string
+void parallel_sort( iterator first, iterator last, unsigned int thread_count = std::thread::hardware_concurrency() ) {
+    using string_type = std::iter_value_t<iterator>;
+    const std::size_t bucket_count = detail::msd_bucket_count;
+    const std::size_t max_depth = detail::sort_traits<string_type>::size - 1;
+
+    const std::size_t count = static_cast<std::size_t>( last - first );
+    if( ( thread_count <= 1 ) || ( count < thread_count * std::size_t( 16384 ) ) ) {
+        fl::sort( first, last );
+        return;
+    }
+
+    string_type* const data = std::to_address( first );
+    detail::sort_buffer<string_type> buffer( count );
+    const std::size_t slice = ( count + thread_count - 1 ) / thread_count;
+    std::vector<std::array<std::size_t, bucket_count>> histograms( thread_count );
+
+    // find the first byte position which splits the range
+    std::size_t depth = 0;
+    std::array<std::size_t, bucket_count> totals;
+    for( ;; ++depth ) {
+        detail::run_on_threads( thread_count, [&]( unsigned int thread ) {
+            std::array<std::size_t, bucket_count>& histogram = histograms[thread];
+            histogram.fill( 0 );
+            const std::size_t end = std::min( count, ( thread+1 ) * slice );
+            for( std::size_t i=thread*slice; i<end; ++i ) {
+                ++histogram[detail::msd_bucket( data[i], depth )];
+            }
+        } );
+
+        totals.fill( 0 );
+        for( const auto& histogram : histograms ) {
+            for( std::size_t bucket=0; bucket<bucket_count; ++bucket ) {
+                totals[bucket] += histogram[bucket];
+            }
+        }
+        if( totals[0] == count ) {
+            return;     // all equal
+        }
+        if( ( depth+1 == max_depth ) || ( std::find( totals.begin(), totals.end(), count ) == totals.end() ) ) {
+            break;
+        }
+    }
+
+    // each thread scatters its slice to its own offsets within each bucket
+    std::array<std::size_t, bucket_count> bucket_offsets;
+    std::size_t offset = 0;
+    for( std::size_t bucket=0; bucket<bucket_count; ++bucket ) {
+        bucket_offsets[bucket] = offset;
+        for( auto& histogram : histograms ) {
+            const std::size_t thread_count_in_bucket = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += thread_count_in_bucket;
+        }
+    }
+    detail::run_on_threads( thread_count, [&]( unsigned int thread ) {
+        std::array<std::size_t, bucket_count>& offsets = histograms[thread];
+        const std::size_t end = std::min( count, ( thread+1 ) * slice );
+        for( std::size_t i=thread*slice; i<end; ++i ) {
+            buffer.data()[offsets[detail::msd_bucket( data[i], depth )]++] = data[i];
+        }
+    } );
+
+    // then the buckets are copied back and sorted, biggest first
+    std::vector<std::size_t> buckets;
+    for( std::size_t bucket=0; bucket<bucket_count; ++bucket ) {
+        if( totals[bucket] != 0 ) {
+            buckets.push_back( bucket );
+        }
+    }
+    std::sort( buckets.begin(), buckets.end(), [&]( std::size_t lhs, std::size_t rhs ) {
+        return totals[lhs] > totals[rhs];
+    } );
+    std::atomic<std::size_t> next_bucket = 0;
+    detail::run_on_threads( thread_count, [&]( unsigned int ) {
+        for( std::size_t i=next_bucket++; i<buckets.size(); i=next_bucket++ ) {
+            const std::size_t bucket = buckets[i];
+            const std::size_t bucket_first = bucket_offsets[bucket];
+            copy_n( buffer.data() + bucket_first, totals[bucket], data + bucket_first );
+            if( bucket != 0 ) {
+                detail::radix_sort( data + bucket_first, buffer.data() + bucket_first, totals[bucket], depth+1 );
+            }
+        }
+    } );
+}
+
+} // namespace fl
+
+
+#endif // FLSORT_HPP
@@ -0,0 +1,238 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flstatic_map.hpp
+    Author  :   Jamie Taylor
+    Desc    :   A read-only map over a fixed set of fl::string<N> keys,
+                built at compile time (it is a literal type, so it can be
+                declared constexpr) around a minimal perfect hash in the
+                style of CHD/PTHash: keys are split into small buckets by
+                their hash, and each bucket is given a 'pilot' that moves
+                all of its keys into free slots. Every slot holds exactly
+                one entry, so a look-up is one hash, one pilot read, and
+                one fixed-width key compare; there is no probing, and no
+                empty slots.
+
+===============================================================================
+*/
+#ifndef FLSTATIC_MAP_HPP
+#define FLSTATIC_MAP_HPP
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "flstring.hpp"
+#include "flhash.hpp"
+
+namespace fl {
+
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+class static_map {
+    static_assert( key_count > 0, "fl::static_map needs at least one key" );
+    static_assert( key_count <= 0xFFFFFFFF, "fl::static_map slots are indexed with 32 bits" );
+
+                                template<typename T>
+    static constexpr bool       string_view_like = std::is_convertible_v<const T&, std::string_view> &&
+                                                   !std::is_same_v<T, string<key_size, zero_padding>>;
+
+public:
+
+                                // member types
+    using key_type              = string<key_size, zero_padding>;
+    using mapped_type           = mapped;
+    using value_type            = std::pair<key_type, mapped_type>;
+    using size_type             = std::size_t;
+    using const_reference       = const value_type&;
+    using const_iterator        = const value_type*;
+    using iterator              = const_iterator;
+
+                                // about four keys a bucket (the usual CHD/PTHash trade-off between
+                                // the size of the pilot table and the time taken to build it)
+    static constexpr size_type  bucket_count = ( key_count + 3 ) / 4;
+
+                                // construction; the keys must be unique (throws std::invalid_argument
+                                // if not, which is a compile error when constant-evaluated)
+    constexpr explicit          static_map( const value_type (&entries)[key_count] ) { build( entries ); }
+                                // a key set: each key maps to its index in keys
+    constexpr explicit          static_map( const std::array<key_type, key_count>& keys );
+
+                                // iterators (in slot order, not the order the entries were given in)
+    constexpr const_iterator    begin() const noexcept { return m_slots.data(); }
+    constexpr const_iterator    cbegin() const noexcept { return begin(); }
+    constexpr const_iterator    end() const noexcept { return m_slots.data() + key_count; }
+    constexpr const_iterator    cend() const noexcept { return end(); }
+
+                                // capacity
+    constexpr bool              empty() const noexcept { return false; }
+    constexpr size_type         size() const noexcept { return key_count; }
+
+                                // lookup
+    constexpr const_iterator    find( const key_type& key ) const;
+                                // anything else that converts to a string_view (const char*,
+                                // std::string, fl::string of another size or policy, ...)
+                                template<typename T> requires string_view_like<T>
+    constexpr const_iterator    find( const T& str ) const {
+                                    const std::string_view sv( str );
+                                    return ( sv.length() < key_size ) ? find( key_type( sv ) ) : end();
+                                }
+    constexpr bool              contains( const key_type& key ) const { return find( key ) != end(); }
+                                template<typename T> requires string_view_like<T>
+    constexpr bool              contains( const T& str ) const { return find( str ) != end(); }
+    constexpr const mapped_type& at( const key_type& key ) const;
+                                template<typename T> requires string_view_like<T>
+    constexpr const mapped_type& at( const T& str ) const { return at_or_throw( find( str ) ); }
+
+private:
+    static constexpr std::uint64_t hash_of( const key_type& key ) { return static_cast<std::uint64_t>( hash_value( key ) ); }
+                                // 'fast range' reductions of the top 32 bits of a hash. The slot
+                                // hash has to be re-mixed with the pilot (a plain xor would leave
+                                // keys that differ only in their low bits in the same slot forever)
+    static constexpr size_type  bucket_of( std::uint64_t hash ) noexcept {
+                                    return static_cast<size_type>( ( ( hash >> 32 ) * bucket_count ) >> 32 );
+                                }
+    static constexpr size_type  slot_of( std::uint64_t hash, std::uint32_t pilot ) noexcept {
+                                    const std::uint64_t mixed = hash::detail::multiply_fold( hash ^ pilot, hash::detail::hash_key2 );
+                                    return static_cast<size_type>( ( ( mixed >> 32 ) * key_count ) >> 32 );
+                                }
+
+    constexpr const mapped_type& at_or_throw( const_iterator it ) const;
+    constexpr void              build( const value_type* entries );
+
+    std::array<std::uint32_t, bucket_count> m_pilots = {};
+    std::array<value_type, key_count> m_slots = {};
+};
+
+// construction
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+constexpr static_map<key_size, mapped, key_count>::static_map( const std::array<key_type, key_count>& keys ) {
+    std::array<value_type, key_count> entries = {};
+    for( size_type i=0; i<key_count; ++i ) {
+        entries[i] = value_type( keys[i], static_cast<mapped_type>( i ) );
+    }
+    build( entries.data() );
+}
+
+// lookup
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+constexpr typename static_map<key_size, mapped, key_count>::const_iterator static_map<key_size, mapped, key_count>::find( const key_type& key ) const {
+    const std::uint64_t hash = hash_of( key );
+    const value_type& slot = m_slots[slot_of( hash, m_pilots[bucket_of( hash )] )];
+    return ( slot.first == key ) ? &slot : end();
+}
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+constexpr const mapped& static_map<key_size, mapped, key_count>::at( const key_type& key ) const {
+    return at_or_throw( find( key ) );
+}
+
+// internals
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+constexpr const mapped& static_map<key_size, mapped, key_count>::at_or_throw( const_iterator it ) const {
+    if( it == end() ) {
+        throw std::out_of_range( "fl::static_map::at" );
+    }
+    return it->second;
+}
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+constexpr void static_map<key_size, mapped, key_count>::build( const value_type* entries ) {
+    std::array<std::uint64_t, key_count> hashes = {};
+    for( size_type i=0; i<key_count; ++i ) {
+        hashes[i] = hash_of( entries[i].first );
+    }
+
+    // Group the entries by bucket: bucket b's entries are members[first[b], first[b+1])
+    std::array<size_type, bucket_count + 1> first = {};
+    for( size_type i=0; i<key_count; ++i ) {
+        ++first[bucket_of( hashes[i] ) + 1];
+    }
+    for( size_type b=0; b<bucket_count; ++b ) {
+        first[b + 1] += first[b];
+    }
+    std::array<size_type, key_count> members = {};
+    std::array<size_type, bucket_count> filled = {};
+    for( size_type i=0; i<key_count; ++i ) {
+        const size_type bucket = bucket_of( hashes[i] );
+        members[first[bucket] + filled[bucket]++] = i;
+    }
+
+    // Equal keys always share a bucket, so that's the only place to look for them
+    for( size_type b=0; b<bucket_count; ++b ) {
+        for( size_type i=first[b]; i<first[b + 1]; ++i ) {
+            for( size_type j=i+1; j<first[b + 1]; ++j ) {
+                if( entries[members[i]].first == entries[members[j]].first ) {
+                    throw std::invalid_argument( "fl::static_map: duplicate key" );
+                }
+            }
+        }
+    }
+
+    // Place the largest buckets first, while most slots are still free
+    std::array<size_type, key_count + 2> size_first = {};
+    for( size_type b=0; b<bucket_count; ++b ) {
+        ++size_first[key_count - ( first[b + 1] - first[b] ) + 1];
+    }
+    for( size_type s=0; s<=key_count; ++s ) {
+        size_first[s + 1] += size_first[s];
+    }
+    std::array<size_type, bucket_count> order = {};
+    for( size_type b=0; b<bucket_count; ++b ) {
+        order[size_first[key_count - ( first[b + 1] - first[b] )]++] = b;
+    }
+
+    std::array<bool, key_count> taken = {};
+    std::array<size_type, key_count> slot_entry = {};
+    for( const size_type b : order ) {
+        const size_type begin = first[b];
+        const size_type end = first[b + 1];
+        if( begin == end ) {
+            break;  // the rest are empty too
+        }
+
+        for( std::uint32_t pilot=0; ; ++pilot ) {
+            if( pilot == 0xFFFFFFFF ) {
+                // only reachable if two different keys have the same 64-bit hash
+                throw std::invalid_argument( "fl::static_map: no perfect hash for these keys" );
+            }
+
+            size_type placed = begin;
+            for( ; placed<end; ++placed ) {
+                const size_type slot = slot_of( hashes[members[placed]], pilot );
+                if( taken[slot] ) {
+                    break;
+                }
+                taken[slot] = true;
+                slot_entry[slot] = members[placed];
+            }
+            if( placed == end ) {
+                m_pilots[b] = pilot;
+                break;
+            }
+            // undo this attempt's (partial) placement
+            for( size_type i=begin; i<placed; ++i ) {
+                taken[slot_of( hashes[members[i]], pilot )] = false;
+            }
+        }
+    }
+
+    for( size_type slot=0; slot<key_count; ++slot ) {
+        m_slots[slot] = entries[slot_entry[slot]];
+    }
+}
+
+// make_static_map<N, V>( { { "key", value }, ... } ), counting the entries
+template<std::size_t key_size, typename mapped, std::size_t key_count>
+constexpr static_map<key_size, mapped, key_count> make_static_map( const std::pair<string<key_size, zero_padding>, mapped> (&entries)[key_count] ) {
+    return static_map<key_size, mapped, key_count>( entries );
+}
+
+} // namespace fl
+
+
+#endif // FLSTATIC_MAP_HPP
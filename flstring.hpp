@@ -9,12 +9,11 @@
                 Created for C++ London presentation:
                 "Beyond SSO: The Merits of Fixed-Length Strings".
 
+                Requires C++20 (constexpr evaluation, class-type
+                non-type template parameters).
+
                 TODO:
                 ----
-                - constexpr?
-                - static_assert (use array in set_data() and have the array size be a template param?)
-                - error-handling?
-                - clear() should probably memset() to '\0'?
                 - LOOP_UNROLLING? Go in increments of 2? Enforce string size as a multiple of two?
 
 ===============================================================================
@@ -25,14 +24,227 @@
 
 #include <array>
 #include <cassert>
-#include <experimental/string_view>
+#include <compare>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 
+#include "flhash.hpp"
+#include "flsimd.hpp"
 
 namespace fl {
 
-template<size_t string_size>
+// Storage policies: what is kept in the bytes between the null-terminator
+// and the remaining-capacity byte.
+//
+// lazy_padding leaves them as they are, so writes only touch what they need.
+// zero_padding keeps them zeroed, so two strings holding the same characters
+// are identical byte-for-byte and can be compared/hashed as whole blocks.
+struct lazy_padding {
+    static const bool zero_padded = false;
+};
+struct zero_padding {
+    static const bool zero_padded = true;
+};
+
+// Overflow policies: what happens when a write doesn't fit. fit() is given
+// the number of characters to be written and the space available, and
+// returns how many to actually write.
+//
+// assert_on_overflow checks in debug builds only, and is free in release
+// (where an overflow is undefined, as it is for an unchecked array write).
+// truncate_on_overflow writes as much as fits. throw_on_overflow throws a
+// std::length_error and leaves the string untouched.
+struct assert_on_overflow {
+    static constexpr std::size_t fit( std::size_t length, std::size_t available ) {
+        assert( ( length <= available ) && "fl::string overflow, please allocate more space." );
+        static_cast<void>( available );
+        return length;
+    }
+};
+struct truncate_on_overflow {
+    static constexpr std::size_t fit( std::size_t length, std::size_t available ) noexcept {
+        return length < available ? length : available;
+    }
+};
+struct throw_on_overflow {
+    static constexpr std::size_t fit( std::size_t length, std::size_t available ) {
+        if( length > available ) {
+            throw std::length_error( "fl::string overflow" );
+        }
+        return length;
+    }
+};
+
+namespace detail {
+
+// The remaining capacity is kept at the end of the buffer, so that a full
+// string's capacity of zero doubles as its null-terminator.
+//
+// Up to 256 bytes it's just the last byte. Beyond that, capacities below 128
+// still only take the last byte (high bit clear), larger ones set its high
+// bit and keep their low 8 bits in the byte before it, which is free as the
+// string is then at least 128 characters short of full. So a capacity of up
+// to 32767 (fl::string<32768>) can be stored.
+template<std::size_t size>
+struct capacity_trailer {
+    static const bool wide = size > 256;
+
+    static constexpr std::size_t load( const char* p ) noexcept {
+        const std::size_t last = static_cast<unsigned char>( p[size-1] );
+        if( wide && ( last & 0x80 ) ) {
+            return ( ( last & 0x7F ) << 8 ) | static_cast<unsigned char>( p[size-2] );
+        }
+        return last;
+    }
+    static constexpr void store( char* p, std::size_t capacity ) noexcept {
+        if( wide && ( capacity >= 0x80 ) ) {
+            p[size-2] = static_cast<char>( capacity & 0xFF );
+            p[size-1] = static_cast<char>( 0x80 | ( capacity >> 8 ) );
+            return;
+        }
+        if( wide && ( capacity != 0 ) ) {
+            // may be left over from a wide capacity, and is either the
+            // terminator or padding now (a capacity of 0 means it's a character)
+            p[size-2] = '\0';
+        }
+        p[size-1] = static_cast<char>( capacity );
+    }
+};
+
+// Whole-buffer operations on a string of a given size, ignoring the length.
+// equal(), compare() and hash() are only meaningful when the unused bytes are
+// zeroed; copy() and clear() are valid for any policy, but only at run-time.
+template<std::size_t size>
+struct block {
+    static const bool in_register = false;
+
+    static constexpr bool       equal( const char* lhs, const char* rhs ) { return simd::block_equal<size>( lhs, rhs ); }
+    static constexpr int        compare( const char* lhs, const char* rhs ) { return simd::block_compare<size>( lhs, rhs ); }
+    static constexpr std::size_t hash( const char* p ) { return static_cast<std::size_t>( hash::hash64<size>( p, size ) ); }
+    static void                 copy( char* dst, const char* src ) { std::memcpy( dst, src, size ); }
+    static void                 clear( char* p ) {
+                                    std::memset( p, 0, size-1 );
+                                    capacity_trailer<size>::store( p, size-1 );
+                                }
+};
+
+// Strings which fit exactly into an integer register are handled as a single
+// word: one load/store per copy or clear, one integer compare for equality and
+// a byte-swapped (big-endian) compare for ordering.
+template<typename word_type>
+struct register_block {
+    static const bool in_register = true;
+    static const std::size_t size = sizeof( word_type );
+
+    static constexpr word_type  load( const char* p ) { return simd::detail::load_word<word_type>( p ); }
+    static void                 store( char* p, word_type word ) { std::memcpy( p, &word, size ); }
+
+    static constexpr bool       equal( const char* lhs, const char* rhs ) { return load( lhs ) == load( rhs ); }
+    static void                 copy( char* dst, const char* src ) { store( dst, load( src ) ); }
+    static void                 clear( char* p ) {
+                                    // built as bytes so it doesn't depend on endianness,
+                                    // the compiler folds it into a single constant store
+                                    char empty[size] = {};
+                                    empty[size-1] = static_cast<char>( size-1 );
+                                    std::memcpy( p, empty, size );
+                                }
+};
+
+template<>
+struct block<4> : register_block<std::uint32_t> {
+    static constexpr int        compare( const char* lhs, const char* rhs ) {
+                                    const std::uint32_t l = simd::detail::load_u32_big_endian( lhs );
+                                    const std::uint32_t r = simd::detail::load_u32_big_endian( rhs );
+                                    return ( l > r ) - ( l < r );
+                                }
+    static constexpr std::size_t hash( const char* p ) { return static_cast<std::size_t>( hash::mix64( load( p ) ) ); }
+};
+template<>
+struct block<8> : register_block<std::uint64_t> {
+    static constexpr int        compare( const char* lhs, const char* rhs ) {
+                                    const std::uint64_t l = simd::detail::load_u64_big_endian( lhs );
+                                    const std::uint64_t r = simd::detail::load_u64_big_endian( rhs );
+                                    return ( l > r ) - ( l < r );
+                                }
+    static constexpr std::size_t hash( const char* p ) { return static_cast<std::size_t>( hash::mix64( load( p ) ) ); }
+};
+#if defined(__SIZEOF_INT128__)
+template<>
+struct block<16> : register_block<unsigned __int128> {
+    static constexpr int        compare( const char* lhs, const char* rhs ) {
+                                    const unsigned __int128 l = ( static_cast<unsigned __int128>( simd::detail::load_u64_big_endian( lhs ) ) << 64 ) |
+                                                                simd::detail::load_u64_big_endian( lhs + 8 );
+                                    const unsigned __int128 r = ( static_cast<unsigned __int128>( simd::detail::load_u64_big_endian( rhs ) ) << 64 ) |
+                                                                simd::detail::load_u64_big_endian( rhs + 8 );
+                                    return ( l > r ) - ( l < r );
+                                }
+    static constexpr std::size_t hash( const char* p ) {
+                                    const unsigned __int128 word = load( p );
+                                    const std::uint64_t low = static_cast<std::uint64_t>( word );
+                                    const std::uint64_t high = static_cast<std::uint64_t>( word >> 64 );
+                                    return static_cast<std::size_t>( hash::mix64( low ^ hash::mix64( high ) ) );
+                                }
+};
+#endif
+
+// A pointer to a null-terminated string, or a (non-const) char buffer which
+// may hold a shorter one. String literals are const arrays, so don't match
+// and instead pick the array overloads, which search no further than the
+// array's bound (and for a literal, not at all once inlined).
+template<typename T>
+concept c_string = std::is_convertible_v<T, const char*> &&
+                   !( std::is_array_v<std::remove_reference_t<T>> && std::is_const_v<std::remove_reference_t<T>> );
+
+// Strings of up to 16 bytes, whatever their policy, are ordered as a single
+// integer: the bytes loaded big-endian (so the first differing character
+// decides) with everything from the terminator on masked to zero.
+template<std::size_t size>
+struct ordering_word {
+#if defined(__SIZEOF_INT128__)
+    static const bool in_register = size <= 16;
+    using type = typename std::conditional<( size <= 8 ), std::uint64_t, unsigned __int128>::type;
+#else
+    static const bool in_register = size <= 8;
+    using type = std::uint64_t;
+#endif
+};
+template<typename word_type, std::size_t size>
+inline word_type ordering_key( const char* p, std::size_t length ) {
+    char bytes[sizeof( word_type )] = {};
+    std::memcpy( bytes, p, size );
+
+    word_type word = simd::detail::load_u64_big_endian( bytes );
+    if constexpr( sizeof( word_type ) > 8 ) {
+        word = ( word << 64 ) | simd::detail::load_u64_big_endian( bytes + 8 );
+    }
+
+    // keep the top 'length' bytes (length < size, there's always a terminator);
+    // strings equal up to the shorter length then still need their lengths compared
+    return ( length != 0 ) ? ( word & ~( ~word_type( 0 ) >> ( 8 * length ) ) ) : 0;
+}
+
+// register-sized strings are kept zero-padded by default, which costs nothing
+// (every write is a whole word anyway) and enables the single-word compares
+template<std::size_t size>
+struct default_policy {
+    using type = typename std::conditional<block<size>::in_register, zero_padding, lazy_padding>::type;
+};
+
+} // namespace detail
+
+template<size_t string_size,
+         typename policy = typename detail::default_policy<string_size>::type,
+         typename overflow_policy = assert_on_overflow>
 class string {
+    // the largest remaining capacity detail::capacity_trailer can store is 32767
+    static_assert( ( string_size > 0 ) && ( string_size <= 32768 ), "fl::string size must be between 1 and 32768" );
+
 public:
 
                                 // member types
@@ -47,240 +259,353 @@ public:
     using reverse_iterator      = std::reverse_iterator<iterator>;
     using const_reverse_iterator= std::reverse_iterator<const_iterator>;
     using size_type             = std::size_t;
-    using string_view           = std::experimental::basic_string_view<value_type, value_traits>;
+    using string_view           = std::basic_string_view<value_type, value_traits>;
+    using policy_type           = policy;
+    using overflow_policy_type  = overflow_policy;
 
-    static const std::size_t    npos = -1;
+    static constexpr size_type  npos = -1;
 
                                 // construction and assignment
-                                string();
-                                string( const string& str ); // TODO: Check size (template<N>)
-                                string( const_pointer s );
+    constexpr                   string();
+    constexpr                   string( const string& str ) = default;
+                                template<std::size_t N, typename... policies>
+    constexpr                   string( const string<N, policies...>& str );
+    constexpr explicit          string( string_view sv );
+                                template<detail::c_string T>
+    constexpr                   string( T&& s );
+                                template<std::size_t N>
+    constexpr                   string( const value_type (&s)[N] );
                                 // TODO: initializer_list<> & rvalue etc.
-                                ~string();
 
-       string&                  operator=( const string& str );
-       string&                  operator=( const_pointer s );
+    constexpr string&           operator=( const string& str ) = default;
+                                template<std::size_t N, typename... policies>
+    constexpr string&           operator=( const string<N, policies...>& str );
+    constexpr string&           operator=( string_view sv );
+                                template<detail::c_string T>
+    constexpr string&           operator=( T&& s );
+                                template<std::size_t N>
+    constexpr string&           operator=( const value_type (&s)[N] );
                                 // TODO: initializer_list<> & rvalue etc.
 
                                 // element access
-    inline reference            operator[]( size_type pos );
-    inline const_reference      operator[]( size_type pos ) const;
-    inline reference            at( size_type pos );
-    inline const_reference      at( size_type pos ) const;
-    inline reference            back();
-    inline const_reference      back() const;
-    inline reference            front();
-    inline const_reference      front() const;
-    inline const_pointer        c_str() const noexcept;
-    inline const_pointer        data() const noexcept { return &m_data[0]; }//{ return m_data.data(); }
-    inline                      operator string_view() const noexcept;
+    constexpr reference         operator[]( size_type pos );
+    constexpr const_reference   operator[]( size_type pos ) const;
+    constexpr reference         at( size_type pos );
+    constexpr const_reference   at( size_type pos ) const;
+    constexpr reference         back();
+    constexpr const_reference   back() const;
+    constexpr reference         front();
+    constexpr const_reference   front() const;
+    constexpr const_pointer     c_str() const noexcept;
+    constexpr const_pointer     data() const noexcept { return &m_data[0]; }//{ return m_data.data(); }
+    constexpr                   operator string_view() const noexcept;
 
                                 // iterators
-    inline iterator             begin();
-    inline const_iterator       cbegin() const;
-    inline iterator             end();
-    inline const_iterator       cend() const;
-    inline iterator             rbegin();
-    inline const_iterator       crbegin() const;
-    inline iterator             rend();
-    inline const_iterator       crend() const;
+    constexpr iterator          begin();
+    constexpr const_iterator    cbegin() const;
+    constexpr iterator          end();
+    constexpr const_iterator    cend() const;
+    constexpr iterator          rbegin();
+    constexpr const_iterator    crbegin() const;
+    constexpr iterator          rend();
+    constexpr const_iterator    crend() const;
 
                                 // capacity
-    inline size_type            size() const noexcept;
-    inline size_type            length() const noexcept;
-    inline size_type            max_size() const noexcept;
-    inline size_type            available() const noexcept;
-    inline bool                 empty() const noexcept;
+    constexpr size_type         size() const noexcept;
+    constexpr size_type         length() const noexcept;
+    constexpr size_type         max_size() const noexcept;
+    constexpr size_type         available() const noexcept;
+    constexpr bool              empty() const noexcept;
 
                                 // operations
-    inline void                 clear() noexcept;
-    inline void                 shallow_clear() noexcept;
+    constexpr void              clear() noexcept;
+    constexpr void              shallow_clear() noexcept; // same as clear() for zero_padding
+                                template<std::size_t N, typename... policies>
+    constexpr string&           operator+=( const string<N, policies...>& str );
+    constexpr string&           operator+=( string_view sv );
+                                template<detail::c_string T>
+    constexpr string&           operator+=( T&& s );
                                 template<std::size_t N>
-    inline string&              operator+=( const string<N>& str );
-    inline string&              operator+=( const_pointer s );
-                                template<std::size_t N>
-    inline int                  compare( const string<N>& str ) const;
-    size_type                   copy( pointer s, size_type len, size_type pos = 0 ) const;
+    constexpr string&           operator+=( const value_type (&s)[N] );
+                                template<std::size_t N, typename... policies>
+    constexpr int               compare( const string<N, policies...>& str ) const;
+    constexpr size_type         copy( pointer s, size_type len, size_type pos = 0 ) const;
 
                                 // search
-    size_type                   find( const string& str, size_type pos = 0 ) const;
-    size_type                   find( const_pointer s, size_type pos = 0 ) const;
-    size_type                   find( const_pointer s, size_type pos, size_type n ) const;
-    size_type                   find( value_type c, size_type pos = 0 ) const;
-    size_type                   find( string_view sv, size_type pos = 0 ) const;
+    constexpr size_type         find( const string& str, size_type pos = 0 ) const;
+    constexpr size_type         find( const_pointer s, size_type pos = 0 ) const;
+    constexpr size_type         find( const_pointer s, size_type pos, size_type n ) const;
+    constexpr size_type         find( value_type c, size_type pos = 0 ) const;
+    constexpr size_type         find( string_view sv, size_type pos = 0 ) const;
+    constexpr size_type         rfind( value_type c, size_type pos = npos ) const;
+    size_type                   find_first_of( string_view sv, size_type pos = 0 ) const;
+    size_type                   find_first_of( const_pointer s, size_type pos = 0 ) const;
+    size_type                   find_first_of( const_pointer s, size_type pos, size_type n ) const;
+    size_type                   find_first_of( value_type c, size_type pos = 0 ) const;
+    size_type                   find_last_of( string_view sv, size_type pos = npos ) const;
+    size_type                   find_last_of( const_pointer s, size_type pos = npos ) const;
+    size_type                   find_last_of( const_pointer s, size_type pos, size_type n ) const;
+    size_type                   find_last_of( value_type c, size_type pos = npos ) const;
+    size_type                   find_first_not_of( string_view sv, size_type pos = 0 ) const;
+    size_type                   find_first_not_of( const_pointer s, size_type pos = 0 ) const;
+    size_type                   find_first_not_of( const_pointer s, size_type pos, size_type n ) const;
+    size_type                   find_first_not_of( value_type c, size_type pos = 0 ) const;
+    size_type                   find_last_not_of( string_view sv, size_type pos = npos ) const;
+    size_type                   find_last_not_of( const_pointer s, size_type pos = npos ) const;
+    size_type                   find_last_not_of( const_pointer s, size_type pos, size_type n ) const;
+    size_type                   find_last_not_of( value_type c, size_type pos = npos ) const;
                                 // ...
 
-private:
-    //std::array<value_type,
-    //           string_size>      m_data;
+                                // public only so that fl::string is a structural type, and so
+                                // can be used as a non-type template parameter; not to be
+                                // touched directly
     value_type                  m_data[string_size];
 
-    void                        set_data( string_view sv );
-    size_type                   do_find( string_view sv, size_type pos, size_type n ) const;
-    string&                     do_concat( string_view sv );
+private:
+    constexpr void              set_data( string_view sv );
+    constexpr void              pad_tail( size_type pos ) noexcept;
+    constexpr void              set_available( size_type capacity ) noexcept;
+    constexpr size_type         do_find( string_view sv, size_type pos, size_type n ) const;
+                                template<typename matcher>
+    size_type                   do_find_first( const matcher& m, size_type pos, bool negate ) const;
+                                template<typename matcher>
+    size_type                   do_find_last( const matcher& m, size_type pos, bool negate ) const;
+    constexpr string&           do_concat( string_view sv );
+                                template<std::size_t N>
+    static constexpr string_view literal_view( const value_type (&s)[N] );
 };
 
-// construction and assignment
+// No destructor and defaulted copies: a string is just its bytes, so it can
+// be copied, moved and relocated with memcpy (std::vector growth, swaps in
+// std::sort, serialisation...).
+static_assert( std::is_trivially_copyable_v<string<8>> );
+static_assert( std::is_trivially_copyable_v<string<32>> );
+static_assert( std::is_trivially_copyable_v<string<33, zero_padding, throw_on_overflow>> );
+static_assert( std::is_standard_layout_v<string<32>> && ( sizeof( string<32> ) == 32 ) );
+
+// a string whose unused bytes are always zero (see zero_padding)
 template<std::size_t string_size>
-string<string_size>::string() {
-    m_data[string_size-1] = static_cast<value_type>( string_size-1 );
+using canonical_string = string<string_size, zero_padding>;
+
+// fl::string s = "GET"; deduces fl::string<4>
+template<std::size_t N>
+string( const char (&)[N] ) -> string<N>;
+
+// construction and assignment
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr string<string_size, policy, overflow_policy>::string() {
+    clear();
 }
-template<std::size_t string_size>
-string<string_size>::string( const string& str ) {
-    set_data( str.c_str() );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N, typename... policies>
+constexpr string<string_size, policy, overflow_policy>::string( const string<N, policies...>& str ) {
+    set_data( str );
 }
-template<std::size_t string_size>
-string<string_size>::string( const_pointer s ) {
-    set_data( s );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr string<string_size, policy, overflow_policy>::string( string_view sv ) {
+    set_data( sv );
 }
-template<std::size_t string_size>
-string<string_size>::~string() {
-    // do nothing
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<detail::c_string T>
+constexpr string<string_size, policy, overflow_policy>::string( T&& s ) {
+    set_data( string_view( s ) );
 }
-template<std::size_t string_size>
-string<string_size>& string<string_size>::operator=( const string& str ) {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N>
+constexpr string<string_size, policy, overflow_policy>::string( const value_type (&s)[N] ) {
+    set_data( literal_view( s ) );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N, typename... policies>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator=( const string<N, policies...>& str ) {
     set_data( str );
     return *this;
 }
-template<std::size_t string_size>
-string<string_size>& string<string_size>::operator=( const_pointer s ) {
-    set_data( string_view( s, value_traits::length( s ) ) );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator=( string_view sv ) {
+    set_data( sv );
+    return *this;
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<detail::c_string T>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator=( T&& s ) {
+    set_data( string_view( s ) );
+    return *this;
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator=( const value_type (&s)[N] ) {
+    set_data( literal_view( s ) );
     return *this;
 }
 
 // element access
-template<std::size_t string_size>
-inline typename string<string_size>::reference string<string_size>::operator[]( size_type pos ) { 
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::reference string<string_size, policy, overflow_policy>::operator[]( size_type pos ) { 
     return m_data[pos];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_reference string<string_size>::operator[]( size_type pos ) const { 
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_reference string<string_size, policy, overflow_policy>::operator[]( size_type pos ) const { 
     return m_data[pos];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::reference string<string_size>::at( size_type pos ) {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::reference string<string_size, policy, overflow_policy>::at( size_type pos ) {
     return m_data[pos];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_reference string<string_size>::at( size_type pos ) const { 
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_reference string<string_size, policy, overflow_policy>::at( size_type pos ) const { 
     return m_data[pos];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::reference string<string_size>::back() { 
-    // subtract the remaining capacity in the string' last byte from the string length
-    // to get the 'back'/last character (+1 to handle the null-terminator)
-    return m_data[string_size-1 - static_cast<size_type>( m_data[string_size-1] + 1 )];
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::reference string<string_size, policy, overflow_policy>::back() { 
+    return m_data[length()-1];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_reference string<string_size>::back() const {
-    // subtract the remaining capacity in the string' last byte from the string length
-    // to get the 'back'/last character (+1 to handle the null-terminator)
-    return m_data[string_size-1 - static_cast<size_type>( m_data[string_size-1] + 1 )];
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_reference string<string_size, policy, overflow_policy>::back() const {
+    return m_data[length()-1];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::reference string<string_size>::front() { 
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::reference string<string_size, policy, overflow_policy>::front() { 
     return m_data[0];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_reference string<string_size>::front() const { 
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_reference string<string_size, policy, overflow_policy>::front() const { 
     return m_data[0];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_pointer string<string_size>::c_str() const noexcept {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_pointer string<string_size, policy, overflow_policy>::c_str() const noexcept {
     return &m_data[0];//m_data.data();
 }
 #if 0
-template<std::size_t string_size>
-inline typename string<string_size>::const_pointer string<string_size>::data() const noexcept {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_pointer string<string_size, policy, overflow_policy>::data() const noexcept {
     return m_data.data();
 }
 #endif
-template<std::size_t string_size>
-inline string<string_size>::operator string_view() const noexcept {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr string<string_size, policy, overflow_policy>::operator string_view() const noexcept {
     return string_view( &m_data[0]/*m_data.data()*/, string_size-1 - available() ); 
 }
 
 // iterators
-template<std::size_t string_size>
-inline typename string<string_size>::iterator string<string_size>::begin() {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::iterator string<string_size, policy, overflow_policy>::begin() {
     return &m_data[0];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_iterator string<string_size>::cbegin() const {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_iterator string<string_size, policy, overflow_policy>::cbegin() const {
     return const_cast<const_iterator>( &m_data[0] );
 }
-template<std::size_t string_size>
-inline typename string<string_size>::iterator string<string_size>::end() {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::iterator string<string_size, policy, overflow_policy>::end() {
     return &m_data[string_size];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_iterator string<string_size>::cend() const {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_iterator string<string_size, policy, overflow_policy>::cend() const {
     return const_cast<const_iterator>( &m_data[string_size] );
 }
-template<std::size_t string_size>
-inline typename string<string_size>::iterator string<string_size>::rbegin() {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::iterator string<string_size, policy, overflow_policy>::rbegin() {
     return &m_data[length()-1];
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_iterator string<string_size>::crbegin() const {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_iterator string<string_size, policy, overflow_policy>::crbegin() const {
     return const_cast<const_iterator>( &m_data[length()-1] );
 }
-template<std::size_t string_size>
-inline typename string<string_size>::iterator string<string_size>::rend() {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::iterator string<string_size, policy, overflow_policy>::rend() {
     return &m_data[0] - sizeof( value_type );
 }
-template<std::size_t string_size>
-inline typename string<string_size>::const_iterator string<string_size>::crend() const {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::const_iterator string<string_size, policy, overflow_policy>::crend() const {
     return const_cast<const_iterator>( &m_data[0] - sizeof( value_type ) );
 }
 
 // capacity
-template<std::size_t string_size>
-inline typename string<string_size>::size_type string<string_size>::size() const noexcept { 
-    return string_size-1 - static_cast<size_type>( m_data[string_size-1] );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::size() const noexcept { 
+    return string_size-1 - available();
 }
-template<std::size_t string_size>
-inline typename string<string_size>::size_type string<string_size>::length() const noexcept { 
-    return string_size-1 - static_cast<size_type>( m_data[string_size-1] );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::length() const noexcept { 
+    return string_size-1 - available();
 }
-template<std::size_t string_size>
-inline typename string<string_size>::size_type string<string_size>::max_size() const noexcept {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::max_size() const noexcept {
     return string_size;
 }
-template<std::size_t string_size>
-inline typename string<string_size>::size_type string<string_size>::available() const noexcept {
-    return static_cast<size_type>( m_data[string_size-1] );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::available() const noexcept {
+    return detail::capacity_trailer<string_size>::load( &m_data[0] );
 }
-template<std::size_t string_size>
-inline bool string<string_size>::empty() const noexcept {
-    return m_data[string_size-1] == static_cast<value_type>( string_size-1 ); 
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr bool string<string_size, policy, overflow_policy>::empty() const noexcept {
+    return available() == string_size-1;
 }
 
 // operations
-template<std::size_t string_size>
-inline void string<string_size>::clear() noexcept {
-    //memset( (void*)m_data.data(), 0x00, string_size-2 );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr void string<string_size, policy, overflow_policy>::clear() noexcept {
+    if( !std::is_constant_evaluated() && detail::block<string_size>::in_register ) {
+        detail::block<string_size>::clear( &m_data[0] );
+        return;
+    }
+
     m_data[0] = '\0';
-    m_data[string_size-1] = static_cast<value_type>( string_size-1 );
-    //std::cout << "clear(): m_data[0] = " << m_data[0] << ", m_data[string_size-1] = " << (int)m_data[string_size-1] << std::endl;
+    pad_tail( 1 );
+    set_available( string_size-1 );
 }
-template<std::size_t string_size>
-inline void string<string_size>::shallow_clear() noexcept {
-    m_data[0] = '\0';
-    m_data[string_size-1] = static_cast<value_type>( string_size-1 );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr void string<string_size, policy, overflow_policy>::shallow_clear() noexcept {
+    // the tail has to be re-zeroed for zero_padding, so this can't be shallow
+    clear();
 }
-template<std::size_t string_size>
-template<std::size_t N>
-inline string<string_size>& string<string_size>::operator+=( const string<N>& str ) {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N, typename... policies>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator+=( const string<N, policies...>& str ) {
     return do_concat( str );
 }
-template<std::size_t string_size>
-inline string<string_size>& string<string_size>::operator+=( const_pointer ch ) {
-    return do_concat( string_view( ch, value_traits::length( ch ) ) );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator+=( string_view sv ) {
+    return do_concat( sv );
 }
-template<std::size_t string_size>
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<detail::c_string T>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator+=( T&& s ) {
+    return do_concat( string_view( s ) );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
 template<std::size_t N>
-inline int string<string_size>::compare( const string<N>& str ) const {
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::operator+=( const value_type (&s)[N] ) {
+    return do_concat( literal_view( s ) );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N, typename... policies>
+constexpr int string<string_size, policy, overflow_policy>::compare( const string<N, policies...>& str ) const {
+    if constexpr( detail::ordering_word<( N > string_size ? N : string_size )>::in_register ) {
+        if( !std::is_constant_evaluated() ) {
+            using word_type = typename detail::ordering_word<( N > string_size ? N : string_size )>::type;
+            const word_type lhs = detail::ordering_key<word_type, string_size>( data(), length() );
+            const word_type rhs = detail::ordering_key<word_type, N>( str.data(), str.length() );
+            if( lhs != rhs ) {
+                return lhs < rhs ? -1 : 1;
+            }
+            // equal up to the shorter length (only differing by embedded nulls)
+            return ( length() > str.length() ) - ( length() < str.length() );
+        }
+    }
+    if constexpr( ( N == string_size ) && ( N <= 256 ) ) {
+        if( policy::zero_padded && string<N, policies...>::policy_type::zero_padded ) {
+            // both tails are zeroed, so everything but the (one byte) capacity
+            // trailer orders as the characters do
+            const int result = simd::block_compare<N-1>( data(), str.data() );
+            if( result != 0 ) {
+                return result;
+            }
+            return ( length() > str.length() ) - ( length() < str.length() );
+        }
+    }
+
     const size_type len = length();
     const size_type strlen = str.length();
     
@@ -291,135 +616,334 @@ inline int string<string_size>::compare( const string<N>& str ) const {
 
     return result;
 }
-template<std::size_t string_size>
-typename string<string_size>::size_type string<string_size>::copy( pointer s, size_type len, size_type pos ) const {
-    //assert( len <= string_size );
-    //assert( ( pos + len ) <= string_size );
-
-    size_type copied = 0;
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::copy( pointer s, size_type len, size_type pos ) const {
+    assert( pos <= length() );
 
-    for( auto i=pos; i<pos+len; ++i ) {
-        *s++ = m_data[i];
-        ++copied;
-    }
+    const size_type copied = std::min( len, length() - pos );
+    value_traits::copy( s, &m_data[pos], copied );
 
     return copied;
 }
 
 // search
-template<std::size_t string_size>
-typename string<string_size>::size_type string<string_size>:: find( const string& str, size_type pos ) const {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>:: find( const string& str, size_type pos ) const {
     return do_find( str, pos, str.length() );
 }
-template<std::size_t string_size>
-typename string<string_size>::size_type string<string_size>::find( const_pointer s, size_type pos ) const {
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find( const_pointer s, size_type pos ) const {
     const string_view sv( s, value_traits::length( s ) );
     return do_find( sv, pos, sv.length() );
 }
-template<std::size_t string_size>
-typename string<string_size>::size_type string<string_size>::find( const_pointer s, size_type pos, size_type n ) const {
-    const string_view sv( s, value_traits::length( s ) );
-    return do_find( sv, pos, n );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find( const_pointer s, size_type pos, size_type n ) const {
+    // only the first n characters of s are searched for, so no strlen() is needed
+    return do_find( string_view( s, n ), pos, n );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find( value_type c, size_type pos ) const {
+    if( std::is_constant_evaluated() ) {
+        const size_type len = length();
+        const_pointer found = ( pos < len ) ? value_traits::find( &m_data[pos], len - pos, c ) : nullptr;
+        return found ? static_cast<size_type>( found - &m_data[0] ) : npos;
+    }
+    return do_find_first( simd::char_matcher( c ), pos, false );
 }
-template<std::size_t string_size>
-typename string<string_size>::size_type string<string_size>::find( value_type c, size_type pos ) const {
-    size_type index = string::npos;
-
-    const size_type length_to_search = string_size - pos;
-
-    for( size_type i=pos; i<length_to_search; ++i ) {
-        if( m_data[i] == c ) {
-            index = i;
-            break;
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find( string_view sv, size_type pos ) const {
+    return do_find( sv, pos, sv.length() );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::rfind( value_type c, size_type pos ) const {
+    if( std::is_constant_evaluated() ) {
+        const size_type len = length();
+        for( size_type i = ( pos < len ) ? pos+1 : len; i-- > 0; ) {
+            if( m_data[i] == c ) {
+                return i;
+            }
         }
+        return npos;
     }
-
-    return index;
+    return do_find_last( simd::char_matcher( c ), pos, false );
 }
-template<std::size_t string_size>
-typename string<string_size>::size_type string<string_size>::find( string_view sv, size_type pos ) const {
-    return do_find( sv, pos, sv.length() );
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_of( string_view sv, size_type pos ) const {
+    return do_find_first( simd::char_set( sv.data(), sv.length() ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_of( const_pointer s, size_type pos ) const {
+    return do_find_first( simd::char_set( s, value_traits::length( s ) ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_of( const_pointer s, size_type pos, size_type n ) const {
+    return do_find_first( simd::char_set( s, n ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_of( value_type c, size_type pos ) const {
+    return do_find_first( simd::char_matcher( c ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_of( string_view sv, size_type pos ) const {
+    return do_find_last( simd::char_set( sv.data(), sv.length() ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_of( const_pointer s, size_type pos ) const {
+    return do_find_last( simd::char_set( s, value_traits::length( s ) ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_of( const_pointer s, size_type pos, size_type n ) const {
+    return do_find_last( simd::char_set( s, n ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_of( value_type c, size_type pos ) const {
+    return do_find_last( simd::char_matcher( c ), pos, false );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_not_of( string_view sv, size_type pos ) const {
+    return do_find_first( simd::char_set( sv.data(), sv.length() ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_not_of( const_pointer s, size_type pos ) const {
+    return do_find_first( simd::char_set( s, value_traits::length( s ) ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_not_of( const_pointer s, size_type pos, size_type n ) const {
+    return do_find_first( simd::char_set( s, n ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_first_not_of( value_type c, size_type pos ) const {
+    return do_find_first( simd::char_matcher( c ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_not_of( string_view sv, size_type pos ) const {
+    return do_find_last( simd::char_set( sv.data(), sv.length() ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_not_of( const_pointer s, size_type pos ) const {
+    return do_find_last( simd::char_set( s, value_traits::length( s ) ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_not_of( const_pointer s, size_type pos, size_type n ) const {
+    return do_find_last( simd::char_set( s, n ), pos, true );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::find_last_not_of( value_type c, size_type pos ) const {
+    return do_find_last( simd::char_matcher( c ), pos, true );
 }
 
 // private functions
-template<std::size_t string_size>
-void string<string_size>::set_data( string_view sv ) {
-    // TODO: use static_assert here
-    //assert( length < string_size );//, "flstring::set_data() please allocate more space." );
-
-    const_pointer strdata = sv.data();
-    pointer data = &m_data[0];
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr void string<string_size, policy, overflow_policy>::set_data( string_view sv ) {
+    const size_type len = overflow_policy::fit( sv.length(), string_size-1 );
+
+    if( !std::is_constant_evaluated() && detail::block<string_size>::in_register ) {
+        // assemble the whole string in a register-sized temporary and store it
+        // in one go, the tail comes out zeroed regardless of policy
+        value_type block[string_size] = {};
+        std::memcpy( block, sv.data(), len );
+        block[string_size-1] = static_cast<value_type>( string_size-1 - len );
+        std::memcpy( &m_data[0], block, string_size );
+        return;
+    }
 
-    while( *strdata ) { 
-        *data++ = *strdata++;
+    // the length is known, so this is a single bulk copy rather than a
+    // byte-at-a-time loop looking for the terminator
+    value_traits::copy( &m_data[0], sv.data(), len );
+    m_data[len] = '\0';
+    pad_tail( len+1 );
+
+    // store the remaining capacity in the last element(s), a capacity of
+    // zero being the already inserted null-terminator (above)
+    set_available( string_size-1 - len );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr void string<string_size, policy, overflow_policy>::pad_tail( size_type pos ) noexcept {
+    // zero everything from pos up to (but not including) the capacity byte.
+    // Always done at compile-time, a constant can't hold indeterminate bytes
+    // (and NTTP equivalence compares the whole buffer)
+    if( ( policy::zero_padded || std::is_constant_evaluated() ) && ( pos < string_size-1 ) ) {
+        value_traits::assign( &m_data[pos], string_size-1 - pos, '\0' );
     }
-    *data = '\0';
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr void string<string_size, policy, overflow_policy>::set_available( size_type capacity ) noexcept {
+    detail::capacity_trailer<string_size>::store( &m_data[0], capacity );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::do_find( string_view sv, size_type pos, size_type n ) const {
+    // search stops at length(), but the whole buffer may be loaded so the
+    // vectorised kernel can run over the unused tail-space without overrunning
+    return simd::find( &m_data[0], length(), string_size, sv.data(), n, pos );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<typename matcher>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::do_find_first( const matcher& m, size_type pos, bool negate ) const {
+    return simd::find_first( &m_data[0], length(), string_size, m, pos, negate );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<typename matcher>
+typename string<string_size, policy, overflow_policy>::size_type string<string_size, policy, overflow_policy>::do_find_last( const matcher& m, size_type pos, bool negate ) const {
+    return simd::find_last( &m_data[0], length(), string_size, m, pos, negate );
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr string<string_size, policy, overflow_policy>& string<string_size, policy, overflow_policy>::do_concat( string_view sv ) {
+    const size_type pos = length();
+    const size_type len = overflow_policy::fit( sv.length(), string_size-1 - pos );
+
+    // the tail past the old terminator is already zero for zero_padding,
+    // so only the new characters and terminator need writing
+    value_traits::copy( &m_data[pos], sv.data(), len );
+    m_data[pos+len] = '\0';
 
-    // store the remaining capacity in the last element if non-zero,
-    // otherwise the already inserted null-terminator(above) will 
-    // be doubling-up as a remaining capacity of zero
-    if( data != &m_data[string_size-1] ) {
-        m_data[string_size-1] = static_cast<value_type>( string_size-1 - sv.length() );
+    set_available( string_size-1 - ( pos+len ) );
+
+    return *this;
+}
+template<std::size_t string_size, typename policy, typename overflow_policy>
+template<std::size_t N>
+constexpr typename string<string_size, policy, overflow_policy>::string_view string<string_size, policy, overflow_policy>::literal_view( const value_type (&s)[N] ) {
+    // up to the first terminator, which for a literal is its last element (and
+    // the search folds away to that), but a const buffer may hold a shorter
+    // string, or fill the array with no terminator at all
+    const value_type* terminator = value_traits::find( s, N, value_type() );
+    return string_view( s, terminator ? static_cast<size_type>( terminator - s ) : N );
+}
+
+template<std::size_t lhs_size, typename... lhs_policies, std::size_t rhs_size, typename... rhs_policies>
+constexpr bool operator==( const string<lhs_size, lhs_policies...>& lhs, const string<rhs_size, rhs_policies...>& rhs ) {
+    if constexpr( ( lhs_size == rhs_size ) &&
+                  string<lhs_size, lhs_policies...>::policy_type::zero_padded &&
+                  string<rhs_size, rhs_policies...>::policy_type::zero_padded ) {
+        return detail::block<lhs_size>::equal( lhs.data(), rhs.data() );
+    } else {
+        const std::size_t length = lhs.length();
+        return ( length == rhs.length() ) && ( std::char_traits<char>::compare( lhs.data(), rhs.data(), length ) == 0 );
     }
 }
-template<std::size_t string_size>
-typename string<string_size>::size_type    string<string_size>::do_find( string_view sv, size_type pos, size_type n ) const {
-    //const size_type target_size = sv.length() - n;
-    //assert( target_size <= string_size );
-    //assert( ( pos + target_size ) <= string_size );
-
-    size_type index = string::npos;
-
-    const size_type length_to_search = string_size - pos;
-    const_pointer target_string = sv.data();
-
-    for( size_type i=pos; i<length_to_search; ++i ) {
-        if( m_data[i] == *target_string ) {
-            auto j = i;
-            auto ptr = target_string;
-            do {
-                ++j;
-                ++ptr;
-            } while( ( *ptr != '\0' ) && ( m_data[j] == *ptr ) );
-
-            // a null pointer (null terminator) would indicate
-            // that we've matched the entire string we were
-            // looking for, so we're safe to return this index
-            if( *ptr == '\0' ) {
-                index = i;
-                break;
-            }
-        }
+// a strict (total) ordering, matching std::string's; <, <=, >, >= and != are
+// all derived from this and operator==
+template<std::size_t lhs_size, typename... lhs_policies, std::size_t rhs_size, typename... rhs_policies>
+constexpr std::strong_ordering operator<=>( const string<lhs_size, lhs_policies...>& lhs, const string<rhs_size, rhs_policies...>& rhs ) {
+    return lhs.compare( rhs ) <=> 0;
+}
+
+// Hash of the string's contents. Zero-padded strings are hashed as a whole
+// block (a single multiply-xorshift for register-sized strings), otherwise
+// only the length() characters are hashed, never the garbage after them.
+template<std::size_t string_size, typename policy, typename overflow_policy>
+constexpr std::size_t hash_value( const string<string_size, policy, overflow_policy>& str ) {
+    if constexpr( policy::zero_padded ) {
+        return detail::block<string_size>::hash( str.data() );
+    } else {
+        return static_cast<std::size_t>( hash::hash64<string_size-1>( str.data(), str.length() ) );
     }
+}
 
-    return index;
+// hash_value() of count strings, into out; for building tables or joining in
+// bulk. hash_value() has no dependency from one key to the next, so a plain
+// loop already keeps several keys' multiply chains in flight at once (running
+// hash64() over keys in lockstep measured slower, not faster).
+template<std::size_t string_size, typename policy, typename overflow_policy>
+void hash_batch( const string<string_size, policy, overflow_policy>* keys, std::size_t count, std::uint64_t* out ) {
+    for( std::size_t i=0; i<count; ++i ) {
+        out[i] = static_cast<std::uint64_t>( hash_value( keys[i] ) );
+    }
 }
-template<std::size_t string_size>
-string<string_size>& string<string_size>::do_concat( string_view sv ) {
-    //assert( ( length() + strlen ) <= max_size() );
 
-    const_pointer strdata = sv.data();
-    pointer data = &m_data[length()];
-    while( *strdata ) { 
-        *data++ = *strdata++;
+// Transparent hash, equality and ordering for containers keyed on fl::string.
+// const char*, std::string_view, std::string and fl::string of any size and
+// policy hash, compare and order alike (by their characters alone), so that
+// find() can be given any of them without a temporary key being built.
+struct string_hash {
+    using is_transparent = void;
+
+    template<std::size_t string_size, typename... policies>
+    constexpr std::size_t operator()( const string<string_size, policies...>& str ) const noexcept {
+        return static_cast<std::size_t>( hash::hash64<string_size-1>( str.data(), str.length() ) );
     }
-    *data = '\0';
+    constexpr std::size_t operator()( std::string_view sv ) const noexcept {
+        return static_cast<std::size_t>( hash::hash64( sv.data(), sv.length() ) );
+    }
+};
+struct string_equal {
+    using is_transparent = void;
 
-    if( data != &m_data[string_size-1] ) {
-        m_data[string_size-1] -= static_cast<value_type>( sv.length() );
+    template<std::size_t lhs_size, typename... lhs_policies, std::size_t rhs_size, typename... rhs_policies>
+    constexpr bool operator()( const string<lhs_size, lhs_policies...>& lhs, const string<rhs_size, rhs_policies...>& rhs ) const noexcept {
+        return lhs == rhs;
+    }
+    constexpr bool operator()( std::string_view lhs, std::string_view rhs ) const noexcept {
+        return lhs == rhs;
     }
+};
+struct string_less {
+    using is_transparent = void;
 
-    return *this;
+    template<std::size_t lhs_size, typename... lhs_policies, std::size_t rhs_size, typename... rhs_policies>
+    constexpr bool operator()( const string<lhs_size, lhs_policies...>& lhs, const string<rhs_size, rhs_policies...>& rhs ) const noexcept {
+        return lhs.compare( rhs ) < 0;
+    }
+    constexpr bool operator()( std::string_view lhs, std::string_view rhs ) const noexcept {
+        return lhs < rhs;
+    }
+};
+
+
+// Copies count objects from first to result (the ranges mustn't overlap),
+// as a single memcpy if T is trivially copyable, as fl::string always is.
+template<typename T>
+T* copy_n( const T* first, std::size_t count, T* result ) {
+    if constexpr( std::is_trivially_copyable_v<T> ) {
+        if( count != 0 ) {
+            std::memcpy( static_cast<void*>( result ), first, count * sizeof( T ) );
+        }
+        return result + count;
+    } else {
+        return std::copy_n( first, count, result );
+    }
+}
+
+// Moves count objects from first into the uninitialised storage at result,
+// ending the lifetime of the originals (e.g. when growing a buffer). For a
+// trivially copyable T that's a single memcpy and nothing to destroy.
+template<typename T>
+T* relocate( T* first, std::size_t count, T* result ) {
+    if constexpr( std::is_trivially_copyable_v<T> ) {
+        if( count != 0 ) {
+            std::memcpy( static_cast<void*>( result ), first, count * sizeof( T ) );
+        }
+        return result + count;
+    } else {
+        T* last = std::uninitialized_move_n( first, count, result ).second;
+        std::destroy_n( first, count );
+        return last;
+    }
 }
 
-// added for hash-map testing
-template<std::size_t lhs_size, std::size_t rhs_size>
-bool operator<( const string<lhs_size>& lhs, const string<rhs_size>& rhs ) {
-    return ( lhs.compare( rhs ) == -1 ) && ( lhs.length() < rhs.length() );
+namespace literals {
+
+// "GET"_fl gives a constexpr fl::string<4>, sized from the literal
+template<string s>
+constexpr auto operator""_fl() {
+    return s;
 }
 
+} // namespace literals
 
 } // namespace fl
 
+// so fl::string can be used as-is as a std::unordered_map/set key
+namespace std {
+
+template<std::size_t string_size, typename policy, typename overflow_policy>
+struct hash<fl::string<string_size, policy, overflow_policy>> {
+    std::size_t operator()( const fl::string<string_size, policy, overflow_policy>& str ) const noexcept {
+        return fl::hash_value( str );
+    }
+};
+
+} // namespace std
+
 
 #endif // FLSTRING_HPP
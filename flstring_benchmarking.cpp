@@ -23,1156 +23,1876 @@ using flstring = fl::string<32>;
 using flstring_sso = fl::string<8>;
 
 
-#if 0
-static std::size_t allocation_size = 0;
+// Every heap allocation in the program goes through here, and is reported to fl::bench's
+// allocation tracking (which ignores it unless tracking is on), so each benchmark run by the
+// harness also reports the allocations it made, and the bytes (asked for, and handed out).
+#include <cstdlib>
+#include <new>
+#include "flbench.hpp"
+// (GCC warns of malloc()/free() being paired with new/delete, once these are inlined)
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
 void* operator new( std::size_t n ) {
-    //std::cout << "operator new( " << size << " )" << std::endl;
-    allocation_size = n;
-    return malloc( n );
-}
-
-void operator delete( void *ptr ) noexcept {
-    free( ptr );
-}
-
-static std::size_t sso_size = 0;
-void force_stdstring_dynamic_alloc() {
-    // Currently, Clang has the largest SSO buffer (at 24 characters).
-    // So we loop enough times to make sure that even theirs will overflow
-    // and be forced into dynamic allocation >:)
-    for( auto i=1; i<24; ++i ) {
-        // Size of the string and a random character.
-        std::string( i, '*' );
-        if( allocation_size != 0 ) {
-            sso_size = i;
-            break;	
+    void* ptr = std::malloc( n ? n : 1 );
+    if( ptr == nullptr ) {
+        throw std::bad_alloc();
+    }
+    fl::bench::track_allocation( ptr, n );
+    return ptr;
+}
+void* operator new[]( std::size_t n ) {
+    return operator new( n );
+}
+void operator delete( void* ptr ) noexcept {
+    fl::bench::track_deallocation( ptr );
+    std::free( ptr );
+}
+void operator delete[]( void* ptr ) noexcept {
+    operator delete( ptr );
+}
+void operator delete( void* ptr, std::size_t ) noexcept {
+    operator delete( ptr );
+}
+void operator delete[]( void* ptr, std::size_t ) noexcept {
+    operator delete( ptr );
+}
+#if !defined( _MSC_VER )
+// over-aligned types (fl::btree_map's nodes, fl::sharded_map's shards); MSVC has no
+// std::aligned_alloc(), so there these go untracked, to the library's own operators
+void* operator new( std::size_t n, std::align_val_t alignment ) {
+    const std::size_t align = static_cast<std::size_t>( alignment );
+    void* ptr = std::aligned_alloc( align, ( ( n ? n : 1 ) + align - 1 ) & ~( align - 1 ) );
+    if( ptr == nullptr ) {
+        throw std::bad_alloc();
+    }
+    fl::bench::track_allocation( ptr, n );
+    return ptr;
+}
+void* operator new[]( std::size_t n, std::align_val_t alignment ) {
+    return operator new( n, alignment );
+}
+void operator delete( void* ptr, std::align_val_t ) noexcept {
+    operator delete( ptr );
+}
+void operator delete[]( void* ptr, std::align_val_t ) noexcept {
+    operator delete( ptr );
+}
+void operator delete( void* ptr, std::size_t, std::align_val_t ) noexcept {
+    operator delete( ptr );
+}
+void operator delete[]( void* ptr, std::size_t, std::align_val_t ) noexcept {
+    operator delete( ptr );
+}
+#endif
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic pop
+#endif
+
+// The smallest length of std::string that goes to the heap, i.e. the SSO buffer size + 1.
+std::size_t stdStringHeapThreshold() {
+    // Currently, Clang has the largest SSO buffer (at 22 characters), so 64 is plenty
+    for( std::size_t length=1; length<64; ++length ) {
+        const auto stats = fl::bench::count_allocations( [&]() {
+            std::string str( length, '*' );
+            fl::bench::do_not_optimize( str );
+        } );
+        if( stats.count != 0 ) {
+            return length;
         }
     }
+    return 0;
 }
 
+// Bytes taken by a string: the object, and whatever it holds on the heap.
+template<typename string_type>
+void reportFootprint( const char* name, const char* text ) {
+    const auto stats = fl::bench::count_allocations( [&]() {
+        string_type str( text );
+        fl::bench::do_not_optimize( str );
+    } );
+    const auto heap_bytes = static_cast<std::size_t>( stats.bytes );
+    const auto usable_bytes = static_cast<std::size_t>( stats.usable_bytes );
+
+    std::cout << name << " \"" << text << "\" takes: " << sizeof( string_type ) + heap_bytes << " bytes ("
+              << sizeof( string_type ) << " + " << heap_bytes << " on the heap, " << usable_bytes << " as allocated)." << std::endl;
+}
 
 void benchMemoryFootprint() {
     // Compare sizes of flstring and std::string with a message guaranted to fit within SSO.
-    {
-        std::cout << "---\nMemory Footprint (8 Character String): SSO\n---" << std::endl;
-
-        flstring_sso flstring( "8c fls." );
-        std::string stdstring( "8c std." );
-
-        std::cout << "\"" << flstring.data() << "\" takes: " << sizeof( flstring ) << " bytes." << std::endl;
-        std::cout << "\"" << stdstring.data() << "\" takes: " << sizeof( stdstring ) << " bytes." << std::endl;
-    }
+    std::cout << "---\nMemory Footprint (8 Character String): SSO\n---" << std::endl;
+    reportFootprint<flstring_sso>( "flstring_sso", "8c fls." );
+    reportFootprint<std::string>( "std::string", "8c std." );
 
     // Now with a message guaranteed -not- to fit within SSO.
-    {
-        std::cout << "---\nMemory Footprint (32 Character String): non-SSO\n---" << std::endl;
-
-        flstring flstring( "A 32 character flstring........" );
+    std::cout << "---\nMemory Footprint (32 Character String): non-SSO\n---" << std::endl;
+    reportFootprint<flstring>( "flstring", "A 32 character flstring........" );
+    reportFootprint<std::string>( "std::string", "A 32 character std::string....." );
+    std::cout << "*Your current std::string implementation goes to the heap from " << stdStringHeapThreshold() << " characters." << std::endl;
+}
 
-        force_stdstring_dynamic_alloc();
-        std::string stdstring( "A 32 character std::string.....", 31 /*, allocator*/ );
+// Single string operations, each timed by the harness over many calibrated iterations.
+// The strings are hidden from the optimiser (do_not_optimize()) on the way in and out,
+// so that neither the work nor its inputs can be folded away or hoisted out of the loop.
+using fl::bench::do_not_optimize;
+using fl::bench::clobber_memory;
+
+template<typename string_type>
+void benchConstruction( fl::bench::harness& harness, const char* name, const char* text ) {
+    harness.run( name, [&]() {
+        const char* source = text;
+        do_not_optimize( source );
+        string_type str( source );
+        do_not_optimize( str );
+    } );
+}
 
-        std::cout << "\"" << flstring.data() << "\" takes: " << sizeof( flstring ) << " bytes." << std::endl;
-        std::cout << "\"" << stdstring.data() << "\" takes: " << sizeof( stdstring ) + allocation_size << " bytes." << std::endl;
-        std::cout << "*Your current std::string implementation uses a " << sso_size << " byte SSO buffer." << std::endl;
-    }
+template<typename string_type>
+void benchAssignment( fl::bench::harness& harness, const char* name, const char* text ) {
+    string_type str;
+    harness.run( name, [&]() {
+        const char* source = text;
+        do_not_optimize( source );
+        str = source;
+        do_not_optimize( str );
+    } );
 }
-#endif
 
-void benchStringOperations() {
-#if 1
-    // Compare the time taken to create both an flstring and std::string - SSO.
-    {
-        std::cout << "---\nString Construction: via ctor( const char* ) SSO\n---" << std::endl;
+template<typename string_type>
+void benchIteration( fl::bench::harness& harness, const char* name, const char* text ) {
+    string_type str( text );
+    harness.run( name, [&]() {
+        do_not_optimize( str );
+        int marker = 0;
+        for( std::size_t i=0; i<str.length(); ++i ) {
+            marker |= str[i];
+        }
+        do_not_optimize( marker );
+    } );
+}
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring_sso flstring( "8c fls." );
-        auto stop = std::chrono::high_resolution_clock::now();
+template<typename string_type>
+void benchComparison( fl::bench::harness& harness, const char* name, const char* lhs_text, const char* rhs_text ) {
+    string_type lhs( lhs_text );
+    string_type rhs( rhs_text );
+    harness.run( name, [&]() {
+        do_not_optimize( lhs );
+        do_not_optimize( rhs );
+        const int result = lhs.compare( rhs );
+        do_not_optimize( result );
+    } );
+}
 
-        std::cout << "Creating flstring: \"" << flstring.data() << 
-            "\" using constructor \"flstring( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+// The string has to be reset each time (or it would overflow, or grow without end), so
+// this is the time for the assignment plus the concatenation.
+template<typename string_type>
+void benchConcatenation( fl::bench::harness& harness, const char* name, const char* text, const char* suffix ) {
+    string_type str;
+    harness.run( name, [&]() {
+        const char* source = suffix;
+        do_not_optimize( source );
+        str = text;
+        str += source;
+        do_not_optimize( str );
+    } );
+}
 
-        // ---
+// After the first iteration this clears an empty string, which takes the same path
+// through clear() as a full one (neither implementation looks at the old contents).
+template<typename string_type>
+void benchClear( fl::bench::harness& harness, const char* name, const char* text ) {
+    string_type str( text );
+    harness.run( name, [&]() {
+        do_not_optimize( str );
+        str.clear();
+        clobber_memory();
+    } );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        std::string stdstring( "8c std." );
-        stop = std::chrono::high_resolution_clock::now();
+void benchStringOperations( fl::bench::harness& harness ) {
+    std::cout << "---\nString Construction: via ctor( const char* ) SSO\n---" << std::endl;
+    benchConstruction<flstring_sso>( harness, "flstring ctor( const char* ) SSO", "8c fls." );
+    benchConstruction<std::string>( harness, "std::string ctor( const char* ) SSO", "8c std." );
 
-        std::cout << "Creating std::string: \"" << stdstring.data() << 
-            "\" using constructor \"string( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
-    }
+    std::cout << "---\nString Construction: via ctor( const char* ) non-SSO\n---" << std::endl;
+    benchConstruction<flstring>( harness, "flstring ctor( const char* ) non-SSO", "A 32 character flstring........" );
+    benchConstruction<std::string>( harness, "std::string ctor( const char* ) non-SSO", "A 32 character std::string....." );
 
-    // Compare the time taken to create both an flstring and std::string - non-SSO.
-    {
-        std::cout << "---\nString Construction: via ctor( const char* ) non-SSO\n---" << std::endl;
+    std::cout << "---\nString Construction: via operator=( const char* ) SSO\n---" << std::endl;
+    benchAssignment<flstring_sso>( harness, "flstring operator=( const char* ) SSO", "8c fls." );
+    benchAssignment<std::string>( harness, "std::string operator=( const char* ) SSO", "8c std." );
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring flstring( "A 32 character flstring........" );
-        auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "---\nString Construction: via operator=( const char* ) non-SSO\n---" << std::endl;
+    benchAssignment<flstring>( harness, "flstring operator=( const char* ) non-SSO", "A 32 character flstring........" );
+    benchAssignment<std::string>( harness, "std::string operator=( const char* ) non-SSO", "A 32 character std::string....." );
 
-        std::cout << "Creating flstring: \"" << flstring.data() << 
-            "\" using constructor \"flstring( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::cout << "---\nString Iteration: via operator[]( size_type ) SSO\n---" << std::endl;
+    benchIteration<flstring_sso>( harness, "flstring operator[]( size_type ) SSO", "8c fls." );
+    benchIteration<std::string>( harness, "std::string operator[]( size_type ) SSO", "8c std." );
 
-        // ---
+    std::cout << "---\nString Iteration: via operator[]( size_type ) non-SSO\n---" << std::endl;
+    benchIteration<flstring>( harness, "flstring operator[]( size_type ) non-SSO", "A 32 character flstring........" );
+    benchIteration<std::string>( harness, "std::string operator[]( size_type ) non-SSO", "A 32 character std::string....." );
 
-        start = std::chrono::high_resolution_clock::now();
-        std::string stdstring( "A 32 character std::string.....", 32 /*, allocator*/ );
-        stop = std::chrono::high_resolution_clock::now();
+    std::cout << "---\nString Comparison: Where (str0 == str1) SSO\n---" << std::endl;
+    benchComparison<flstring_sso>( harness, "flstring compare() equal SSO", "8c fls.", "8c fls." );
+    benchComparison<std::string>( harness, "std::string compare() equal SSO", "8c std.", "8c std." );
 
-        std::cout << "Creating std::string: \"" << stdstring.data() << 
-            "\" using constructor \"string( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
-    }
+    std::cout << "---\nString Comparison: Where (str0 == str1) non-SSO\n---" << std::endl;
+    benchComparison<flstring>( harness, "flstring compare() equal non-SSO", "A 32 character flstring........", "A 32 character flstring........" );
+    benchComparison<std::string>( harness, "std::string compare() equal non-SSO", "A 32 character std::string.....", "A 32 character std::string....." );
 
-    // Compare the time taken to create both an flstring and std::string using the assignment operator - SSO.
-    {
-        std::cout << "---\nString Construction: via operator=( const char* ) SSO\n---" << std::endl;
+    std::cout << "---\nString Comparison: Where (str0 != str1) SSO\n---" << std::endl;
+    benchComparison<flstring_sso>( harness, "flstring compare() unequal SSO", "8c fls.", "8c std." );
+    benchComparison<std::string>( harness, "std::string compare() unequal SSO", "8c std.", "8c fls." );
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring_sso flstring;
-        flstring = "8c fls.";
-        auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "---\nString Comparison: Where (str0 != str1) non-SSO\n---" << std::endl;
+    benchComparison<flstring>( harness, "flstring compare() unequal non-SSO", "A 32 character flstring........", "A 32 character std::string....." );
+    benchComparison<std::string>( harness, "std::string compare() unequal non-SSO", "A 32 character std::string.....", "A 32 character flstring........" );
 
-        std::cout << "Creating flstring: \"" << flstring.data() << 
-            "\" using \"operator=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::cout << "---\nString Concatenation: via operator=( const char* ) + operator+=( const char* ) - SSO\n---" << std::endl;
+    benchConcatenation<flstring_sso>( harness, "flstring operator+=( const char* ) SSO", "8c", " fls." );
+    benchConcatenation<std::string>( harness, "std::string operator+=( const char* ) SSO", "8c", " std." );
 
-        // ---
+    std::cout << "---\nString Concatenation: via operator=( const char* ) + operator+=( const char* ) - non-SSO\n---" << std::endl;
+    benchConcatenation<fl::string<64>>( harness, "fl::string<64> operator+=( const char* ) non-SSO", "A 32 character flstring........", "A 32 character flstring........" );
+    benchConcatenation<std::string>( harness, "std::string operator+=( const char* ) non-SSO", "A 32 character std::string.....", "A 32 character std::string....." );
 
-        start = std::chrono::high_resolution_clock::now();
-        std::string stdstring;
-        stdstring = "8c std.";
-        stop = std::chrono::high_resolution_clock::now();
+    std::cout << "---\nString Clear/Reset/Make-Empty: String must report length of 0 - SSO\n---" << std::endl;
+    benchClear<flstring_sso>( harness, "flstring clear() SSO", "8c fls." );
+    benchClear<std::string>( harness, "std::string clear() SSO", "8c std." );
 
-        std::cout << "Creating std::string: \"" << stdstring.data() << 
-            "\" using \"operator=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
-    }
+    std::cout << "---\nString Clear/Reset/Make-Empty: String must report length of 0 - non-SSO\n---" << std::endl;
+    benchClear<flstring>( harness, "flstring clear() non-SSO", "A 32 character flstring........" );
+    benchClear<std::string>( harness, "std::string clear() non-SSO", "A 32 character std::string....." );
+}
 
-    // Compare the time taken to create both an flstring and std::string using the assignment operator - non-SSO.
-    {
-        std::cout << "---\nString Construction: via operator=( const char* ) non-SSO\n---" << std::endl;
+// http://www.maltron.com/word-lists---qwerty-layout.html
+static const unsigned int key_count = 128;
+constexpr const char* const three_character_container_strings[key_count] = {
+    "aas", "aba", "abs", "ace", "act", "add", "ads", "adz", "aff", "aft",
+    "aga", "age", "arb", "arc", "are", "arf", "ars", "art", "ass", "ate",
+    "att", "ava", "ave", "awa", "awe", "axe", "baa", "bad", "bag", "bar",
+    "bas", "bat", "bed", "bee", "beg", "bet", "bra", "brr", "cab", "cad",
+    "car", "cat", "caw", "cee", "dab", "dad", "dag", "daw", "deb", "dee",
+    "dev", "dew", "dex", "ear", "eat", "ebb", "eff", "efs", "eft", "egg",
+    "era", "ere", "erg", "err", "ers", "ess", "eta", "eve", "ewe", "fad",
+    "fag", "far", "fas", "fat", "fax", "fed", "fee", "fer", "fet", "few",
+    "fez", "gab", "gad", "gae", "gag", "gar", "gas", "gat", "ged", "gee",
+    "get", "qat", "rad", "rag", "ras", "rat", "raw", "rax", "reb", "rec",
+    "red", "ree", "ref", "reg", "res", "ret", "rev", "rex", "rts", "sab",
+    "sac", "sad", "sae", "sag", "sat", "saw", "sax", "sea", "sec", "see",
+    "seg", "ser", "set", "sew", "sex", "tab", "tad", "tae"
+};
+constexpr const char* const seven_character_container_strings[key_count] = {
+    "abasers", "abaters", "abetted", "abetter", "abfarad", "abraded", "abrader", "abrades", "abreact", "abreast",
+    "abscess", "abwatts", "acceded", "acceder", "accedes", "accrete", "acerate", "acerber", "acetate", "acreage",
+    "actress", "addaxes", "address", "addrest", "advects", "adverbs", "adverse", "adverts", "aerated", "aerates",
+    "afeared", "affects", "afreets", "aggrade", "aggress", "agrafes", "agraffe", "arcaded", "arcades", "arrased",
+    "arrears", "arrests", "asceses", "asserts", "asswage", "attests", "attract", "avatars", "average", "averred",
+    "averted", "avgases", "awarded", "awardee", "awarder", "axseeds", "baccara", "baccate", "baddest", "badgers",
+    "bagasse", "baggage", "baggers", "barbate", "barbers", "barbets", "bareges", "bargees", "barrage", "barrets",
+    "barters", "barware", "bassets", "bassett", "bastard", "basters", "batters", "bawbees", "bazaars", "bearcat",
+    "bearded", "bearers", "beaters", "beavers", "bedders", "bedewed", "bedfast", "bedward", "bedwarf", "beebees",
+    "beeswax", "beezers", "befrets", "begazed", "begazes", "beggars", "berated", "berates", "bereave", "beretta",
+    "bergere", "bestead", "bestrew", "betaxed", "betters", "bewared", "bewares", "bracers", "bracted", "bradded",
+    "bragged", "bragger", "brassed", "brasses", "bravers", "bravest", "brawest", "brazers", "breaded", "breasts",
+    "breeder", "breezed", "breezes", "brevets", "brewage", "brewers", "cabaret", "cabbage"
+};
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring flstring;
-        flstring = "A 32 character flstring........";
-        auto stop = std::chrono::high_resolution_clock::now();
 
-        std::cout << "Creating flstring: \"" << flstring.data() << 
-            "\" using \"operator=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+#include <cstdlib>
+#include <map>
+// Creation (emplacing every key into an empty map, then destroying it) and 'random'
+// look-ups (by const char*, as a caller holding string literals would), per key.
+template<typename map_type, std::size_t lookup_count>
+void benchMapCreationAndLookup( fl::bench::harness& harness, const std::string& name, const char* const* key_strings,
+                                const std::array<unsigned int, lookup_count>& lookup_key_indices ) {
+    harness.run( name + " creation", [&]() {
+        map_type map;
+        for( unsigned int j=0; j<key_count; ++j ) {
+            map.emplace( key_strings[j], 0 );
+        }
+        do_not_optimize( map );
+    }, key_count );
 
-        // ---
+    map_type map;
+    for( unsigned int j=0; j<key_count; ++j ) {
+        map.emplace( key_strings[j], 0 );
+    }
+    harness.run( name + " look-up", [&]() {
+        for( auto& lookup : lookup_key_indices ) {
+            const char* key = key_strings[lookup];
+            do_not_optimize( key );
+            map.find( key )->second += 1;
+        }
+        clobber_memory();
+    }, lookup_count );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        std::string stdstring;
-        stdstring = "A 32 character std::string.....";
-        stop = std::chrono::high_resolution_clock::now();
+void benchOrderedMapOperations( fl::bench::harness& harness ) {
+    const unsigned int lookup_count = 256;
+    std::array<unsigned int, lookup_count> lookup_key_indices;
 
-        std::cout << "Creating std::string: \"" << stdstring.data() << 
-            "\" using \"operator=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    // Generate a random sequence of keys to look-up; this is intended to try and keep things fair.
+    // (rand() is left unseeded, so every run looks up the same keys, and runs can be compared.)
+    for( auto& key_index : lookup_key_indices ) {
+        key_index = rand() % (key_count-1) + 1;
     }
 
-    // Compare the time taken to iterate through an flstring and std::string using the [] operator - SSO.
-    {
-        std::cout << "---\nString Iteartion: via operator[]( size_type ) SSO\n---" << std::endl;
+    std::cout << "---\nUsing strings as keys in a std::map; Creation and Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
+    benchMapCreationAndLookup<std::map<fl::string<4>, unsigned int>>( harness, "flstring ordered_map (4 characters)", three_character_container_strings, lookup_key_indices );
+    benchMapCreationAndLookup<std::map<std::string, unsigned int>>( harness, "stdstring ordered_map (4 characters)", three_character_container_strings, lookup_key_indices );
 
-        flstring_sso flstring( "8c fls." );
-        const auto string_size = 8;
+    std::cout << "---\nUsing strings as keys in a std::map; Creation and Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
+    benchMapCreationAndLookup<std::map<fl::string<8>, unsigned int>>( harness, "flstring ordered_map (8 characters)", seven_character_container_strings, lookup_key_indices );
+    benchMapCreationAndLookup<std::map<std::string, unsigned int>>( harness, "stdstring ordered_map (8 characters)", seven_character_container_strings, lookup_key_indices );
+}
 
-        // Generate a 'random' value based on string contents and print it.
-        // (Trying to make sure the compiler doesn't optimise things out).
-        auto marker = 0;
+#include <unordered_map>
+#include "crc32.hpp"
+#include "flhash.hpp"
+// hash function: calculateCRC32() from crc32.hpp
 
-        auto start = std::chrono::high_resolution_clock::now();
-        for( auto i=0; i<string_size; ++i ) {
-            marker |= flstring[i];
-        }
-        auto stop = std::chrono::high_resolution_clock::now();
-        
-        std::cout << "Itearting flstring: \"" << flstring.data() << 
-            "\" using \"operator[]( size_type )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << "[" << marker << "]" << std::endl;
+/*
+unsigned long hashKey( fl::string<4> str ) {
+    return 0;
+}
+
+// hash key equal function
+bool keysEqual( fl::string<4> lhs, fl::string<4> rhs ) {
+    return lhs.compare( rhs ) == 0;
+}
+*/
+// Transparent (as fl::string_hash/fl::string_equal): fl::string<M> of any size,
+// const char*, std::string_view and std::string all hash and compare alike, by
+// their characters alone, so find() needn't build a temporary key.
+template<size_t strlen>
+class KeyHash {
+public:
+    using is_transparent = void;
+    unsigned long operator()( std::string_view key ) const {
+        return calculateCRC32( key );
+    };
+};
+template<size_t strlen>
+class KeyCompare : public fl::string_equal {
+};
 
-        // ---
+template<size_t strlen>
+class KeyHash_std {
+public:
+    using is_transparent = void;
+    unsigned long operator()( std::string_view key ) const {
+        return calculateCRC32( key );
+    };
+};
+class KeyCompare_std {
+public:
+    using is_transparent = void;
+    bool operator()( std::string_view lhs, std::string_view rhs ) const {
+        return lhs == rhs;
+    };
+};
 
-        std::string stdstring( "8c std." );
+void benchUnorderedMapOperations( fl::bench::harness& harness ) {
+    const unsigned int lookup_count = 256;
+    std::array<unsigned int, lookup_count> lookup_key_indices;
 
-        marker = 0;
-        start = std::chrono::high_resolution_clock::now();
-        for( auto i=0; i<string_size; ++i ) {
-            marker |= stdstring[i];
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        
-        std::cout << "Itearting flstring: \"" << stdstring.data() << 
-            "\" using \"operator[]( size_type )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << "[" << marker << "]" << std::endl;
+    // Generate a random sequence of keys to look-up; this is intended to try and keep things fair.
+    for( auto& key_index : lookup_key_indices ) {
+        key_index = rand() % (key_count-1) + 1;
     }
 
-    // Compare the time taken to iterate through an flstring and std::string using the [] operator - non-SSO.
-    {
-        std::cout << "---\nString Iteartion: via operator[]( size_type ) non-SSO\n---" << std::endl;
+    std::cout << "---\nUsing strings as keys in a std::unordered_map; Creation and Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
+    benchMapCreationAndLookup<std::unordered_map<fl::string<4>, unsigned int, KeyHash<4>, KeyCompare<4>>>(
+        harness, "flstring unordered_map (4 characters)", three_character_container_strings, lookup_key_indices );
+    benchMapCreationAndLookup<std::unordered_map<std::string, unsigned int, KeyHash_std<4>, KeyCompare_std>>(
+        harness, "stdstring unordered_map (4 characters)", three_character_container_strings, lookup_key_indices );
+
+    std::cout << "---\nUsing strings as keys in a std::unordered_map; Creation and Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
+    benchMapCreationAndLookup<std::unordered_map<fl::string<8>, unsigned int, KeyHash<8>, KeyCompare<8>>>(
+        harness, "flstring unordered_map (8 characters)", seven_character_container_strings, lookup_key_indices );
+    benchMapCreationAndLookup<std::unordered_map<std::string, unsigned int, KeyHash_std<8>, KeyCompare_std>>(
+        harness, "stdstring unordered_map (8 characters)", seven_character_container_strings, lookup_key_indices );
+}
 
-        flstring flstring( "A 32 character flstring........" );
-        const auto string_size = 32;
+// calculateCRC32() over every key, stored as fl::string<N> -vs- std::string.
+template<typename string_type>
+void benchCRC32Operation( fl::bench::harness& harness, const char* name, const char* const* key_strings ) {
+    std::array<string_type, key_count> keys;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        keys[i] = key_strings[i];
+    }
 
-        auto marker = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-        for( auto i=0; i<string_size; ++i ) {
-            marker |= flstring[i];
+    harness.run( name, [&]() {
+        do_not_optimize( keys );
+        unsigned int fingerprint = 0;
+        for( const auto& key : keys ) {
+            fingerprint |= calculateCRC32( key );
         }
-        auto stop = std::chrono::high_resolution_clock::now();
-        
-        std::cout << "Itearting flstring: \"" << flstring.data() << 
-            "\" using \"operator[]( size_type )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << "[" << marker << "]" << std::endl;
+        do_not_optimize( fingerprint );
+    }, key_count );
+}
 
-        // ---
+void benchCRC32Operations( fl::bench::harness& harness ) {
+    std::cout << "---\nCRC32 generation (" << key_count << " x 4 character keys inc. null-terminator)\n---" << std::endl;
+    benchCRC32Operation<fl::string<4>>( harness, "flstring CRC32 generation (4 characters)", three_character_container_strings );
+    benchCRC32Operation<std::string>( harness, "stdstring CRC32 generation (4 characters)", three_character_container_strings );
 
-        std::string stdstring( "A 32 character std::string....." );
+    std::cout << "---\nCRC32 generation (" << key_count << " x 8 character keys inc. null-terminator)\n---" << std::endl;
+    benchCRC32Operation<fl::string<8>>( harness, "flstring CRC32 generation (8 characters)", seven_character_container_strings );
+    benchCRC32Operation<std::string>( harness, "stdstring CRC32 generation (8 characters)", seven_character_container_strings );
+}
 
-        marker = 0;
-        start = std::chrono::high_resolution_clock::now();
-        for( auto i=0; i<string_size; ++i ) {
-            marker |= stdstring[i];
+// Filling, then copying, a std::vector of strings (per string). The vector's own buffer is
+// one allocation either way, so anything past that is the strings' own.
+#include <vector>
+template<typename string_type>
+void benchVectorOperation( fl::bench::harness& harness, const std::string& name, const std::vector<std::string>& texts ) {
+    harness.run( name + " fill", [&]() {
+        std::vector<string_type> strings;
+        strings.reserve( texts.size() );
+        for( const auto& text : texts ) {
+            strings.emplace_back( text.c_str() );
         }
-        stop = std::chrono::high_resolution_clock::now();		
-        
-        std::cout << "Itearting std::string: \"" << stdstring.data() << 
-            "\" using \"operator[]( size_type )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << "[" << marker << "]" << std::endl;
-    }
-#endif
-    // Compare the time taken to ...compare an flstring with another flstring and std::string with another std::string - SSO.
-    {
-        std::cout << "---\nString Comparison: Where (str0 == str1) SSO\n---" << std::endl;
+        do_not_optimize( strings );
+    }, texts.size() );
+
+    const std::vector<string_type> strings( texts.begin(), texts.end() );
+    harness.run( name + " copy", [&]() {
+        std::vector<string_type> copy( strings );
+        do_not_optimize( copy );
+    }, texts.size() );
+}
 
-        flstring_sso flstring0( "8c fls." );
-        flstring_sso flstring1( "8c fls." );		
+void benchVectorOperations( fl::bench::harness& harness ) {
+    const std::vector<std::string> short_texts( seven_character_container_strings, seven_character_container_strings + key_count );
+    std::vector<std::string> long_texts;
+    for( const auto& text : short_texts ) {
+        long_texts.push_back( text + " - a 31 character string" );
+    }
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring0.compare( flstring1 );
-        auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "---\nstd::vector of strings; Fill and Copy (" << key_count << " x 8 character strings inc. null-terminator)\n---" << std::endl;
+    benchVectorOperation<flstring_sso>( harness, "flstring vector (8 characters)", short_texts );
+    benchVectorOperation<std::string>( harness, "stdstring vector (8 characters)", short_texts );
 
-        std::cout << "Comparing flstring: \"" << flstring0.data() << 
-            "\" with flstring: \"" << flstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::cout << "---\nstd::vector of strings; Fill and Copy (" << key_count << " x 32 character strings inc. null-terminator)\n---" << std::endl;
+    benchVectorOperation<flstring>( harness, "flstring vector (32 characters)", long_texts );
+    benchVectorOperation<std::string>( harness, "stdstring vector (32 characters)", long_texts );
+}
 
-        // ---
+// Register-resident (N = 4, 8, 16) strings -vs- the generic template of the same size.
+// op( key, next key ) over every key, per key.
+template<typename string_type, typename operation>
+void benchKeyOperation( fl::bench::harness& harness, const std::string& name, const std::array<string_type, key_count>& keys, operation op ) {
+    harness.run( name, [&]() {
+        do_not_optimize( keys );
+        unsigned int marker = 0;
+        for( unsigned int j=0; j<key_count; ++j ) {
+            marker += op( keys[j], keys[( j+1 ) % key_count] );
+        }
+        do_not_optimize( marker );
+    }, key_count );
+}
 
-        std::string stdstring0( "8c std." );
-        std::string stdstring1( "8c std." );		
+template<std::size_t N, typename operation>
+void benchRegisterResidentOperation( fl::bench::harness& harness, const char* name, const std::array<fl::string<N, fl::lazy_padding>, key_count>& generic_keys,
+                                     const std::array<fl::string<N>, key_count>& register_keys, operation op ) {
+    benchKeyOperation( harness, "generic fl::string<" + std::to_string( N ) + "> " + name, generic_keys, op );
+    benchKeyOperation( harness, "register fl::string<" + std::to_string( N ) + "> " + name, register_keys, op );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring0.compare( stdstring1 );
-        stop = std::chrono::high_resolution_clock::now();
+template<std::size_t N>
+void benchRegisterResidentOperations( fl::bench::harness& harness, const char* const* key_strings ) {
+    std::cout << "---\nRegister-resident fl::string<" << N << "> -vs- generic fl::string<" << N << ", lazy_padding> (" << key_count << " keys)\n---" << std::endl;
 
-        std::cout << "Comparing stdstring: \"" << stdstring0.data() << 
-            "\" with stdstring: \"" << stdstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::array<fl::string<N, fl::lazy_padding>, key_count> generic_keys;
+    std::array<fl::string<N>, key_count> register_keys;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        generic_keys[i] = key_strings[i];
+        register_keys[i] = key_strings[i];
     }
 
-    // Compare the time taken to ...compare an flstring with another flstring and std::string with another std::string - non-SSO.
-    {
-        std::cout << "---\nString Comparison: Where (str0 == str1) non-SSO\n---" << std::endl;
-
-        flstring flstring0( "A 32 character flstring........" );
-        flstring flstring1( "A 32 character flstring........" );		
+    benchRegisterResidentOperation<N>( harness, "operator==", generic_keys, register_keys, []( const auto& lhs, const auto& rhs ) {
+        return lhs == rhs ? 1u : 0u;
+    } );
+    benchRegisterResidentOperation<N>( harness, "compare()", generic_keys, register_keys, []( const auto& lhs, const auto& rhs ) {
+        return lhs.compare( rhs ) < 0 ? 1u : 0u;
+    } );
+    benchRegisterResidentOperation<N>( harness, "hash_value()", generic_keys, register_keys, []( const auto& lhs, const auto& ) {
+        return static_cast<unsigned int>( hash_value( lhs ) );
+    } );
+    benchRegisterResidentOperation<N>( harness, "copy", generic_keys, register_keys, []( const auto& lhs, const auto& ) {
+        typename std::decay<decltype( lhs )>::type copy( lhs );
+        return static_cast<unsigned int>( copy.length() );
+    } );
+    benchRegisterResidentOperation<N>( harness, "copy + clear()", generic_keys, register_keys, []( const auto& lhs, const auto& ) {
+        typename std::decay<decltype( lhs )>::type copy( lhs );
+        copy.clear();
+        return static_cast<unsigned int>( copy.length() );
+    } );
+}
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring0.compare( flstring1 );
-        auto stop = std::chrono::high_resolution_clock::now();
+// Hash functions from flhash.hpp -vs- calculateCRC32() from crc32.hpp.
+void benchHashOperations( fl::bench::harness& harness ) {
+    std::cout << "---\nHashing: short keys (" << key_count << " x 7 characters in an fl::string<32>)\n---" << std::endl;
 
-        std::cout << "Comparing flstring: \"" << flstring0.data() << 
-            "\" with flstring: \"" << flstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::array<fl::string<32, fl::lazy_padding>, key_count> keys;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        keys[i] = seven_character_container_strings[i];
+    }
 
-        // ---
+    benchKeyOperation( harness, "calculateCRC32() (byte-at-a-time), short keys", keys, []( const auto& key, const auto& ) {
+        return calculateCRC32( key );
+    } );
+    benchKeyOperation( harness, "fl::hash::crc32() (slice-by-8), short keys", keys, []( const auto& key, const auto& ) {
+        return fl::hash::crc32( key.data(), key.length() );
+    } );
+    benchKeyOperation( harness, "fl::hash::crc32c(), short keys", keys, []( const auto& key, const auto& ) {
+        return fl::hash::crc32c( key.data(), key.length() );
+    } );
+    benchKeyOperation( harness, "fl::hash::hash64(), short keys", keys, []( const auto& key, const auto& ) {
+        return static_cast<unsigned int>( fl::hash::hash64( key.data(), key.length() ) );
+    } );
 
-        std::string stdstring0( "A 32 character std::string....." );
-        std::string stdstring1( "A 32 character std::string....." );		
+    // ---
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring0.compare( stdstring1 );
-        stop = std::chrono::high_resolution_clock::now();
+    const std::size_t block_size = 4096;
+    std::cout << "---\nHashing: throughput (" << block_size << " byte block)\n---" << std::endl;
 
-        std::cout << "Comparing stdstring: \"" << stdstring0.data() << 
-            "\" with stdstring: \"" << stdstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::string block( block_size, '\0' );
+    for( std::size_t i=0; i<block_size; ++i ) {
+        block[i] = static_cast<char>( 'a' + i % 26 );
     }
+    auto benchBlock = [&]( const char* name, auto hash ) {
+        harness.run( std::string( name ) + ", " + std::to_string( block_size ) + " byte block", [&]() {
+            do_not_optimize( block );
+            const auto digest = hash();
+            do_not_optimize( digest );
+        } );
+    };
+    benchBlock( "calculateCRC32() (byte-at-a-time)", [&]() { return calculateCRC32( block ); } );
+    benchBlock( "fl::hash::crc32() (slice-by-8)", [&]() { return fl::hash::crc32( block.data(), block.size() ); } );
+    benchBlock( "fl::hash::crc32c()", [&]() { return fl::hash::crc32c( block.data(), block.size() ); } );
+    benchBlock( "fl::hash::hash64()", [&]() { return fl::hash::hash64( block.data(), block.size() ); } );
 
-    // Compare the time taken to ...compare an flstring with another flstring and std::string with another std::string - SSO.
-    {
-        std::cout << "---\nString Comparison: Where (str0 != str1) SSO\n---" << std::endl;
-
-        flstring_sso flstring0( "8c fls." );
-        flstring_sso flstring1( "8c std." );		
+    // ---
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring0.compare( flstring1 );
-        auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "---\nHashing: std::unordered_map lookups, KeyHash (CRC32) -vs- std::hash<fl::string> (8 character keys inc. null-terminator)\n---" << std::endl;
 
-        std::cout << "Comparing flstring: \"" << flstring0.data() << 
-            "\" with flstring: \"" << flstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::unordered_map<fl::string<8>, unsigned int, KeyHash<8>, KeyCompare<8>> crc_map;
+    std::unordered_map<fl::string<8>, unsigned int> std_hash_map;
+    std::array<fl::string<8>, key_count> lookup_keys;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        lookup_keys[i] = seven_character_container_strings[i];
+        crc_map.emplace( lookup_keys[i], i );
+        std_hash_map.emplace( lookup_keys[i], i );
+    }
+    benchKeyOperation( harness, "KeyHash<8> (calculateCRC32()) lookup", lookup_keys, [&]( const auto& key, const auto& ) {
+        return crc_map.find( key )->second;
+    } );
+    benchKeyOperation( harness, "std::hash<fl::string<8>> lookup", lookup_keys, [&]( const auto& key, const auto& ) {
+        return std_hash_map.find( key )->second;
+    } );
+}
 
-        // ---
+// Trivially copyable fl::string -vs- std::string when moved around in bulk (per element;
+// each operation takes long enough that a few samples will do).
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+void benchBulkOperations( fl::bench::harness& harness ) {
+    using bulk_string = fl::string<16>;
+    const std::size_t element_count = 1000000;
+    const unsigned int max_samples = 8;
+
+    std::cout << "---\nBulk operations: fl::string<16> -vs- std::string (" << element_count << " elements)\n---" << std::endl;
+
+    // distinct, shuffled keys so the sorts have some work to do
+    std::vector<std::string> std_keys( element_count );
+    std::vector<bulk_string> fl_keys( element_count );
+    unsigned int seed = 12345;
+    for( std::size_t i=0; i<element_count; ++i ) {
+        char key[16];
+        seed = seed * 1664525u + 1013904223u;
+        std::snprintf( key, sizeof( key ), "key-%08x", seed );
+        std_keys[i] = key;
+        fl_keys[i] = key;
+    }
 
-        std::string stdstring0( "8c std." );
-        std::string stdstring1( "8c fls." );		
+    // std::vector growth: every reallocation moves all of the elements
+    harness.run( "std::vector<std::string> push_back() growth", [&]() {
+        std::vector<std::string> strings;
+        for( const auto& key : std_keys ) {
+            strings.push_back( key );
+        }
+        do_not_optimize( strings );
+    }, element_count, max_samples );
+    harness.run( "std::vector<fl::string> push_back() growth", [&]() {
+        std::vector<bulk_string> strings;
+        for( const auto& key : fl_keys ) {
+            strings.push_back( key );
+        }
+        do_not_optimize( strings );
+    }, element_count, max_samples );
+
+    // hand-rolled doubling buffer: element-by-element relocation -vs- fl::relocate()
+    auto grow = [&]( auto relocate_elements ) {
+        std::size_t capacity = 16;
+        std::size_t size = 0;
+        bulk_string* buffer = static_cast<bulk_string*>( ::operator new( capacity * sizeof( bulk_string ) ) );
+        for( const auto& key : fl_keys ) {
+            if( size == capacity ) {
+                bulk_string* grown = static_cast<bulk_string*>( ::operator new( 2 * capacity * sizeof( bulk_string ) ) );
+                relocate_elements( buffer, size, grown );
+                ::operator delete( buffer );
+                buffer = grown;
+                capacity *= 2;
+            }
+            new( &buffer[size++] ) bulk_string( key );
+        }
+        do_not_optimize( buffer[size/2] );
+        ::operator delete( buffer );
+    };
+    harness.run( "Buffer growth, element-wise relocation", [&]() {
+        grow( []( bulk_string* first, std::size_t count, bulk_string* result ) {
+            for( std::size_t i=0; i<count; ++i ) {
+                new( &result[i] ) bulk_string( first[i].c_str() );
+            }
+        } );
+    }, element_count, max_samples );
+    harness.run( "Buffer growth, fl::relocate()", [&]() {
+        grow( []( bulk_string* first, std::size_t count, bulk_string* result ) {
+            fl::relocate( first, count, result );
+        } );
+    }, element_count, max_samples );
+
+    // bulk copy (e.g. snapshotting/serialising a table)
+    std::vector<bulk_string> fl_copies( element_count );
+    harness.run( "Bulk copy, element-wise (via c_str())", [&]() {
+        for( std::size_t i=0; i<element_count; ++i ) {
+            fl_copies[i] = fl_keys[i].c_str();
+        }
+        do_not_optimize( fl_copies );
+    }, element_count, max_samples );
+    harness.run( "Bulk copy, fl::copy_n()", [&]() {
+        fl::copy_n( fl_keys.data(), element_count, fl_copies.data() );
+        do_not_optimize( fl_copies );
+    }, element_count, max_samples );
+
+    // std::sort, swapping whole elements
+    std::vector<std::string> std_sorted;
+    harness.run( "std::sort() of std::string (incl. copy)", [&]() {
+        std_sorted = std_keys;
+        std::sort( std_sorted.begin(), std_sorted.end() );
+        do_not_optimize( std_sorted );
+    }, element_count, max_samples );
+    std::vector<bulk_string> fl_sorted;
+    harness.run( "std::sort() of fl::string (incl. copy)", [&]() {
+        fl_sorted = fl_keys;
+        std::sort( fl_sorted.begin(), fl_sorted.end(), []( const bulk_string& lhs, const bulk_string& rhs ) {
+            return lhs.compare( rhs ) < 0;
+        } );
+        do_not_optimize( fl_sorted );
+    }, element_count, max_samples );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring0.compare( stdstring1 );
-        stop = std::chrono::high_resolution_clock::now();
+// fl::flat_map -vs- std::unordered_map (node-based) with fl::string keys.
+#include "flflat_map.hpp"
+// Creation (inserting every key into an empty map, then destroying it), per key, and
+// 'random' look-ups (by an existing key), per look-up.
+template<typename map_type, typename key_vector>
+void benchMapCreationAndLookupByKey( fl::bench::harness& harness, const std::string& name, const key_vector& keys,
+                                     const std::vector<unsigned int>& lookup_key_indices, unsigned int max_samples ) {
+    harness.run( name + " creation", [&]() {
+        map_type map;
+        for( unsigned int j=0; j<keys.size(); ++j ) {
+            map.try_emplace( keys[j], j );
+        }
+        do_not_optimize( map );
+    }, keys.size(), max_samples );
 
-        std::cout << "Comparing stdstring: \"" << stdstring0.data() << 
-            "\" with stdstring: \"" << stdstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    map_type map;
+    for( unsigned int j=0; j<keys.size(); ++j ) {
+        map.try_emplace( keys[j], j );
     }
+    harness.run( name + " look-up", [&]() {
+        unsigned int marker = 0;
+        for( auto& lookup : lookup_key_indices ) {
+            marker += map.find( keys[lookup] )->second;
+        }
+        do_not_optimize( marker );
+    }, lookup_key_indices.size(), max_samples );
+}
 
-    // Compare the time taken to ...compare an flstring with another flstring and std::string with another std::string - non-SSO.
-    {
-        std::cout << "---\nString Comparison: Where (str0 != str1) non-SSO\n---" << std::endl;
+template<std::size_t N>
+void benchFlatMapOperation( fl::bench::harness& harness, const std::vector<fl::string<N>>& keys, const std::vector<unsigned int>& lookup_key_indices,
+                            unsigned int max_samples ) {
+    const std::string key_type = "fl::string<" + std::to_string( N ) + ">";
+    benchMapCreationAndLookupByKey<std::unordered_map<fl::string<N>, unsigned int, KeyHash<N>, KeyCompare<N>>>(
+        harness, "std::unordered_map<" + key_type + "> (KeyHash<" + std::to_string( N ) + ">)", keys, lookup_key_indices, max_samples );
+    benchMapCreationAndLookupByKey<std::unordered_map<fl::string<N>, unsigned int>>(
+        harness, "std::unordered_map<" + key_type + "> (std::hash)", keys, lookup_key_indices, max_samples );
+    benchMapCreationAndLookupByKey<fl::flat_map<N, unsigned int>>(
+        harness, "fl::flat_map<" + std::to_string( N ) + ">", keys, lookup_key_indices, max_samples );
+}
 
-        flstring flstring0( "A 32 character flstring........" );
-        flstring flstring1( "A 32 character std::string....." );		
+void benchFlatMapOperations( fl::bench::harness& harness ) {
+    const unsigned int lookup_count = 256;
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring0.compare( flstring1 );
-        auto stop = std::chrono::high_resolution_clock::now();
+    // Same keys and 'random' look-ups as benchUnorderedMapOperations()
+    std::vector<unsigned int> lookup_key_indices( lookup_count );
+    for( auto& key_index : lookup_key_indices ) {
+        key_index = rand() % (key_count-1) + 1;
+    }
 
-        std::cout << "Comparing flstring: \"" << flstring0.data() << 
-            "\" with flstring: \"" << flstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::cout << "---\nfl::flat_map -vs- std::unordered_map; Creation and Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
+    benchFlatMapOperation<4>( harness, std::vector<fl::string<4>>( three_character_container_strings, three_character_container_strings + key_count ),
+                              lookup_key_indices, harness.settings().sample_count );
+
+    std::cout << "---\nfl::flat_map -vs- std::unordered_map; Creation and Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
+    benchFlatMapOperation<8>( harness, std::vector<fl::string<8>>( seven_character_container_strings, seven_character_container_strings + key_count ),
+                              lookup_key_indices, harness.settings().sample_count );
+
+    // and once the table no longer fits in cache
+    const unsigned int large_key_count = 1 << 20;
+    std::vector<fl::string<16>> large_keys( large_key_count );
+    for( unsigned int i=0; i<large_key_count; ++i ) {
+        char key[16];
+        std::snprintf( key, sizeof( key ), "key-%08x", i * 2654435761u );
+        large_keys[i] = key;
+    }
+    std::vector<unsigned int> large_lookup_key_indices( large_key_count );
+    for( auto& key_index : large_lookup_key_indices ) {
+        key_index = static_cast<unsigned int>( rand() ) % large_key_count;
+    }
 
-        // ---
+    std::cout << "---\nfl::flat_map -vs- std::unordered_map; Creation and Lookup (" << large_key_count << " x 16 character keys inc. null-terminator)\n---" << std::endl;
+    benchFlatMapOperation<16>( harness, large_keys, large_lookup_key_indices, 4 );
+}
 
-        std::string stdstring0( "A 32 character std::string....." );
-        std::string stdstring1( "A 32 character flstring........" );		
+// Look-ups through a temporary fl::string key -vs- heterogeneous find(), per look-up.
+template<typename map_type, typename probe_type>
+void benchLookup( fl::bench::harness& harness, const std::string& name, const map_type& map, const std::vector<unsigned int>& lookup_key_indices,
+                  probe_type probe ) {
+    harness.run( name, [&]() {
+        unsigned int marker = 0;
+        for( auto& lookup : lookup_key_indices ) {
+            marker += map.find( probe( lookup ) )->second;
+        }
+        do_not_optimize( marker );
+    }, lookup_key_indices.size() );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring0.compare( stdstring1 );
-        stop = std::chrono::high_resolution_clock::now();
+template<typename map_type, std::size_t N>
+void benchHeterogeneousLookup( fl::bench::harness& harness, const char* name, const char* const* key_strings, const std::vector<unsigned int>& lookup_key_indices ) {
+    std::vector<fl::string<N>> keys( key_strings, key_strings + key_count );
+    std::vector<std::string_view> key_views( key_strings, key_strings + key_count );
 
-        std::cout << "Comparing stdstring: \"" << stdstring0.data() << 
-            "\" with stdstring: \"" << stdstring1.data() << "\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    map_type map;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        map.emplace( keys[i], i );
     }
-#if 1
-    // Compare the time taken to concatenate an flstring and using operator+=( const char * )  - SSO.
-    {
-        std::cout << "---\nString Concatenation: via operator+=( const char* ) - SSO\n---" << std::endl;
 
-        flstring_sso flstring( "8c" );
-        std::cout << "Concatenating a flstring: \"" << flstring.data() << "\"";
+    const std::string key_type = "fl::string<" + std::to_string( N ) + ">";
+    benchLookup( harness, std::string( name ) + " find( " + key_type + "( const char* ) )", map, lookup_key_indices, [&]( unsigned int i ) {
+        return fl::string<N>( key_strings[i] );
+    } );
+    benchLookup( harness, std::string( name ) + " find( const char* ), " + key_type + " keys", map, lookup_key_indices, [&]( unsigned int i ) {
+        return key_strings[i];
+    } );
+    benchLookup( harness, std::string( name ) + " find( std::string_view ), " + key_type + " keys", map, lookup_key_indices, [&]( unsigned int i ) {
+        return key_views[i];
+    } );
+    benchLookup( harness, std::string( name ) + " find( premade " + key_type + " )", map, lookup_key_indices, [&]( unsigned int i ) -> const fl::string<N>& {
+        return keys[i];
+    } );
+}
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring += " fls.";
-        auto stop = std::chrono::high_resolution_clock::now();
+void benchHeterogeneousLookups( fl::bench::harness& harness ) {
+    const unsigned int lookup_count = 256;
 
-        std::cout << " with \"fls." << 
-            "\" using \"operator+=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::vector<unsigned int> lookup_key_indices( lookup_count );
+    for( auto& key_index : lookup_key_indices ) {
+        key_index = rand() % (key_count-1) + 1;
+    }
 
-        // ---
+    std::cout << "---\nHeterogeneous look-up, transparent KeyHash/KeyCompare (4 character keys inc. null-terminator)\n---" << std::endl;
+    benchHeterogeneousLookup<std::unordered_map<fl::string<4>, unsigned int, KeyHash<4>, KeyCompare<4>>, 4>(
+        harness, "std::unordered_map", three_character_container_strings, lookup_key_indices );
+    benchHeterogeneousLookup<std::unordered_map<fl::string<4>, unsigned int, fl::string_hash, fl::string_equal>, 4>(
+        harness, "std::unordered_map (fl::string_hash)", three_character_container_strings, lookup_key_indices );
+    benchHeterogeneousLookup<std::map<fl::string<4>, unsigned int, fl::string_less>, 4>(
+        harness, "std::map (fl::string_less)", three_character_container_strings, lookup_key_indices );
+
+    std::cout << "---\nHeterogeneous look-up, transparent KeyHash/KeyCompare (8 character keys inc. null-terminator)\n---" << std::endl;
+    benchHeterogeneousLookup<std::unordered_map<fl::string<8>, unsigned int, KeyHash<8>, KeyCompare<8>>, 8>(
+        harness, "std::unordered_map", seven_character_container_strings, lookup_key_indices );
+    benchHeterogeneousLookup<std::unordered_map<fl::string<8>, unsigned int, fl::string_hash, fl::string_equal>, 8>(
+        harness, "std::unordered_map (fl::string_hash)", seven_character_container_strings, lookup_key_indices );
+    benchHeterogeneousLookup<std::map<fl::string<8>, unsigned int, fl::string_less>, 8>(
+        harness, "std::map (fl::string_less)", seven_character_container_strings, lookup_key_indices );
+}
 
-        std::string stdstring( "8c" );
-        std::cout << "Concatenating an std::string: \"" << stdstring.data() << "\"";
+// Ordered containers and sorting with the default (operator<) ordering. Past 100K keys
+// an operation takes long enough that a few samples will do.
+template<typename string_type>
+void benchOrderingOperation( fl::bench::harness& harness, const char* name, const std::vector<string_type>& keys, const std::vector<unsigned int>& lookup_key_indices ) {
+    const unsigned int max_samples = ( keys.size() <= 100000 ) ? harness.settings().sample_count : 3;
+    const std::string keys_name = " (" + std::to_string( keys.size() ) + " keys)";
+
+    std::map<string_type, unsigned int> map;
+    harness.run( std::string( "std::map<" ) + name + "> creation" + keys_name, [&]() {
+        map.clear();
+        for( unsigned int i=0; i<keys.size(); ++i ) {
+            map.emplace( keys[i], i );
+        }
+        do_not_optimize( map );
+    }, keys.size(), max_samples );
+    harness.run( std::string( "std::map<" ) + name + "> look-up" + keys_name, [&]() {
+        unsigned int marker = 0;
+        for( auto& lookup : lookup_key_indices ) {
+            marker += map.find( keys[lookup] )->second;
+        }
+        do_not_optimize( marker );
+    }, lookup_key_indices.size(), max_samples );
+    map.clear();
+
+    std::vector<string_type> sorted;
+    harness.run( std::string( "std::sort() of " ) + name + " (incl. copy)" + keys_name, [&]() {
+        sorted = keys;
+        std::sort( sorted.begin(), sorted.end() );
+        do_not_optimize( sorted );
+    }, keys.size(), max_samples );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring += " std.";
-        stop = std::chrono::high_resolution_clock::now();
+void benchOrderingOperations( fl::bench::harness& harness ) {
+    const unsigned int lookup_count = 1 << 16;
+
+    for( std::size_t key_count : { 1000, 10000, 100000, 1000000, 10000000 } ) {
+        // distinct, shuffled 12 character keys; both fit std::string's small buffer
+        std::vector<fl::string<16>> fl_keys( key_count );
+        std::vector<std::string> std_keys( key_count );
+        for( std::size_t i=0; i<key_count; ++i ) {
+            char key[16];
+            std::snprintf( key, sizeof( key ), "key-%08x", static_cast<unsigned int>( i ) * 2654435761u );
+            fl_keys[i] = key;
+            std_keys[i] = key;
+        }
+        std::vector<unsigned int> lookup_key_indices( lookup_count );
+        for( auto& key_index : lookup_key_indices ) {
+            key_index = static_cast<unsigned int>( rand() ) % key_count;
+        }
 
-        std::cout << " with \"std." << 
-            "\" using \"operator+=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+        std::cout << "---\nOrdered operations: fl::string<16> -vs- std::string (" << key_count << " keys)\n---" << std::endl;
+        benchOrderingOperation( harness, "fl::string<16>", fl_keys, lookup_key_indices );
+        benchOrderingOperation( harness, "std::string", std_keys, lookup_key_indices );
     }
+}
 
-    // Compare the time taken to concatenate an flstring and using operator+=( const char * )  - non-SSO.
-    {
-        std::cout << "---\nString Concatenation: via operator+=( const char* ) - non-SSO\n---" << std::endl;
-
-        fl::string<64> flstring( "A 32 character flstring........" );
-        std::cout << "Concatenating a flstring: \"" << flstring.data() << "\"";
-
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring += "A 32 character flstring........";
-        auto stop = std::chrono::high_resolution_clock::now();
-
-        std::cout << " with \"A 32 character flstring........" << 
-            "\" using \"operator+=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+// fl::sort() and fl::parallel_sort() -vs- std::sort(), per key.
+#include "flsort.hpp"
+template<std::size_t N>
+void benchSortOperation( fl::bench::harness& harness, std::size_t key_count, unsigned int key_length ) {
+    const unsigned int max_samples = ( key_count <= 100000 ) ? harness.settings().sample_count : 3;
+
+    // random hex 'session IDs'
+    std::vector<fl::string<N>> keys( key_count );
+    std::uint64_t seed = 12345;
+    for( auto& key : keys ) {
+        char id[N];
+        for( unsigned int i=0; i<key_length; ++i ) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            id[i] = "0123456789abcdef"[seed >> 60];
+        }
+        key = std::string_view( id, key_length );
+    }
 
-        // ---
+    std::cout << "---\nSorting " << key_count << " x fl::string<" << N << "> (" << key_length << " characters)\n---" << std::endl;
+    const std::string keys_name = " of " + std::to_string( key_count ) + " x fl::string<" + std::to_string( N ) + "> (incl. copy)";
+    std::vector<fl::string<N>> sorted;
+    harness.run( "std::sort()" + keys_name, [&]() {
+        sorted = keys;
+        std::sort( sorted.begin(), sorted.end() );
+        do_not_optimize( sorted );
+    }, key_count, max_samples );
+    harness.run( "fl::sort()" + keys_name, [&]() {
+        sorted = keys;
+        fl::sort( sorted.begin(), sorted.end() );
+        do_not_optimize( sorted );
+    }, key_count, max_samples );
+    // (with the calling thread unpinned, so that the sort's threads aren't all on --cpu's one core)
+    const fl::bench::unpinned unpinned;
+    harness.run( "fl::parallel_sort()" + keys_name + ", " + std::to_string( std::thread::hardware_concurrency() ) + " threads", [&]() {
+        sorted = keys;
+        fl::parallel_sort( sorted.begin(), sorted.end() );
+        do_not_optimize( sorted );
+    }, key_count, max_samples );
+}
 
-        std::string stdstring( "A 32 character std::string....." );
-        std::cout << "Concatenating a flstring: \"" << stdstring.data() << "\"";
+void benchSortOperations( fl::bench::harness& harness ) {
+    benchSortOperation<16>( harness, 10000, 15 );
+    benchSortOperation<16>( harness, 1000000, 15 );
+    benchSortOperation<16>( harness, 10000000, 15 );
+    benchSortOperation<64>( harness, 1000000, 40 );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring += "A 32 character std::string.....";
-        stop = std::chrono::high_resolution_clock::now();
+// fl::string_column<N> -vs- arrays of fl::string<N> and std::string, per row.
+#include "flcolumn.hpp"
+template<std::size_t N>
+void benchColumnOperation( fl::bench::harness& harness, std::size_t row_count ) {
+    const unsigned int max_samples = 8;
+
+    // random lengths (up to N-1) and characters
+    std::vector<std::string> rows( row_count );
+    std::uint64_t seed = 12345;
+    for( auto& row : rows ) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        row.assign( ( seed >> 33 ) % N, 'a' + ( seed >> 59 ) );
+    }
+    std::vector<const char*> row_pointers( row_count );
+    for( std::size_t i=0; i<row_count; ++i ) {
+        row_pointers[i] = rows[i].c_str();
+    }
 
-        std::cout << " with \"A 32 character std::string....." << 
-            "\" using \"operator+=( const char* )\" took: " <<
-            ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    std::cout << "---\nfl::string_column<" << N << "> -vs- std::vector<fl::string<" << N << ">> -vs- std::vector<std::string> ("
+              << row_count << " rows)\n---" << std::endl;
+    const std::string column_type = "fl::string_column<" + std::to_string( N ) + ">";
+    const std::string fl_type = "std::vector<fl::string<" + std::to_string( N ) + ">>";
+    const std::string std_type = "std::vector<std::string> (" + std::to_string( N - 1 ) + " characters at most)";
+
+    // (each leaves its rows behind, for the look-ups below)
+    std::vector<std::string> std_rows;
+    std::vector<fl::string<N>> fl_rows;
+    fl::string_column<N> column;
+    harness.run( std_type + " append", [&]() {
+        std_rows.clear();
+        std_rows.shrink_to_fit();
+        for( const char* row : row_pointers ) {
+            std_rows.emplace_back( row );
+        }
+        do_not_optimize( std_rows );
+    }, row_count, max_samples );
+    harness.run( fl_type + " append", [&]() {
+        fl_rows.clear();
+        fl_rows.shrink_to_fit();
+        for( const char* row : row_pointers ) {
+            fl_rows.emplace_back( row );
+        }
+        do_not_optimize( fl_rows );
+    }, row_count, max_samples );
+    harness.run( column_type + " push_back()", [&]() {
+        column = fl::string_column<N>();
+        for( const char* row : row_pointers ) {
+            column.push_back( row );
+        }
+        do_not_optimize( column );
+    }, row_count, max_samples );
+    harness.run( column_type + " bulk append()", [&]() {
+        column = fl::string_column<N>();
+        column.append( row_pointers.data(), row_count );
+        do_not_optimize( column );
+    }, row_count, max_samples );
+
+    // random access: total length of rows at 'random' positions
+    std::vector<unsigned int> positions( row_count );
+    for( auto& position : positions ) {
+        position = static_cast<unsigned int>( rand() ) % row_count;
     }
+    harness.run( std_type + " random access", [&]() {
+        std::size_t marker = 0;
+        for( auto position : positions ) {
+            marker += std_rows[position].length() + std_rows[position].data()[0];
+        }
+        do_not_optimize( marker );
+    }, row_count, max_samples );
+    harness.run( fl_type + " random access", [&]() {
+        std::size_t marker = 0;
+        for( auto position : positions ) {
+            marker += fl_rows[position].length() + fl_rows[position].data()[0];
+        }
+        do_not_optimize( marker );
+    }, row_count, max_samples );
+    harness.run( column_type + " random access", [&]() {
+        std::size_t marker = 0;
+        for( auto position : positions ) {
+            const std::string_view row = column[position];
+            marker += row.length() + row.data()[0];
+        }
+        do_not_optimize( marker );
+    }, row_count, max_samples );
 
-    // Compare the time taken to clear an flstring and std::string (string reports a length() of 0) - SSO.
-    {	
-        std::cout << "---\nString Clear/Reset/Make-Empty: String must report length of 0 - SSO\n---" << std::endl;
+    // memory (excluding the allocator's own per-allocation overhead)
+    std::size_t std_bytes = std_rows.capacity() * sizeof( std::string );
+    for( const auto& row : std_rows ) {
+        std_bytes += fl::bench::heap_bytes( row );
+    }
+    const std::size_t fl_bytes = fl_rows.capacity() * sizeof( fl::string<N> );
+    column.shrink_to_fit();
+    const std::size_t column_bytes = column.memory_usage();
 
-        flstring_sso flstring( "8c fls." );
+    std::cout << "std::vector<std::string> takes: " << std_bytes << " bytes." << std::endl;
+    std::cout << "std::vector<fl::string> takes: " << fl_bytes << " bytes." << std::endl;
+    std::cout << "fl::string_column takes: " << column_bytes << " bytes." << std::endl;
+}
 
-        std::cout << "Clearing flstring: \"" << flstring.data();
+void benchColumnOperations( fl::bench::harness& harness ) {
+    benchColumnOperation<16>( harness, 1000000 );
+    benchColumnOperation<32>( harness, 1000000 );
+}
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring.clear();
-        auto stop = std::chrono::high_resolution_clock::now();
+// Batch selections (fl::select_*()) -vs- std::find_if() loops, per row.
+#include "flbatch.hpp"
+template<typename container, typename predicate>
+std::size_t findIfAll( const container& strings, predicate match ) {
+    std::size_t selected = 0;
+    for( auto it = std::find_if( strings.begin(), strings.end(), match ); it != strings.end();
+         it = std::find_if( it + 1, strings.end(), match ) ) {
+        ++selected;
+    }
+    return selected;
+}
 
-        std::cout << "\" took: " << ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+template<std::size_t N>
+void benchBatchOperation( fl::bench::harness& harness, std::size_t row_count, const char* equal_pattern, const char* prefix_pattern, const char* search_pattern ) {
+    const unsigned int max_samples = 16;
+
+    // random 'records' from a small alphabet, so every pattern finds something
+    std::vector<std::string> std_rows( row_count );
+    std::vector<fl::string<N>> fl_rows( row_count );
+    fl::string_column<N> column;
+    std::uint64_t seed = 12345;
+    for( std::size_t i=0; i<row_count; ++i ) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::string row( 1 + ( seed >> 33 ) % ( N-1 ), 'a' );
+        for( auto& c : row ) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            c = "abcd"[seed >> 62];
+        }
+        std_rows[i] = row;
+        fl_rows[i] = std::string_view( row );
+        column.push_back( row );
+    }
+    std::vector<std::uint64_t> selection( fl::selection_words( row_count ) );
+
+    std::cout << "---\nBatch selection over " << row_count << " x fl::string<" << N << ">\n---" << std::endl;
+
+    auto report = [&]( const char* name, std::string_view pattern, auto std_predicate, auto fl_predicate, auto select ) {
+        const std::string selection_name = std::string( name ) + " \"" + std::string( pattern ) + "\", ";
+        const std::string fl_type = "fl::string<" + std::to_string( N ) + ">";
+        harness.run( selection_name + "std::find_if() over std::string", [&]() {
+            const std::size_t selected = findIfAll( std_rows, [&]( const std::string& row ) { return std_predicate( row, pattern ); } );
+            do_not_optimize( selected );
+        }, row_count, max_samples );
+        harness.run( selection_name + "std::find_if() over " + fl_type, [&]() {
+            const std::size_t selected = findIfAll( fl_rows, [&]( const fl::string<N>& row ) { return fl_predicate( row, pattern ); } );
+            do_not_optimize( selected );
+        }, row_count, max_samples );
+        harness.run( selection_name + "fl::select over " + fl_type + " array", [&]() {
+            const std::size_t selected = select( fl_rows.data(), row_count, pattern, selection.data(), std::false_type() );
+            do_not_optimize( selected );
+        }, row_count, max_samples );
+        harness.run( selection_name + "fl::select over fl::string_column<" + std::to_string( N ) + ">", [&]() {
+            const std::size_t selected = select( nullptr, 0, pattern, selection.data(), std::true_type() );
+            do_not_optimize( selected );
+        }, row_count, max_samples );
+    };
 
-        // TODO: ShallowClear()?
+    report( "Equal to", equal_pattern,
+            []( const std::string& row, std::string_view pattern ) { return row == pattern; },
+            []( const fl::string<N>& row, std::string_view pattern ) { return std::string_view( row ) == pattern; },
+            [&]( const fl::string<N>* rows, std::size_t count, std::string_view pattern, std::uint64_t* out, auto use_column ) {
+                return use_column ? fl::select_equal( column, pattern, out ) : fl::select_equal( rows, count, pattern, out );
+            } );
+    report( "Starts with", prefix_pattern,
+            []( const std::string& row, std::string_view pattern ) { return row.starts_with( pattern ); },
+            []( const fl::string<N>& row, std::string_view pattern ) { return std::string_view( row ).starts_with( pattern ); },
+            [&]( const fl::string<N>* rows, std::size_t count, std::string_view pattern, std::uint64_t* out, auto use_column ) {
+                return use_column ? fl::select_prefix( column, pattern, out ) : fl::select_prefix( rows, count, pattern, out );
+            } );
+    report( "Contains", search_pattern,
+            []( const std::string& row, std::string_view pattern ) { return row.find( pattern ) != std::string::npos; },
+            []( const fl::string<N>& row, std::string_view pattern ) { return row.find( pattern ) != fl::string<N>::npos; },
+            [&]( const fl::string<N>* rows, std::size_t count, std::string_view pattern, std::uint64_t* out, auto use_column ) {
+                return use_column ? fl::select_contains( column, pattern, out ) : fl::select_contains( rows, count, pattern, out );
+            } );
+}
 
-        // ---
+void benchBatchOperations( fl::bench::harness& harness ) {
+    benchBatchOperation<8>( harness, 1000000, "abc", "ab", "dd" );
+    benchBatchOperation<16>( harness, 1000000, "abcd", "abc", "dcba" );
+}
 
-        std::string stdstring( "8c std." );
+// fl::hash_batch() -vs- hashing one key at a time, per key.
+template<std::size_t N>
+void benchHashBatchOperation( fl::bench::harness& harness, std::size_t key_count ) {
+    const unsigned int max_samples = 16;
+
+    std::vector<fl::string<N>> keys( key_count );
+    std::uint64_t seed = 12345;
+    for( auto& key : keys ) {
+        char characters[N];
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        const std::size_t length = 1 + ( seed >> 33 ) % ( N-1 );
+        for( std::size_t i=0; i<length; ++i ) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            characters[i] = static_cast<char>( 'a' + ( seed >> 59 ) );
+        }
+        key = std::string_view( characters, length );
+    }
+    std::vector<std::uint64_t> hashes( key_count );
+
+    std::cout << "---\nHashing " << key_count << " x fl::string<" << N << ">"
+              << ( fl::string<N>::policy_type::zero_padded ? " (zero-padded)" : "" ) << "\n---" << std::endl;
+    const std::string keys_name = ", " + std::to_string( key_count ) + " x fl::string<" + std::to_string( N ) + ">";
+    harness.run( "calculateCRC32() per key" + keys_name, [&]() {
+        for( std::size_t i=0; i<key_count; ++i ) {
+            hashes[i] = calculateCRC32( keys[i] );
+        }
+        do_not_optimize( hashes );
+    }, key_count, max_samples );
+    harness.run( "hash_value() per key" + keys_name, [&]() {
+        for( std::size_t i=0; i<key_count; ++i ) {
+            hashes[i] = hash_value( keys[i] );
+        }
+        do_not_optimize( hashes );
+    }, key_count, max_samples );
+    harness.run( "fl::hash_batch()" + keys_name, [&]() {
+        fl::hash_batch( keys.data(), key_count, hashes.data() );
+        do_not_optimize( hashes );
+    }, key_count, max_samples );
+}
 
-        std::cout << "Clearing std::string: \"" << stdstring.data();
+void benchHashBatchOperations( fl::bench::harness& harness ) {
+    benchHashBatchOperation<4>( harness, 1000000 );
+    benchHashBatchOperation<8>( harness, 1000000 );
+    benchHashBatchOperation<16>( harness, 1000000 );
+    benchHashBatchOperation<32>( harness, 1000000 );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring.clear();
-        stop = std::chrono::high_resolution_clock::now();
-        
-        std::cout << "\" took: " << ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+// fl::static_map (perfect hash, built at compile time) -vs- hash maps built at run time.
+#include "flstatic_map.hpp"
+template<std::size_t N>
+constexpr std::array<fl::string<N, fl::zero_padding>, key_count> makeStaticKeys( const char* const* key_strings ) {
+    std::array<fl::string<N, fl::zero_padding>, key_count> keys = {};
+    for( unsigned int i=0; i<key_count; ++i ) {
+        keys[i] = key_strings[i];
     }
+    return keys;
+}
 
-    // Compare the time taken to clear an flstring and std::string (string reports a length() of 0) - non-SSO.
-    {	
-        std::cout << "---\nString Clear/Reset/Make-Empty: String must report length of 0 - non-SSO\n---" << std::endl;
+template<std::size_t N, typename static_map_type>
+void benchStaticMapOperation( fl::bench::harness& harness, const static_map_type& static_map, const char* const* key_strings,
+                              const std::vector<unsigned int>& lookup_key_indices ) {
+    std::vector<fl::string<N>> keys( key_strings, key_strings + key_count );
 
-        flstring flstring( "A 32 character flstring........" );
+    std::unordered_map<fl::string<N>, unsigned int, KeyHash<N>, KeyCompare<N>> crc_map;
+    std::unordered_map<fl::string<N>, unsigned int> std_hash_map;
+    fl::flat_map<N, unsigned int> flat_map;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        crc_map.emplace( keys[i], i );
+        std_hash_map.emplace( keys[i], i );
+        flat_map.try_emplace( keys[i], i );
+    }
 
-        std::cout << "Clearing flstring: \"" << flstring.data();
+    const std::string key_type = "fl::string<" + std::to_string( N ) + ">";
+    const auto premade = [&]( unsigned int i ) -> const fl::string<N>& {
+        return keys[i];
+    };
+    benchLookup( harness, "std::unordered_map<" + key_type + "> (KeyHash<" + std::to_string( N ) + ">) find( " + key_type + " )",
+                 crc_map, lookup_key_indices, premade );
+    benchLookup( harness, "std::unordered_map<" + key_type + "> (std::hash) find( " + key_type + " )", std_hash_map, lookup_key_indices, premade );
+    benchLookup( harness, "fl::flat_map<" + std::to_string( N ) + "> find( " + key_type + " )", flat_map, lookup_key_indices, premade );
+    benchLookup( harness, "fl::static_map<" + std::to_string( N ) + "> find( " + key_type + " )", static_map, lookup_key_indices, premade );
+    benchLookup( harness, "fl::static_map<" + std::to_string( N ) + "> find( const char* )", static_map, lookup_key_indices, [&]( unsigned int i ) {
+        return key_strings[i];
+    } );
+}
 
-        auto start = std::chrono::high_resolution_clock::now();
-        flstring.clear();
-        auto stop = std::chrono::high_resolution_clock::now();
+void benchStaticMapOperations( fl::bench::harness& harness ) {
+    const unsigned int lookup_count = 256;
 
-        std::cout << "\" took: " << ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+    // both built by the compiler; nothing is hashed or inserted at run time
+    static constexpr fl::static_map<4, unsigned int, key_count> three_character_map( makeStaticKeys<4>( three_character_container_strings ) );
+    static constexpr fl::static_map<8, unsigned int, key_count> seven_character_map( makeStaticKeys<8>( seven_character_container_strings ) );
 
-        // ---
+    std::vector<unsigned int> lookup_key_indices( lookup_count );
+    for( auto& key_index : lookup_key_indices ) {
+        key_index = rand() % (key_count-1) + 1;
+    }
 
-        std::string stdstring( "A 32 character std::string....." );
+    std::cout << "---\nfl::static_map -vs- std::unordered_map and fl::flat_map; Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
+    benchStaticMapOperation<4>( harness, three_character_map, three_character_container_strings, lookup_key_indices );
 
-        std::cout << "Clearing std::string: \"" << stdstring.data();
+    std::cout << "---\nfl::static_map -vs- std::unordered_map and fl::flat_map; Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
+    benchStaticMapOperation<8>( harness, seven_character_map, seven_character_container_strings, lookup_key_indices );
+}
 
-        start = std::chrono::high_resolution_clock::now();
-        stdstring.clear();
-        stop = std::chrono::high_resolution_clock::now();
-        
-        std::cout << "\" took: " << ( stop - start ).count() / 1000.0 << " ms." << std::endl;
+// fl::btree_map and fl::sorted_vector_map -vs- std::map (a node per key).
+#include "flordered_map.hpp"
+template<std::size_t N>
+void benchOrderedContainerOperation( fl::bench::harness& harness, const std::vector<fl::string<N>>& keys, const std::vector<unsigned int>& lookup_key_indices,
+                                     unsigned int max_samples ) {
+    benchMapCreationAndLookupByKey<std::map<fl::string<N>, unsigned int>>(
+        harness, "std::map<fl::string<" + std::to_string( N ) + ">>", keys, lookup_key_indices, max_samples );
+    benchMapCreationAndLookupByKey<fl::btree_map<N, unsigned int>>(
+        harness, "fl::btree_map<" + std::to_string( N ) + ">", keys, lookup_key_indices, max_samples );
+
+    // built in one go (sorting), rather than an insert at a time
+    std::vector<std::pair<fl::string<N>, unsigned int>> entries( keys.size() );
+    for( unsigned int i=0; i<keys.size(); ++i ) {
+        entries[i] = { keys[i], i };
     }
-    #endif
+    const std::string sorted_map_name = "fl::sorted_vector_map<" + std::to_string( N ) + ">";
+    fl::sorted_vector_map<N, unsigned int> sorted_map;
+    harness.run( sorted_map_name + " creation", [&]() {
+        sorted_map = fl::sorted_vector_map<N, unsigned int>( entries );
+        do_not_optimize( sorted_map );
+    }, keys.size(), max_samples );
+    harness.run( sorted_map_name + " look-up", [&]() {
+        unsigned int marker = 0;
+        for( auto& lookup : lookup_key_indices ) {
+            marker += sorted_map.find( keys[lookup] )->second;
+        }
+        do_not_optimize( marker );
+    }, lookup_key_indices.size(), max_samples );
 }
 
-// http://www.maltron.com/word-lists---qwerty-layout.html
-static const unsigned int key_count = 128;
-const char* three_character_container_strings[key_count] = {
-    "aas", "aba", "abs", "ace", "act", "add", "ads", "adz", "aff", "aft",
-    "aga", "age", "arb", "arc", "are", "arf", "ars", "art", "ass", "ate",
-    "att", "ava", "ave", "awa", "awe", "axe", "baa", "bad", "bag", "bar",
-    "bas", "bat", "bed", "bee", "beg", "bet", "bra", "brr", "cab", "cad",
-    "car", "cat", "caw", "cee", "dab", "dad", "dag", "daw", "deb", "dee",
-    "dev", "dew", "dex", "ear", "eat", "ebb", "eff", "efs", "eft", "egg",
-    "era", "ere", "erg", "err", "ers", "ess", "eta", "eve", "ewe", "fad",
-    "fag", "far", "fas", "fat", "fax", "fed", "fee", "fer", "fet", "few",
-    "fez", "gab", "gad", "gae", "gag", "gar", "gas", "gat", "ged", "gee",
-    "get", "qat", "rad", "rag", "ras", "rat", "raw", "rax", "reb", "rec",
-    "red", "ree", "ref", "reg", "res", "ret", "rev", "rex", "rts", "sab",
-    "sac", "sad", "sae", "sag", "sat", "saw", "sax", "sea", "sec", "see",
-    "seg", "ser", "set", "sew", "sex", "tab", "tad", "tae"
-};
-const char* seven_character_container_strings[key_count] = {
-    "abasers", "abaters", "abetted", "abetter", "abfarad", "abraded", "abrader", "abrades", "abreact", "abreast",
-    "abscess", "abwatts", "acceded", "acceder", "accedes", "accrete", "acerate", "acerber", "acetate", "acreage",
-    "actress", "addaxes", "address", "addrest", "advects", "adverbs", "adverse", "adverts", "aerated", "aerates",
-    "afeared", "affects", "afreets", "aggrade", "aggress", "agrafes", "agraffe", "arcaded", "arcades", "arrased",
-    "arrears", "arrests", "asceses", "asserts", "asswage", "attests", "attract", "avatars", "average", "averred",
-    "averted", "avgases", "awarded", "awardee", "awarder", "axseeds", "baccara", "baccate", "baddest", "badgers",
-    "bagasse", "baggage", "baggers", "barbate", "barbers", "barbets", "bareges", "bargees", "barrage", "barrets",
-    "barters", "barware", "bassets", "bassett", "bastard", "basters", "batters", "bawbees", "bazaars", "bearcat",
-    "bearded", "bearers", "beaters", "beavers", "bedders", "bedewed", "bedfast", "bedward", "bedwarf", "beebees",
-    "beeswax", "beezers", "befrets", "begazed", "begazes", "beggars", "berated", "berates", "bereave", "beretta",
-    "bergere", "bestead", "bestrew", "betaxed", "betters", "bewared", "bewares", "bracers", "bracted", "bradded",
-    "bragged", "bragger", "brassed", "brasses", "bravers", "bravest", "brawest", "brazers", "breaded", "breasts",
-    "breeder", "breezed", "breezes", "brevets", "brewage", "brewers", "cabaret", "cabbage"
-};
-
+// Visits every key starting with each of the prefixes, per prefix.
+template<std::size_t N>
+void benchPrefixScanOperation( fl::bench::harness& harness, const std::vector<fl::string<N>>& keys, const std::vector<std::string>& prefixes ) {
+    const unsigned int max_samples = 4;
+
+    std::map<fl::string<N>, unsigned int> map;
+    fl::btree_map<N, unsigned int> btree_map;
+    std::vector<std::pair<fl::string<N>, unsigned int>> entries( keys.size() );
+    for( unsigned int i=0; i<keys.size(); ++i ) {
+        map.emplace( keys[i], i );
+        btree_map.try_emplace( keys[i], i );
+        entries[i] = { keys[i], i };
+    }
+    const fl::sorted_vector_map<N, unsigned int> sorted_map( entries );
+
+    harness.run( "std::map lower_bound() + starts_with() scan", [&]() {
+        unsigned int marker = 0;
+        for( auto& prefix : prefixes ) {
+            for( auto it = map.lower_bound( fl::string<N>( prefix ) );
+                 ( it != map.end() ) && std::string_view( it->first.data(), it->first.length() ).starts_with( prefix ); ++it ) {
+                marker += it->second;
+            }
+        }
+        do_not_optimize( marker );
+    }, prefixes.size(), max_samples );
+    harness.run( "fl::btree_map prefix_range() scan", [&]() {
+        unsigned int marker = 0;
+        for( auto& prefix : prefixes ) {
+            const auto range = btree_map.prefix_range( prefix );
+            for( auto it = range.first; it != range.second; ++it ) {
+                marker += it->second;
+            }
+        }
+        do_not_optimize( marker );
+    }, prefixes.size(), max_samples );
+    harness.run( "fl::sorted_vector_map prefix_range() scan", [&]() {
+        unsigned int marker = 0;
+        for( auto& prefix : prefixes ) {
+            const auto range = sorted_map.prefix_range( prefix );
+            for( auto it = range.first; it != range.second; ++it ) {
+                marker += it->second;
+            }
+        }
+        do_not_optimize( marker );
+    }, prefixes.size(), max_samples );
+}
 
-#include <cstdlib>
-#include <map>
-void benchOrderedMapOperations() {
-    const unsigned int loop_count = 1024;
+void benchOrderedContainerOperations( fl::bench::harness& harness ) {
     const unsigned int lookup_count = 256;
-    std::array<unsigned int, lookup_count> lookup_key_indices;
-
-    srand( time( NULL ) );
 
-    // Generate a random sequence of keys to look-up; this is intended to try and keep things fair.
+    // Same keys and 'random' look-ups as benchOrderedMapOperations()
+    std::vector<unsigned int> lookup_key_indices( lookup_count );
     for( auto& key_index : lookup_key_indices ) {
         key_index = rand() % (key_count-1) + 1;
     }
 
-    // Compare time taken to look-up entries in a hash-map using flstrings for keys -vs- std::strings for keys - (3 characters + null = 4 characters total)
-    {
-        std::cout << "---\nUsing strings as keys in a std::map; Creation and Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
-
-        using flstring_4ch = fl::string<4>;
-        std::map<flstring_4ch, unsigned int> flstring_map;
-        
-        std::array<double, loop_count*2> flstring_map_creation_times;
-        std::array<double, loop_count*2> flstring_map_lookup_times;
-
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                flstring_map.emplace( three_character_container_strings[j], 0 );
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                //flstring_map[three_character_container_strings[lookup]]
-                flstring_map.find( three_character_container_strings[lookup] )->second += 1;
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
-        }
+    std::cout << "---\nfl::btree_map and fl::sorted_vector_map -vs- std::map; Creation and Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
+    benchOrderedContainerOperation<4>( harness, std::vector<fl::string<4>>( three_character_container_strings, three_character_container_strings + key_count ),
+                                       lookup_key_indices, harness.settings().sample_count );
+
+    std::cout << "---\nfl::btree_map and fl::sorted_vector_map -vs- std::map; Creation and Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
+    benchOrderedContainerOperation<8>( harness, std::vector<fl::string<8>>( seven_character_container_strings, seven_character_container_strings + key_count ),
+                                       lookup_key_indices, harness.settings().sample_count );
+
+    // and once the tree no longer fits in cache
+    const unsigned int large_key_count = 1 << 20;
+    std::vector<fl::string<16>> large_keys( large_key_count );
+    for( unsigned int i=0; i<large_key_count; ++i ) {
+        char key[16];
+        std::snprintf( key, sizeof( key ), "key-%08x", i * 2654435761u );
+        large_keys[i] = key;
+    }
+    std::vector<unsigned int> large_lookup_key_indices( large_key_count );
+    for( auto& key_index : large_lookup_key_indices ) {
+        key_index = static_cast<unsigned int>( rand() ) % large_key_count;
+    }
 
-        // ---
+    std::cout << "---\nfl::btree_map and fl::sorted_vector_map -vs- std::map; Creation and Lookup (" << large_key_count << " x 16 character keys inc. null-terminator)\n---" << std::endl;
+    benchOrderedContainerOperation<16>( harness, large_keys, large_lookup_key_indices, 4 );
 
-        std::map<std::string, unsigned int> stdstring_map;
-        
-        std::array<double, loop_count*2> stdstring_map_creation_times;
-        std::array<double, loop_count*2> stdstring_map_lookup_times;
+    // prefixes of 3 hex digits, each matching ~256 of the keys
+    std::vector<std::string> prefixes( 4096 );
+    for( auto& prefix : prefixes ) {
+        char characters[16];
+        std::snprintf( characters, sizeof( characters ), "key-%03x", static_cast<unsigned int>( rand() ) % 4096 );
+        prefix = characters;
+    }
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                stdstring_map.emplace( three_character_container_strings[j], 0 );
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[i] = (stop - start).count() / 1000.0;
+    std::cout << "---\nPrefix range scans (" << prefixes.size() << " prefixes over " << large_key_count << " x 16 character keys inc. null-terminator)\n---" << std::endl;
+    benchPrefixScanOperation<16>( harness, large_keys, prefixes );
+}
 
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                stdstring_map.find( three_character_container_strings[lookup] )->second += 1;
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
+// fl::intern_table<N> -vs- a mutex-guarded std::unordered_map with a reverse std::vector, interning
+// one stream of symbols (mostly repeats, as in practice) split between 1 to 64 threads, per symbol.
+#include "flintern_table.hpp"
+#include <atomic>
+#include <barrier>
+#include <mutex>
+#include <thread>
+// A team of threads, started once and then set to work round after round: run( op ) has
+// every thread t call op( t ), and returns when they all have. So a run of the harness that
+// calls run() times just the threads' work, not starting and joining them (or the
+// allocations that takes, which would count against fl::string as much as std::string).
+class ThreadTeam {
+public:
+    explicit ThreadTeam( unsigned int thread_count )
+        : m_start( thread_count + 1 ), m_finish( thread_count + 1 ) {
+        for( unsigned int t=0; t<thread_count; ++t ) {
+            m_threads.emplace_back( [this, t]() { work( t ); } );
         }
+    }
+    ~ThreadTeam() {
+        m_round = nullptr;      // (which sends the threads home)
+        m_start.arrive_and_wait();
+    }
+    ThreadTeam( const ThreadTeam& ) = delete;
+    ThreadTeam& operator=( const ThreadTeam& ) = delete;
+
+    template<typename operation>
+    void run( const operation& op ) {
+        m_operation = &op;
+        m_round = []( const void* round_op, unsigned int t ) {
+            ( *static_cast<const operation*>( round_op ) )( t );
+        };
+        m_start.arrive_and_wait();
+        m_finish.arrive_and_wait();
+    }
 
-        // Now flip the order and run again		
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                stdstring_map.emplace( three_character_container_strings[j], 0 );
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                stdstring_map.find( three_character_container_strings[lookup] )->second += 1;
+private:
+    void work( unsigned int t ) {
+        // (a thread starts with its parent's affinity, which --cpu narrows to one core)
+        fl::bench::unpin_thread();
+        for( ;; ) {
+            m_start.arrive_and_wait();
+            if( m_round == nullptr ) {
+                return;
             }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
+            m_round( m_operation, t );
+            m_finish.arrive_and_wait();
         }
+    }
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                flstring_map.emplace( three_character_container_strings[j], 0 );
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                //flstring_map[three_character_container_strings[lookup]]
-                flstring_map.find( three_character_container_strings[lookup] )->second += 1;
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
-        }
+    std::barrier<>              m_start;
+    std::barrier<>              m_finish;
+    void                        (*m_round)( const void*, unsigned int ) = nullptr;
+    const void*                 m_operation = nullptr;
+    std::vector<std::jthread>   m_threads;      // (last, so joined before the barriers go)
+};
 
-        // Now print the results
-        double flstring_map_creation_time_avg = std::accumulate( flstring_map_creation_times.begin(), flstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double flstring_map_lookup_time_avg = std::accumulate( flstring_map_lookup_times.begin(), flstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "flstring ordered_map creation time: " << flstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "flstring ordered_map look-up time: " << flstring_map_lookup_time_avg << " ms.\n---" << std::endl;
-
-        double stdstring_map_creation_time_avg = std::accumulate( stdstring_map_creation_times.begin(), stdstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double stdstring_map_lookup_time_avg = std::accumulate( stdstring_map_lookup_times.begin(), stdstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "stdstring ordered_map creation time: " << stdstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "stdstring ordered_map look-up time: " << stdstring_map_lookup_time_avg << " ms." << std::endl;
-    }
-
-    // Compare time taken to look-up entries in a hash-map using flstrings for keys -vs- std::strings for keys - (7 characters + null = 8 characters total)
-    {
-        std::cout << "---\nUsing strings as keys in a std::map; Creation and Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
-
-        using flstring_4ch = fl::string<8>;
-        std::map<flstring_4ch, unsigned int> flstring_map;
-        
-        std::array<double, loop_count*2> flstring_map_creation_times;
-        std::array<double, loop_count*2> flstring_map_lookup_times;
-
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                flstring_map.emplace( seven_character_container_strings[j], 0 );
+void benchInternOperation( fl::bench::harness& harness, const std::vector<fl::string<16>>& symbols, const std::vector<unsigned int>& stream,
+                           unsigned int thread_count ) {
+    const unsigned int max_samples = 4;
+    const std::size_t share = stream.size() / thread_count;
+    const std::string threads = std::to_string( thread_count ) + " thread(s); ";
+    ThreadTeam team( thread_count );
+
+    harness.run( threads + "fl::intern_table<16>::intern()", [&]() {
+        fl::intern_table<16> table( symbols.size() );
+        team.run( [&]( unsigned int t ) {
+            std::size_t ids = 0;
+            for( std::size_t i=t*share; i<(t+1)*share; ++i ) {
+                ids += table.intern( symbols[stream[i]] );
             }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                flstring_map.find( seven_character_container_strings[lookup] )->second += 1;
+            do_not_optimize( ids );
+        } );
+    }, share * thread_count, max_samples );
+
+    harness.run( threads + "mutex + std::unordered_map<std::string> + std::vector interning", [&]() {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::uint32_t> table;
+        std::vector<std::string> strings;
+        team.run( [&]( unsigned int t ) {
+            std::size_t ids = 0;
+            for( std::size_t i=t*share; i<(t+1)*share; ++i ) {
+                const std::string symbol( symbols[stream[i]].data(), symbols[stream[i]].length() );
+                const std::lock_guard<std::mutex> lock( mutex );
+                const auto [it, inserted] = table.try_emplace( symbol, static_cast<std::uint32_t>( strings.size() ) );
+                if( inserted ) {
+                    strings.push_back( symbol );
+                }
+                ids += it->second;
             }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
-        }
+            do_not_optimize( ids );
+        } );
+    }, share * thread_count, max_samples );
+}
+
+void benchInternOperations( fl::bench::harness& harness ) {
+    const unsigned int symbol_count = 1 << 16;
+    const std::size_t stream_length = 1 << 22;
 
-        // ---
+    std::vector<fl::string<16>> symbols( symbol_count );
+    for( unsigned int i=0; i<symbol_count; ++i ) {
+        char symbol[16];
+        std::snprintf( symbol, sizeof( symbol ), "sym-%08x", i * 2654435761u );
+        symbols[i] = symbol;
+    }
+    std::vector<unsigned int> stream( stream_length );
+    for( auto& symbol_index : stream ) {
+        symbol_index = static_cast<unsigned int>( rand() ) % symbol_count;
+    }
 
-        std::map<std::string, unsigned int> stdstring_map;
-        
-        std::array<double, loop_count*2> stdstring_map_creation_times;
-        std::array<double, loop_count*2> stdstring_map_lookup_times;
+    std::cout << "---\nInterning " << stream_length << " x 16 character symbols inc. null-terminator (" << symbol_count << " distinct; "
+              << std::thread::hardware_concurrency() << " hardware threads)\n---" << std::endl;
+    for( unsigned int thread_count=1; thread_count<=64; thread_count*=2 ) {
+        benchInternOperation( harness, symbols, stream, thread_count );
+    }
+}
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                stdstring_map.emplace( seven_character_container_strings[j], 0 );
+// fl::sharded_map<N> (key at a time, and in batches) -vs- a mutex-guarded std::unordered_map,
+// with 1 to 64 threads each inserting, then looking up, its own share of the keys, per key.
+#include "flsharded_map.hpp"
+void benchShardedMapOperation( fl::bench::harness& harness, const std::vector<fl::string<16>>& keys, unsigned int thread_count ) {
+    const unsigned int max_samples = 4;
+    const std::size_t batch_size = 256;
+    const std::size_t share = keys.size() / thread_count;
+    std::vector<unsigned int> values( keys.size() );
+    std::iota( values.begin(), values.end(), 0u );
+    const std::string threads = std::to_string( thread_count ) + " thread(s); ";
+    ThreadTeam team( thread_count );
+
+    harness.run( threads + "mutex + std::unordered_map<std::string> try_emplace()/find()", [&]() {
+        std::mutex mutex;
+        std::unordered_map<std::string, unsigned int> map;
+        team.run( [&]( unsigned int t ) {
+            std::size_t found = 0;
+            for( std::size_t i=t*share; i<(t+1)*share; ++i ) {
+                const std::lock_guard<std::mutex> lock( mutex );
+                map.try_emplace( std::string( keys[i].data(), keys[i].length() ), values[i] );
             }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                stdstring_map.find( seven_character_container_strings[lookup] )->second += 1;
+            for( std::size_t i=t*share; i<(t+1)*share; ++i ) {
+                const std::string key( keys[i].data(), keys[i].length() );
+                const std::lock_guard<std::mutex> lock( mutex );
+                found += map.find( key )->second;
             }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
-        }
-
-        // Now flip the order and run again		
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                stdstring_map.emplace( seven_character_container_strings[j], 0 );
+            do_not_optimize( found );
+        } );
+    }, share * thread_count, max_samples );
+
+    harness.run( threads + "fl::sharded_map<16> try_emplace()/find()", [&]() {
+        fl::sharded_map<16, unsigned int> map;
+        team.run( [&]( unsigned int t ) {
+            std::size_t found = 0;
+            for( std::size_t i=t*share; i<(t+1)*share; ++i ) {
+                map.try_emplace( keys[i], values[i] );
             }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                stdstring_map.find( seven_character_container_strings[lookup] )->second += 1;
+            for( std::size_t i=t*share; i<(t+1)*share; ++i ) {
+                found += *map.find( keys[i] );
             }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
-        }
-
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                flstring_map.emplace( seven_character_container_strings[j], 0 );
+            do_not_optimize( found );
+        } );
+    }, share * thread_count, max_samples );
+
+    harness.run( threads + "fl::sharded_map<16> insert_many()/find_many() (" + std::to_string( batch_size ) + " keys a batch)", [&]() {
+        fl::sharded_map<16, unsigned int> map;
+        team.run( [&]( unsigned int t ) {
+            std::size_t found = 0;
+            unsigned int found_values[batch_size];
+            bool found_flags[batch_size];
+            for( std::size_t i=t*share; i<(t+1)*share; i+=batch_size ) {
+                map.insert_many( &keys[i], &values[i], std::min( batch_size, (t+1)*share - i ) );
             }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                flstring_map.find( seven_character_container_strings[lookup] )->second += 1;
+            for( std::size_t i=t*share; i<(t+1)*share; i+=batch_size ) {
+                const std::size_t count = std::min( batch_size, (t+1)*share - i );
+                map.find_many( &keys[i], count, found_values, found_flags );
+                found += std::accumulate( found_values, found_values + count, std::size_t( 0 ) );
             }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
-        }
+            do_not_optimize( found );
+        } );
+    }, share * thread_count, max_samples );
+}
 
-        // Now print the results
-        double flstring_map_creation_time_avg = std::accumulate( flstring_map_creation_times.begin(), flstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double flstring_map_lookup_time_avg = std::accumulate( flstring_map_lookup_times.begin(), flstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "flstring ordered_map creation time: " << flstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "flstring ordered_map look-up time: " << flstring_map_lookup_time_avg << " ms.\n---" << std::endl;
+void benchShardedMapOperations( fl::bench::harness& harness ) {
+    const unsigned int key_count = 1 << 20;
+    std::vector<fl::string<16>> keys( key_count );
+    for( unsigned int i=0; i<key_count; ++i ) {
+        char key[16];
+        std::snprintf( key, sizeof( key ), "key-%08x", i * 2654435761u );
+        keys[i] = key;
+    }
 
-        double stdstring_map_creation_time_avg = std::accumulate( stdstring_map_creation_times.begin(), stdstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double stdstring_map_lookup_time_avg = std::accumulate( stdstring_map_lookup_times.begin(), stdstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "stdstring ordered_map creation time: " << stdstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "stdstring ordered_map look-up time: " << stdstring_map_lookup_time_avg << " ms." << std::endl;
+    std::cout << "---\nConcurrent insertion and lookup of " << key_count << " x 16 character keys inc. null-terminator ("
+              << std::thread::hardware_concurrency() << " hardware threads)\n---" << std::endl;
+    for( unsigned int thread_count=1; thread_count<=64; thread_count*=2 ) {
+        benchShardedMapOperation( harness, keys, thread_count );
     }
 }
 
-#include <unordered_map>
-#include "crc32.hpp"
-// hash function: calculateCRC32() from crc32.hpp
-
-/*
-unsigned long hashKey( fl::string<4> str ) {
-    return 0;
+// Multi-threaded scenarios, fl::string -vs- std::string (and so the system allocator, which
+// every std::string longer than its SSO buffer goes through), scaling from 1 thread up to
+// every core. Each run times one round of all the threads' operations together (on threads
+// started beforehand), so the time per item is the inverse of the throughput.
+#include <memory>
+#include <shared_mutex>
+// 1, 2, 4, ... and then every core
+std::vector<unsigned int> scalingThreadCounts() {
+    const unsigned int cores = std::max( 1u, std::thread::hardware_concurrency() );
+    std::vector<unsigned int> counts;
+    for( unsigned int t=1; t<cores; t*=2 ) {
+        counts.push_back( t );
+    }
+    counts.push_back( cores );
+    return counts;
 }
 
-// hash key equal function
-bool keysEqual( fl::string<4> lhs, fl::string<4> rhs ) {
-    return lhs.compare( rhs ) == 0;
+// Throughput (million operations a second, from the median time per item) at each
+// thread count, and how many times the single-thread throughput that is
+void printScaling( const std::vector<unsigned int>& thread_counts, const char* fl_name, const std::vector<double>& fl_ns,
+                   const char* std_name, const std::vector<double>& std_ns ) {
+    const std::string fl_heading = std::string( fl_name ) + " Mops/s";
+    const std::string std_heading = std::string( std_name ) + " Mops/s";
+    const int fl_width = static_cast<int>( std::max<std::size_t>( 20, fl_heading.length() + 2 ) );
+    const int std_width = static_cast<int>( std::max<std::size_t>( 20, std_heading.length() + 2 ) );
+    std::ostringstream table;
+    table << std::fixed << std::setprecision( 2 )
+          << std::setw( 8 ) << "threads" << std::setw( fl_width ) << fl_heading
+          << std::setw( std_width ) << std_heading << std::setw( 10 ) << "fl/std" << "\n";
+    for( std::size_t i=0; i<thread_counts.size(); ++i ) {
+        std::ostringstream fl_cell, std_cell;
+        fl_cell << std::fixed << std::setprecision( 2 ) << 1e3 / fl_ns[i] << " (" << fl_ns[0] / fl_ns[i] << "x)";
+        std_cell << std::fixed << std::setprecision( 2 ) << 1e3 / std_ns[i] << " (" << std_ns[0] / std_ns[i] << "x)";
+        table << std::setw( 8 ) << thread_counts[i] << std::setw( fl_width ) << fl_cell.str() << std::setw( std_width ) << std_cell.str()
+              << std::setw( 10 ) << std_ns[i] / fl_ns[i] << "\n";
+    }
+    std::cout << table.str() << std::flush;
 }
-*/
-template<size_t strlen>
-class KeyHash {
-public:
-    unsigned long operator()( const fl::string<strlen>& key ) const {
-        return calculateCRC32<strlen>( key );
-    };
-};
-template<size_t strlen>
-class KeyCompare {
-public:
-    bool operator()( const fl::string<strlen>& lhs, const fl::string<strlen>& rhs ) const {
-        return lhs.compare( rhs ) == 0;
-    };
-};
 
-template<size_t strlen>
-class KeyHash_std {
-public:
-    unsigned long operator()( const std::string& key ) const {
-        return calculateCRC32<4>( key );
-    };
-};
-class KeyCompare_std {
-public:
-    bool operator()( const std::string& lhs, const std::string& rhs ) const {
-        return lhs.compare( rhs ) == 0;
+// Per-thread churn: each thread builds, appends to, copies and destroys its own strings,
+// which for std::string (past the SSO buffer) is three allocations and three frees each time
+template<typename string_type>
+double benchChurnOperation( fl::bench::harness& harness, const std::string& name, const std::vector<std::string>& texts, unsigned int thread_count ) {
+    const unsigned int operation_count = 4096;     // a thread
+    const auto round = [&]( unsigned int t ) {
+        for( unsigned int i=0; i<operation_count; ++i ) {
+            string_type str( texts[( i + t ) % texts.size()].c_str() );
+            str += " - appended";
+            const string_type copy( str );
+            do_not_optimize( copy );
+        }
     };
-};
-
-void benchUnorderedMapOperations() {
-    const unsigned int loop_count = 32;
-    const unsigned int lookup_count = 256;
-    std::array<unsigned int, lookup_count> lookup_key_indices;
-
-    // Use pre-constructed strings to avoid constructing temporary objects when
-    // populating and searching the maps. Would be worthwhile doing this for
-    // ordered_map as well, I was unable to due to time constraints. :(
-//#define USE_PREMADE_OBJECTS 0
-#if 0//defined(USE_PREMADE_OBJECTS)
-    std::array<fl::string<4>, key_count> flstrings4ch;
-    std::array<fl::string<8>, key_count> flstrings8ch;
-
-    std::array<std::string, key_count> stdstrings4ch;
-    std::array<std::string, key_count> stdstrings8ch;
-
-    for(unsigned int i=0; i<key_count; ++i) {
-        flstrings4ch[i] = three_character_container_strings[i];
-        stdstrings4ch[i] = three_character_container_strings[i];
-
-        flstrings8ch[i] = seven_character_container_strings[i];
-        stdstrings8ch[i] = seven_character_container_strings[i];
-    }	
-#endif
-
-    srand( time( NULL ) );
+    ThreadTeam team( thread_count );
+    return harness.run( name, [&]() {
+        team.run( round );
+    }, std::size_t( thread_count ) * operation_count ).median_ns;
+}
 
-    // Generate a random sequence of keys to look-up; this is intended to try and keep things fair.
-    for( auto& key_index : lookup_key_indices ) {
-        key_index = rand() % (key_count-1) + 1;
+void benchChurnOperations( fl::bench::harness& harness ) {
+    std::vector<std::string> texts;
+    for( unsigned int i=0; i<key_count; ++i ) {
+        texts.push_back( std::string( seven_character_container_strings[i] ) + " - a long string" );
     }
 
-    // Compare time taken to look-up entries in a hash-map using flstrings for keys -vs- std::strings for keys - (3 characters + null = 4 characters total)
-    {
-        std::cout << "---\nUsing strings as keys in a std::unordered_map; Creation and Lookup (4 character keys inc. null-terminator)\n---" << std::endl;
-
-        using flstring_4ch = fl::string<4>;
-        std::unordered_map<flstring_4ch, unsigned int, KeyHash<4>, KeyCompare<4>> flstring_map;
-
-        std::array<double, loop_count*2> flstring_map_creation_times;
-        std::array<double, loop_count*2> flstring_map_lookup_times;
+    std::cout << "---\nThreads churning their own strings: construct, append (to 34 characters), copy and destroy ("
+              << std::thread::hardware_concurrency() << " hardware threads)\n---" << std::endl;
+    const std::vector<unsigned int> thread_counts = scalingThreadCounts();
+    std::vector<double> fl_ns, std_ns;
+    for( const unsigned int thread_count : thread_counts ) {
+        const std::string threads = "churn, " + std::to_string( thread_count ) + " thread(s): ";
+        fl_ns.push_back( benchChurnOperation<fl::string<64>>( harness, threads + "fl::string<64>", texts, thread_count ) );
+        std_ns.push_back( benchChurnOperation<std::string>( harness, threads + "std::string", texts, thread_count ) );
+    }
+    printScaling( thread_counts, "fl::string<64>", fl_ns, "std::string", std_ns );
+}
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.emplace( flstrings4ch[j], 0 );
-                #else
-                    flstring_map.emplace( three_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.find( flstrings4ch[lookup] )->second += 1;
-                #else
-                    flstring_map.find( three_character_container_strings[lookup] )->second += 1;
-                #endif
+// A shared, read-mostly map: every thread looks keys up (under a shared lock), from
+// the const char* keys a caller would have in hand, so std::string has to build (and
+// allocate) a temporary key for each; one operation in 64 updates a value instead
+template<typename map_type, typename key_type>
+double benchReadMostlyOperation( fl::bench::harness& harness, const std::string& name, const std::vector<std::string>& keys, unsigned int thread_count ) {
+    const unsigned int operation_count = 4096;     // a thread
+    map_type map;
+    for( std::size_t i=0; i<keys.size(); ++i ) {
+        map.try_emplace( key_type( keys[i].c_str() ), static_cast<unsigned int>( i ) );
+    }
+    std::shared_mutex mutex;
+
+    const auto round = [&]( unsigned int t ) {
+        unsigned int found = 0;
+        for( unsigned int i=0; i<operation_count; ++i ) {
+            const char* key = keys[( ( i + t * operation_count ) * 2654435761u ) % keys.size()].c_str();
+            if( i % 64 == 63 ) {
+                const std::unique_lock lock( mutex );
+                map.find( key_type( key ) )->second += 1;
+            } else {
+                const std::shared_lock lock( mutex );
+                found += map.find( key_type( key ) )->second;
             }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
         }
+        do_not_optimize( found );
+    };
+    ThreadTeam team( thread_count );
+    return harness.run( name, [&]() {
+        team.run( round );
+    }, std::size_t( thread_count ) * operation_count ).median_ns;
+}
 
-        // ---
-
-        std::unordered_map<std::string, unsigned int, KeyHash_std<4>, KeyCompare_std> stdstring_map;
-        
-        std::array<double, loop_count*2> stdstring_map_creation_times;
-        std::array<double, loop_count*2> stdstring_map_lookup_times;
-
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.emplace( stdstrings4ch[j], 0 );
-                #else
-                    stdstring_map.emplace( three_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.find( stdstrings4ch[lookup] )->second += 1;
-                #else
-                    stdstring_map.find( three_character_container_strings[lookup] )->second += 1;
-                #endif
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
-        }
+void benchReadMostlyOperations( fl::bench::harness& harness ) {
+    const unsigned int map_size = 1 << 16;
+    std::vector<std::string> keys( map_size );
+    for( unsigned int i=0; i<map_size; ++i ) {
+        char key[32];
+        std::snprintf( key, sizeof( key ), "session-key-%08x", i * 2654435761u );
+        keys[i] = key;
+    }
 
-        // Now run the tests again, but with the order reversed (fl::string->std::string becomes std::string->fl::string)
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.emplace( stdstrings4ch[j], 0 );
-                #else
-                    stdstring_map.emplace( three_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.find( stdstrings4ch[lookup] )->second += 1;
-                #else
-                    stdstring_map.find( three_character_container_strings[lookup] )->second += 1;
-                #endif
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
-        }
+    std::cout << "---\nShared read-mostly map (" << map_size << " x 21 character keys inc. null-terminator; 1 in 64 operations a write) ("
+              << std::thread::hardware_concurrency() << " hardware threads)\n---" << std::endl;
+    const std::vector<unsigned int> thread_counts = scalingThreadCounts();
+    std::vector<double> fl_ns, std_ns;
+    for( const unsigned int thread_count : thread_counts ) {
+        const std::string threads = "read-mostly map, " + std::to_string( thread_count ) + " thread(s): ";
+        fl_ns.push_back( benchReadMostlyOperation<fl::flat_map<32, unsigned int>, fl::string<32, fl::zero_padding>>(
+            harness, threads + "fl::flat_map<32>", keys, thread_count ) );
+        std_ns.push_back( benchReadMostlyOperation<std::unordered_map<std::string, unsigned int>, std::string>(
+            harness, threads + "std::unordered_map<std::string>", keys, thread_count ) );
+    }
+    printScaling( thread_counts, "fl::flat_map<32>", fl_ns, "std::unordered_map<std::string>", std_ns );
+}
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.emplace( flstrings4ch[j], 0 );
-                #else
-                    flstring_map.emplace( three_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.find( flstrings4ch[lookup] )->second += 1;
-                #else
-                    flstring_map.find( three_character_container_strings[lookup] )->second += 1;
-                #endif
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
+// Producer/consumer: strings passed by value through single-producer, single-consumer
+// ring buffers. A std::string (past the SSO buffer) is allocated by its producer and freed
+// by its consumer, on another thread; an fl::string is just copied through the ring.
+template<typename value_type, std::size_t capacity>
+class SpscQueue {
+public:
+    bool push( value_type& value ) {
+        const std::size_t tail = m_tail.load( std::memory_order_relaxed );
+        if( tail - m_head.load( std::memory_order_acquire ) == capacity ) {
+            return false;
         }
-
-        // Now print the results
-        double flstring_map_creation_time_avg = std::accumulate( flstring_map_creation_times.begin(), flstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double flstring_map_lookup_time_avg = std::accumulate( flstring_map_lookup_times.begin(), flstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "flstring unordered_map creation time: " << flstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "flstring unordered_map look-up time: " << flstring_map_lookup_time_avg << " ms.\n---" << std::endl;
-
-        double stdstring_map_creation_time_avg = std::accumulate( stdstring_map_creation_times.begin(), stdstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double stdstring_map_lookup_time_avg = std::accumulate( stdstring_map_lookup_times.begin(), stdstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "stdstring unordered_map creation time: " << stdstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "stdstring unordered_map look-up time: " << stdstring_map_lookup_time_avg << " ms." << std::endl;
+        m_slots[tail % capacity] = std::move( value );
+        m_tail.store( tail + 1, std::memory_order_release );
+        return true;
     }
-
-    // ...
-
-    // Compare time taken to look-up entries in a hash-map using flstrings for keys -vs- std::strings for keys - (7 characters + null = 8 characters total)
-    {
-        std::cout << "---\nUsing strings as keys in a std::unordered_map; Creation and Lookup (8 character keys inc. null-terminator)\n---" << std::endl;
-
-        using flstring_8ch = fl::string<8>;
-        std::unordered_map<flstring_8ch, unsigned int, KeyHash<8>, KeyCompare<8>> flstring_map;
-
-        std::array<double, loop_count*2> flstring_map_creation_times;
-        std::array<double, loop_count*2> flstring_map_lookup_times;
-
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.emplace( flstrings8ch[j], 0 );
-                #else
-                    flstring_map.emplace( seven_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.find( flstrings8ch[lookup] )->second += 1;
-                #else
-                    flstring_map.find( seven_character_container_strings[lookup] )->second += 1;
-                #endif
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
+    bool pop( value_type& value ) {
+        const std::size_t head = m_head.load( std::memory_order_relaxed );
+        if( head == m_tail.load( std::memory_order_acquire ) ) {
+            return false;
         }
+        value = std::move( m_slots[head % capacity] );
+        m_head.store( head + 1, std::memory_order_release );
+        return true;
+    }
 
-        // ---
-
-        std::unordered_map<std::string, unsigned int, KeyHash_std<8>, KeyCompare_std> stdstring_map;
-        
-        std::array<double, loop_count*2> stdstring_map_creation_times;
-        std::array<double, loop_count*2> stdstring_map_lookup_times;
-
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.emplace( stdstrings8ch[j], 0 );
-                #else
-                    stdstring_map.emplace( seven_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.find( stdstrings8ch[lookup] )->second += 1;
-                #else
-                    stdstring_map.find( seven_character_container_strings[lookup] )->second += 1;
-                #endif
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[i] = (stop - start).count() / 1000.0;
-        }
+private:
+    alignas( 64 ) std::atomic<std::size_t> m_head = 0;     // (each on its own cache line)
+    alignas( 64 ) std::atomic<std::size_t> m_tail = 0;
+    alignas( 64 ) std::array<value_type, capacity> m_slots;
+};
 
-        // Now run the tests again, but with the order reversed (fl::string->std::string becomes std::string->fl::string)
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.emplace( stdstrings8ch[j], 0 );
-                #else
-                    stdstring_map.emplace( seven_character_container_strings[j], 0 );
-                #endif
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    stdstring_map.find( stdstrings8ch[lookup] )->second += 1;
-                #else
-                    stdstring_map.find( seven_character_container_strings[lookup] )->second += 1;
-                #endif
-            }
-            stop = std::chrono::high_resolution_clock::now();
-            stdstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
-        }
+template<typename string_type>
+double benchMessageOperation( fl::bench::harness& harness, const std::string& name, const std::vector<std::string>& texts, unsigned int pair_count ) {
+    const unsigned int message_count = 4096;        // a producer
+    using queue_type = SpscQueue<string_type, 256>;
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            // Create the map
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.emplace( flstrings8ch[j], 0 );
-                #else
-                    flstring_map.emplace( seven_character_container_strings[j], 0 );
-                #endif
+    // (each round leaves its queue empty, ready for the next)
+    std::vector<std::unique_ptr<queue_type>> queues;
+    for( unsigned int p=0; p<pair_count; ++p ) {
+        queues.push_back( std::make_unique<queue_type>() );
+    }
+    // even threads produce, odd threads consume, in pairs sharing a queue
+    const auto round = [&]( unsigned int t ) {
+        queue_type& queue = *queues[t / 2];
+        if( t % 2 == 0 ) {
+            for( unsigned int i=0; i<message_count; ++i ) {
+                string_type message( texts[( i + t ) % texts.size()].c_str() );
+                while( !queue.push( message ) ) {
+                    std::this_thread::yield();
+                }
             }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_map_creation_times[loop_count+i] = (stop - start).count() / 1000.0;
-
-            // Now perform 'random' lookups
-            start = std::chrono::high_resolution_clock::now();
-            for( auto& lookup : lookup_key_indices ) {
-                #if 0//defined(USE_PREMADE_OBJECTS)
-                    flstring_map.find( flstrings8ch[lookup] )->second += 1;
-                #else
-                    flstring_map.find( seven_character_container_strings[lookup] )->second += 1;
-                #endif
+        } else {
+            std::size_t received = 0;
+            string_type message;
+            for( unsigned int i=0; i<message_count; ++i ) {
+                while( !queue.pop( message ) ) {
+                    std::this_thread::yield();
+                }
+                received += message.length();
             }
-            stop = std::chrono::high_resolution_clock::now();
-            flstring_map_lookup_times[loop_count+i] = (stop - start).count() / 1000.0;
+            do_not_optimize( received );
         }
-
-        // Now print the results
-        double flstring_map_creation_time_avg = std::accumulate( flstring_map_creation_times.begin(), flstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double flstring_map_lookup_time_avg = std::accumulate( flstring_map_lookup_times.begin(), flstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "flstring unordered_map creation time: " << flstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "flstring unordered_map look-up time: " << flstring_map_lookup_time_avg << " ms.\n---" << std::endl;
-
-        double stdstring_map_creation_time_avg = std::accumulate( stdstring_map_creation_times.begin(), stdstring_map_creation_times.end(), 0.0 ) / (loop_count*2);
-        double stdstring_map_lookup_time_avg = std::accumulate( stdstring_map_lookup_times.begin(), stdstring_map_lookup_times.end(), 0.0 ) / (loop_count*2);
-        std::cout << "stdstring unordered_map creation time: " << stdstring_map_creation_time_avg << " ms." << std::endl;
-        std::cout << "stdstring unordered_map look-up time: " << stdstring_map_lookup_time_avg << " ms." << std::endl;
-    }
+    };
+    ThreadTeam team( 2 * pair_count );
+    return harness.run( name, [&]() {
+        team.run( round );
+    }, std::size_t( pair_count ) * message_count ).median_ns;
 }
 
-#if 0
-#include "crc32.hpp"
-void benchCRC32Operations() {
-    const unsigned int loop_count = 128;
-    std::array<double, loop_count> flstring_crc32_generation_times;
-    std::array<double, loop_count> stdstring_crc32_generation_times;
-
-    unsigned int flstring_crc32_fingerprint = 0;
-    unsigned int stdstring_crc32_fingerprint = 0;
-
-    std::array<fl::string<4>, key_count> flstring_array;
+void benchMessageOperations( fl::bench::harness& harness ) {
+    std::vector<std::string> texts;
     for( unsigned int i=0; i<key_count; ++i ) {
-        flstring_array[i] = three_character_container_strings[i];
+        texts.push_back( std::string( seven_character_container_strings[i] ) + " - a 31 character string" );
     }
 
-    for( unsigned int i=0; i<loop_count; ++i ) {
-        auto start = std::chrono::high_resolution_clock::now();
-        for( unsigned int j=0; j<1; ++j ) {
-            flstring_crc32_fingerprint |= calculateCRC32( 0, reinterpret_cast<const void*>( flstring_array[j].data() ), 3 );
+    std::cout << "---\nProducer/consumer pairs passing 31 character strings through ring buffers ("
+              << std::thread::hardware_concurrency() << " hardware threads)\n---" << std::endl;
+    // (two threads a pair, so half as many pairs as threads, but always at least one)
+    std::vector<unsigned int> thread_counts;
+    std::vector<double> fl_ns, std_ns;
+    for( const unsigned int thread_count : scalingThreadCounts() ) {
+        const unsigned int pair_count = std::max( 1u, thread_count / 2 );
+        if( !thread_counts.empty() && thread_counts.back() == 2 * pair_count ) {
+            continue;
         }
-        auto stop = std::chrono::high_resolution_clock::now();
-        flstring_crc32_generation_times[i] = (stop-start).count() / 1000.0;
-    }
-    double flstring_crc32_generation_time_avg = std::accumulate( flstring_crc32_generation_times.begin(), flstring_crc32_generation_times.end(), 0.0 ) / loop_count;
-    std::cout << std::setprecision( 3 ) << "flstring CRC32 generation time: " << flstring_crc32_generation_time_avg << " ms." << flstring_crc32_fingerprint << std::endl;
-
-    // ---
-
-    std::array<std::string, key_count> stdstring_array;
-    for( unsigned int i=0; i<key_count; ++i ) {
-        stdstring_array[i] = three_character_container_strings[i];
+        thread_counts.push_back( 2 * pair_count );
+        const std::string threads = "messages, " + std::to_string( 2 * pair_count ) + " thread(s): ";
+        fl_ns.push_back( benchMessageOperation<flstring>( harness, threads + "fl::string<32>", texts, pair_count ) );
+        std_ns.push_back( benchMessageOperation<std::string>( harness, threads + "std::string", texts, pair_count ) );
     }
+    printScaling( thread_counts, "fl::string<32>", fl_ns, "std::string", std_ns );
+}
 
-    for( unsigned int i=0; i<loop_count; ++i ) {
-        auto start = std::chrono::high_resolution_clock::now();
-        for( unsigned int j=0; j<1; ++j ) {
-            stdstring_crc32_fingerprint |= calculateCRC32( 0, reinterpret_cast<const void*>( stdstring_array[j].data() ), 3 );
-        }
-        auto stop = std::chrono::high_resolution_clock::now();
-        stdstring_crc32_generation_times[i] = (stop-start).count() / 1000.0;
-    }
-    double stdstring_crc32_generation_time_avg = std::accumulate( stdstring_crc32_generation_times.begin(), stdstring_crc32_generation_times.end(), 0.0 ) / loop_count;
-    std::cout << std::setprecision( 3 ) << "stdstring CRC32 generation time: " << stdstring_crc32_generation_time_avg << " ms." << stdstring_crc32_fingerprint << std::endl;
-#if 1
-    {
-        unsigned int flstring_crc32_fingerprint = 0;
-        unsigned int stdstring_crc32_fingerprint = 0;
-
-        std::array<fl::string<8>, key_count> flstring_array;
-        for( unsigned int i=0; i<key_count; ++i ) {
-            flstring_array[i] = seven_character_container_strings[i];
-        }
+// False sharing: each thread repeatedly writes its own element of a shared array of
+// small strings; packed, up to 8 fl::string<8> (or 2 std::string) share a cache line,
+// which padding each element out to a line of its own avoids
+template<typename string_type>
+struct alignas( 64 ) PaddedString {
+    string_type value;
+};
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                flstring_crc32_fingerprint |= calculateCRC32( 0, reinterpret_cast<const void*>( flstring_array[j].data() ), 7 );
+template<typename element_type>
+double benchFalseSharingOperation( fl::bench::harness& harness, const std::string& name, unsigned int thread_count ) {
+    const unsigned int operation_count = 1 << 16;  // a thread
+    std::vector<element_type> elements( thread_count );
+
+    const auto round = [&]( unsigned int t ) {
+        auto& element = elements[t];
+        std::size_t written = 0;
+        for( unsigned int i=0; i<operation_count; ++i ) {
+            if constexpr( requires { element.value; } ) {
+                element.value = seven_character_container_strings[i % key_count];
+                written += element.value.length();
+            } else {
+                element = seven_character_container_strings[i % key_count];
+                written += element.length();
             }
-            auto stop = std::chrono::high_resolution_clock::now();
-            flstring_crc32_generation_times[i] = (stop-start).count() / 1000.0;
+            clobber_memory();
         }
-        double flstring_crc32_generation_time_avg = std::accumulate( flstring_crc32_generation_times.begin(), flstring_crc32_generation_times.end(), 0.0 ) / loop_count;
-        std::cout << std::setprecision( 3 ) << "flstring CRC32 generation time: " << flstring_crc32_generation_time_avg << " ms." << flstring_crc32_fingerprint << std::endl;
-
-        // ---
+        do_not_optimize( written );
+    };
+    ThreadTeam team( thread_count );
+    return harness.run( name, [&]() {
+        team.run( round );
+    }, std::size_t( thread_count ) * operation_count ).median_ns;
+}
 
-        std::array<std::string, key_count> stdstring_array;
-        for( unsigned int i=0; i<key_count; ++i ) {
-            stdstring_array[i] = seven_character_container_strings[i];
-        }
+template<typename string_type>
+void benchFalseSharingOperations( fl::bench::harness& harness, const char* type_name ) {
+    std::cout << "---\nFalse sharing: each thread writing its own element of an array of " << type_name << " ("
+              << sizeof( string_type ) << " bytes each), packed -vs- padded to 64 bytes ("
+              << std::thread::hardware_concurrency() << " hardware threads)\n---" << std::endl;
+    std::ostringstream table;
+    table << std::fixed << std::setprecision( 2 ) << std::setw( 8 ) << "threads" << std::setw( 16 ) << "packed ns/op"
+          << std::setw( 16 ) << "padded ns/op" << std::setw( 16 ) << "packed/padded" << "\n";
+    for( const unsigned int thread_count : scalingThreadCounts() ) {
+        const std::string threads = "false sharing, " + std::to_string( thread_count ) + " thread(s): " + type_name;
+        const double packed_ns = benchFalseSharingOperation<string_type>( harness, threads + " packed", thread_count );
+        const double padded_ns = benchFalseSharingOperation<PaddedString<string_type>>( harness, threads + " padded", thread_count );
+        // (much slower packed than padded, with the same work, can only be the cache lines bouncing)
+        table << std::setw( 8 ) << thread_count << std::setw( 16 ) << packed_ns << std::setw( 16 ) << padded_ns
+              << std::setw( 16 ) << packed_ns / padded_ns << ( ( packed_ns > 1.5 * padded_ns ) ? "  << false sharing" : "" ) << "\n";
+    }
+    std::cout << table.str() << std::flush;
+}
 
-        for( unsigned int i=0; i<loop_count; ++i ) {
-            auto start = std::chrono::high_resolution_clock::now();
-            for( unsigned int j=0; j<key_count; ++j ) {
-                stdstring_crc32_fingerprint |= calculateCRC32( 0, reinterpret_cast<const void*>( stdstring_array[j].data() ), 7 );
-            }
-            auto stop = std::chrono::high_resolution_clock::now();
-            stdstring_crc32_generation_times[i] = (stop-start).count() / 1000.0;
-        }
-        double stdstring_crc32_generation_time_avg = std::accumulate( stdstring_crc32_generation_times.begin(), stdstring_crc32_generation_times.end(), 0.0 ) / loop_count;
-        std::cout << std::setprecision( 3 ) << "stdstring CRC32 generation time: " << stdstring_crc32_generation_time_avg << " ms." << stdstring_crc32_fingerprint << std::endl;
+// Compare two runs' CSV output, rather than running the benchmarks:
+//     flstring_benchmarking --compare baseline.csv current.csv [threshold (default 0.05 = 5%)]
+// exits with 1 if any benchmark's median time regressed by more than the threshold.
+int compareRuns( int argc, char* argv[] ) {
+    if( argc < 4 || argc > 5 ) {
+        std::cerr << "usage: " << argv[0] << " --compare baseline.csv current.csv [threshold]" << std::endl;
+        return 2;
     }
-#endif
-    return;
+    std::ifstream baseline_file( argv[2] );
+    std::ifstream current_file( argv[3] );
+    if( !baseline_file || !current_file ) {
+        std::cerr << "couldn't open " << ( baseline_file ? argv[3] : argv[2] ) << std::endl;
+        return 2;
+    }
+    const double threshold = ( argc == 5 ) ? std::stod( argv[4] ) : 0.05;
+    const auto regressions = fl::bench::compare( fl::bench::read_csv( baseline_file ), fl::bench::read_csv( current_file ), threshold, std::cout );
+    return ( regressions == 0 ) ? 0 : 1;
 }
-#endif
 
+// flstring_benchmarking [--cpu N] [--samples N] [--sample-ms MS] [--warmup-ms MS] [--json FILE] [--csv FILE] [--perf]
 int main( int argc, char* argv[] ) {
+    if( argc > 1 && std::string_view( argv[1] ) == "--compare" ) {
+        return compareRuns( argc, argv );
+    }
+
+    fl::bench::options options;
+    try {
+        options = fl::bench::parse_options( argc, argv );
+    } catch( const std::exception& e ) {
+        std::cerr << e.what() << "\nusage: " << argv[0] << " [--cpu N] [--samples N] [--sample-ms MS] [--warmup-ms MS] [--json FILE] [--csv FILE] [--perf]\n"
+                  << "       " << argv[0] << " --compare baseline.csv current.csv [threshold]" << std::endl;
+        return 2;
+    }
+    options.track_allocations = true;
+    if( options.cpu >= 0 ) {
+        std::cerr << "warning: --cpu pins only the single-threaded benchmarks; the multi-threaded ones (fl::parallel_sort(), "
+                  << "fl::intern_table, fl::sharded_map and the scenarios after them) run their threads on every CPU." << std::endl;
+    }
+    fl::bench::harness harness( options );
+
     benchMemoryFootprint();
-    benchStringOperations();
-    benchOrderedMapOperations();
-    benchUnorderedMapOperations();
-    benchCRC32Operations();
+    benchStringOperations( harness );
+    benchOrderedMapOperations( harness );
+    benchUnorderedMapOperations( harness );
+    benchCRC32Operations( harness );
+    benchVectorOperations( harness );
+    benchRegisterResidentOperations<4>( harness, three_character_container_strings );
+    benchRegisterResidentOperations<8>( harness, seven_character_container_strings );
+    benchRegisterResidentOperations<16>( harness, seven_character_container_strings );
+    benchHashOperations( harness );
+    benchFlatMapOperations( harness );
+    benchHeterogeneousLookups( harness );
+    benchBulkOperations( harness );
+    benchOrderingOperations( harness );
+    benchSortOperations( harness );
+    benchColumnOperations( harness );
+    benchBatchOperations( harness );
+    benchHashBatchOperations( harness );
+    benchStaticMapOperations( harness );
+    benchOrderedContainerOperations( harness );
+    benchInternOperations( harness );
+    benchShardedMapOperations( harness );
+    benchChurnOperations( harness );
+    benchReadMostlyOperations( harness );
+    benchMessageOperations( harness );
+    benchFalseSharingOperations<fl::string<8>>( harness, "fl::string<8>" );
+    benchFalseSharingOperations<std::string>( harness, "std::string" );
+
+    harness.write_files();
     return 0;
 }
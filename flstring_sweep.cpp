@@ -0,0 +1,496 @@
+/*
+===============================================================================
+
+    flstring
+    ===
+    File    :   flstring_sweep.cpp
+    Author  :   Jamie Taylor
+    Desc    :   Sweep fl::string<N> -vs- std::string over the string size
+                (N = 4 ... 256) and the number of elements (128 ... 10M),
+                with uniform and Zipfian look-ups, to show where the
+                fixed-size strings stop winning as the bytes the look-ups
+                touch move out of L1, through L2 and the LLC, to DRAM.
+                - array: reading strings at 'random' positions in a
+                  std::vector<fl::string<N>> -vs- std::vector<std::string>.
+                - hash: look-ups in an fl::flat_map<N> -vs- a
+                  std::unordered_map<std::string>.
+                The keys and look-ups come from a seeded generator, so
+                every run (on any standard library) sees the same ones;
+                the look-up stream is several times longer than both the
+                element count and the LLC, and each timed operation
+                carries on through it from where the last left off.
+                Each timing is an fl::bench harness run; at the end come
+                tables of the speedups (std::string's time over
+                fl::string's), and optionally a CSV of every cell.
+
+===============================================================================
+*/
+#include "flstring.hpp"
+#include "flflat_map.hpp"
+#include "flbench.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#if defined( __GLIBC__ )
+#include <unistd.h>
+#endif
+
+using fl::bench::do_not_optimize;
+
+
+// splitmix64: small, fast, and (unlike rand() and the std::*_distribution classes) gives
+// the same sequence everywhere
+class SplitMix64 {
+public:
+    explicit SplitMix64( std::uint64_t seed ) : m_state( seed ) {}
+
+    std::uint64_t operator()() {
+        std::uint64_t z = ( m_state += 0x9E3779B97F4A7C15ULL );
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+        return z ^ ( z >> 31 );
+    }
+    // in [0, bound)
+    std::uint32_t below( std::uint32_t bound ) {
+        return static_cast<std::uint32_t>( ( ( *this )() >> 32 ) * bound >> 32 );
+    }
+    // in [0, 1)
+    double unit() {
+        return static_cast<double>( ( *this )() >> 11 ) * 0x1.0p-53;
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+// Keys of length N-1 (so std::string only stays in its SSO buffer for the smallest N):
+// 'random' printable characters, ending in the key's index in base 94, which keeps them
+// distinct. 0 if there aren't count distinct keys of that length.
+std::size_t distinctKeyDigits( std::size_t count, std::size_t length ) {
+    std::size_t digits = 1;
+    for( std::size_t capacity = 94; capacity < count; capacity *= 94 ) {
+        ++digits;
+    }
+    return ( digits <= length ) ? digits : 0;
+}
+
+std::vector<std::string> makeKeys( std::size_t count, std::size_t length ) {
+    const std::size_t digits = distinctKeyDigits( count, length );
+    SplitMix64 random( 0x5EED0000 + length );
+    std::vector<std::string> keys( count );
+    for( std::size_t i=0; i<count; ++i ) {
+        std::string& key = keys[i];
+        key.resize( length );
+        for( std::size_t j=0; j<length - digits; ++j ) {
+            key[j] = static_cast<char>( '!' + random.below( 94 ) );
+        }
+        for( std::size_t j=0, index=i; j<digits; ++j, index/=94 ) {
+            key[length - 1 - j] = static_cast<char>( '!' + index % 94 );
+        }
+    }
+    return keys;
+}
+
+// Look-ups: indices into count elements, each equally likely, or Zipfian (theta = 0.99, as
+// YCSB uses) with the ranks scattered over the elements, so that the hot ones aren't
+// all next to each other
+std::vector<std::uint32_t> uniformLookups( std::size_t count, std::size_t lookup_count ) {
+    SplitMix64 random( 0x10C0 + count );
+    std::vector<std::uint32_t> lookups( lookup_count );
+    for( std::uint32_t& lookup : lookups ) {
+        lookup = random.below( static_cast<std::uint32_t>( count ) );
+    }
+    return lookups;
+}
+
+std::vector<std::uint32_t> zipfianLookups( std::size_t count, std::size_t lookup_count ) {
+    // Gray et al., "Quickly Generating Billion-Record Synthetic Databases" (SIGMOD '94)
+    const double theta = 0.99;
+    double zeta_n = 0.0;
+    for( std::size_t i=1; i<=count; ++i ) {
+        zeta_n += 1.0 / std::pow( static_cast<double>( i ), theta );
+    }
+    const double zeta_2 = 1.0 + 1.0 / std::pow( 2.0, theta );
+    const double alpha = 1.0 / ( 1.0 - theta );
+    const double eta = ( 1.0 - std::pow( 2.0 / count, 1.0 - theta ) ) / ( 1.0 - zeta_2 / zeta_n );
+
+    SplitMix64 random( 0x21FF + count );
+    std::vector<std::uint32_t> lookups( lookup_count );
+    for( std::uint32_t& lookup : lookups ) {
+        const double u = random.unit();
+        const double uz = u * zeta_n;
+        std::uint64_t rank;
+        if( uz < 1.0 ) {
+            rank = 0;
+        } else if( uz < zeta_2 ) {
+            rank = 1;
+        } else {
+            rank = std::min<std::uint64_t>( count - 1, static_cast<std::uint64_t>( count * std::pow( eta*u - eta + 1.0, alpha ) ) );
+        }
+        // (a prime larger than any count, so this is a permutation of the ranks)
+        lookup = static_cast<std::uint32_t>( rank * 2654435761ULL % count );
+    }
+    return lookups;
+}
+
+// The cache sizes, to say where a working set fits
+struct CacheSizes {
+    std::size_t l1 = 32 << 10;
+    std::size_t l2 = 1 << 20;
+    std::size_t llc = 32 << 20;
+};
+
+CacheSizes readCacheSizes() {
+    CacheSizes sizes;
+#if defined( __GLIBC__ )
+    const auto read = []( int name, std::size_t& size ) {
+        const long value = sysconf( name );
+        if( value > 0 ) {
+            size = static_cast<std::size_t>( value );
+        }
+    };
+    read( _SC_LEVEL1_DCACHE_SIZE, sizes.l1 );
+    read( _SC_LEVEL2_CACHE_SIZE, sizes.l2 );
+    read( _SC_LEVEL3_CACHE_SIZE, sizes.llc );
+#endif
+    return sizes;
+}
+
+const char* cacheLevel( const CacheSizes& sizes, std::size_t bytes ) {
+    return ( bytes <= sizes.l1 ) ? "L1" : ( bytes <= sizes.l2 ) ? "L2" : ( bytes <= sizes.llc ) ? "LLC" : "DRAM";
+}
+
+std::size_t stringsBytes( const std::vector<std::string>& strings ) {
+    std::size_t bytes = strings.size() * sizeof( std::string );
+    for( const std::string& str : strings ) {
+        bytes += fl::bench::heap_bytes( str );
+    }
+    return bytes;
+}
+
+// One cell of the sweep
+struct Cell {
+    const char*                 scenario;
+    const char*                 distribution;
+    std::size_t                 string_size;
+    std::size_t                 element_count;
+    std::size_t                 fl_bytes;       // the bytes the look-ups touch (elements and probe keys), roughly
+    std::size_t                 std_bytes;
+    double                      fl_ns;          // median time per look-up
+    double                      std_ns;
+};
+
+struct SweepOptions {
+    std::vector<std::size_t>    string_sizes = { 4, 8, 16, 32, 64, 128, 256 };
+    std::size_t                 max_elements = 10000000;
+    std::size_t                 lookup_count = 1024;    // look-ups per timed operation
+    std::size_t                 max_bytes = std::size_t( 1 ) << 30;     // skip cells needing more memory than this
+    std::string                 csv_path;
+};
+
+std::vector<std::size_t> elementCounts( std::size_t max_elements ) {
+    // 128 up by 4x, which puts a few counts in each cache level, and then the maximum
+    std::vector<std::size_t> counts;
+    for( std::size_t count = 128; count < max_elements; count *= 4 ) {
+        counts.push_back( count );
+    }
+    counts.push_back( max_elements );
+    return counts;
+}
+
+// A look-up stream, and which elements it looks up at all. It's at least 4x as long as
+// there are elements, and as there are lines in the LLC, and the timed operations work
+// through it, each carrying on from where the last left off; so the look-ups touch as much
+// of the container as the distribution reaches, rather than the same few over and over.
+struct LookupStream {
+    const char*                 distribution;
+    std::vector<std::uint32_t>  indices;
+    std::vector<bool>           touched;
+};
+
+std::size_t streamLength( std::size_t count, const CacheSizes& caches, std::size_t lookup_count ) {
+    const std::size_t length = std::max( 4 * count, 4 * caches.llc / 64 );
+    return ( length + lookup_count - 1 ) / lookup_count * lookup_count;
+}
+
+LookupStream makeStream( const char* distribution, std::vector<std::uint32_t> indices, std::size_t count ) {
+    LookupStream stream{ distribution, std::move( indices ), std::vector<bool>( count ) };
+    for( const std::uint32_t index : stream.indices ) {
+        stream.touched[index] = true;
+    }
+    return stream;
+}
+
+// the bytes the stream's look-ups touch, given those that looking up element i touches
+template<typename bytes_function>
+std::size_t touchedBytes( const LookupStream& stream, bytes_function bytes ) {
+    std::size_t total = 0;
+    for( std::size_t i=0; i<stream.touched.size(); ++i ) {
+        if( stream.touched[i] ) {
+            total += bytes( i );
+        }
+    }
+    return total;
+}
+
+// Time lookup( index ) over the next lookup_count indices of the stream, a call at a time
+template<typename lookup_function>
+double runLookups( fl::bench::harness& harness, const std::string& name, const LookupStream& stream, std::size_t lookup_count,
+                   lookup_function lookup ) {
+    std::size_t next = 0;
+    return harness.run( name, [&]() {
+        const std::uint32_t* indices = stream.indices.data() + next;
+        std::size_t sum = 0;
+        for( std::size_t i=0; i<lookup_count; ++i ) {
+            sum += lookup( indices[i] );
+        }
+        do_not_optimize( sum );
+        next += lookup_count;
+        if( next == stream.indices.size() ) {
+            next = 0;
+        }
+    }, lookup_count ).median_ns;
+}
+
+template<std::size_t N>
+void sweepCell( fl::bench::harness& harness, const SweepOptions& options, const std::vector<LookupStream>& streams,
+                std::size_t count, std::vector<Cell>& cells ) {
+    using fl_string = fl::string<N>;
+    using map_type = fl::flat_map<N, std::uint32_t>;
+    using key_type = typename map_type::key_type;
+    const std::size_t length = N - 1;
+
+    std::cout << "---\nN = " << N << ", " << count << " elements\n---" << std::endl;
+    if( distinctKeyDigits( count, length ) == 0 ) {
+        std::cout << "(skipped: fewer than " << count << " distinct keys of " << length << " characters)" << std::endl;
+        return;
+    }
+    // At the most: the look-up streams, the std::string keys, the fl::string keys, and the
+    // larger of the two maps (a flat_map is at most ~1/2 full; a node is about a pointer,
+    // the key and its hash)
+    const std::size_t std_string_bytes = sizeof( std::string ) + ( ( length > 15 ) ? length + 1 : 0 );
+    std::size_t peak_bytes = count * ( std_string_bytes + N ) +
+                             count * std::max( 2 * ( sizeof( std::pair<const key_type, std::uint32_t> ) + 1 ),
+                                               3 * sizeof( void* ) + std_string_bytes + sizeof( std::uint32_t ) );
+    for( const LookupStream& stream : streams ) {
+        peak_bytes += stream.indices.size() * sizeof( std::uint32_t ) + count / 8;
+    }
+    if( peak_bytes > options.max_bytes ) {
+        std::cout << "(skipped: needs ~" << ( peak_bytes >> 20 ) << " MiB, over the " << ( options.max_bytes >> 20 ) << " MiB limit)" << std::endl;
+        return;
+    }
+
+    const std::vector<std::string> std_keys = makeKeys( count, length );
+    const std::string cell_name = "/N=" + std::to_string( N ) + "/" + std::to_string( count );
+
+    // Reading strings at the look-up positions (their lengths and last characters, so
+    // a std::string's heap buffer is read as well)
+    {
+        const std::vector<fl_string> fl_strings( std_keys.begin(), std_keys.end() );
+        for( const LookupStream& stream : streams ) {
+            const std::string name = std::string( "array/" ) + stream.distribution + cell_name;
+            const double fl_ns = runLookups( harness, name + " fl::string", stream, options.lookup_count, [&]( std::uint32_t index ) {
+                const fl_string& str = fl_strings[index];
+                return str.length() + static_cast<unsigned char>( str.back() );
+            } );
+            const double std_ns = runLookups( harness, name + " std::string", stream, options.lookup_count, [&]( std::uint32_t index ) {
+                const std::string& str = std_keys[index];
+                return str.length() + static_cast<unsigned char>( str.back() );
+            } );
+            cells.push_back( { "array", stream.distribution, N, count,
+                               touchedBytes( stream, []( std::size_t ) { return sizeof( fl_string ); } ),
+                               touchedBytes( stream, [&]( std::size_t i ) { return sizeof( std::string ) + fl::bench::heap_bytes( std_keys[i] ); } ),
+                               fl_ns, std_ns } );
+        }
+    }
+
+    // Look-ups by key (an existing key object of the map's own key type)
+    {
+        const std::vector<key_type> fl_keys( std_keys.begin(), std_keys.end() );
+        std::vector<double> fl_ns;
+        {
+            map_type map;
+            map.reserve( count );
+            for( std::size_t i=0; i<count; ++i ) {
+                map.try_emplace( fl_keys[i], static_cast<std::uint32_t>( i ) );
+            }
+            for( const LookupStream& stream : streams ) {
+                fl_ns.push_back( runLookups( harness, std::string( "hash/" ) + stream.distribution + cell_name + " fl::flat_map", stream,
+                                             options.lookup_count, [&]( std::uint32_t index ) {
+                    return map.find( fl_keys[index] )->second;
+                } ) );
+            }
+        }
+
+        std::unordered_map<std::string, std::uint32_t> map;
+        map.reserve( count );
+        for( std::size_t i=0; i<count; ++i ) {
+            map.try_emplace( std_keys[i], static_cast<std::uint32_t>( i ) );
+        }
+        for( std::size_t s=0; s<streams.size(); ++s ) {
+            const LookupStream& stream = streams[s];
+            const double std_ns = runLookups( harness, std::string( "hash/" ) + stream.distribution + cell_name + " std::unordered_map", stream,
+                                              options.lookup_count, [&]( std::uint32_t index ) {
+                return map.find( std_keys[index] )->second;
+            } );
+            // a look-up reads the probe key, and the slot and its control byte (fl::flat_map), or
+            // the bucket and the node: the next pointer, the entry and the cached hash (std::unordered_map)
+            cells.push_back( { "hash", stream.distribution, N, count,
+                               touchedBytes( stream, []( std::size_t ) {
+                                   return sizeof( key_type ) + sizeof( typename map_type::value_type ) + 1;
+                               } ),
+                               touchedBytes( stream, [&]( std::size_t i ) {
+                                   return 2 * ( sizeof( std::string ) + fl::bench::heap_bytes( std_keys[i] ) ) +
+                                          2 * sizeof( void* ) + sizeof( std::uint32_t ) + sizeof( std::size_t );
+                               } ),
+                               fl_ns[s], std_ns } );
+        }
+    }
+}
+
+// Speedup tables, one for each scenario and distribution: a row for each element count, a
+// column for each N, and in each cell std::string's time over fl::string's (so above 1, fl::string
+// is faster), and where the bytes their look-ups touch fit (fl::string's/std::string's)
+void printTables( const std::vector<Cell>& cells, const SweepOptions& options, const CacheSizes& caches ) {
+    std::cout << "===\nSpeedup of fl::string over std::string (std time / fl time), and the cache level the bytes each one's look-ups touch fit in\n"
+              << "(L1 " << ( caches.l1 >> 10 ) << " KiB, L2 " << ( caches.l2 >> 10 ) << " KiB, LLC " << ( caches.llc >> 10 ) << " KiB)\n===" << std::endl;
+    const auto counts = elementCounts( options.max_elements );
+    for( const char* scenario : { "array", "hash" } ) {
+        for( const char* distribution : { "uniform", "zipfian" } ) {
+            std::ostringstream table;
+            table << std::fixed << std::setprecision( 2 ) << "\n" << scenario << ", " << distribution << " look-ups\n" << std::setw( 10 ) << "elements";
+            for( const std::size_t n : options.string_sizes ) {
+                table << std::setw( 16 ) << ( "N=" + std::to_string( n ) );
+            }
+            table << "\n";
+            for( const std::size_t count : counts ) {
+                table << std::setw( 10 ) << count;
+                for( const std::size_t n : options.string_sizes ) {
+                    const auto cell = std::find_if( cells.begin(), cells.end(), [&]( const Cell& c ) {
+                        return std::string_view( c.scenario ) == scenario && std::string_view( c.distribution ) == distribution &&
+                               c.string_size == n && c.element_count == count;
+                    } );
+                    if( cell == cells.end() ) {
+                        table << std::setw( 16 ) << "-";
+                        continue;
+                    }
+                    std::ostringstream text;
+                    text << std::fixed << std::setprecision( 2 ) << cell->std_ns / cell->fl_ns << " "
+                         << cacheLevel( caches, cell->fl_bytes ) << "/" << cacheLevel( caches, cell->std_bytes );
+                    table << std::setw( 16 ) << text.str();
+                }
+                table << "\n";
+            }
+            std::cout << table.str() << std::flush;
+        }
+    }
+}
+
+void writeCells( std::ostream& out, const std::vector<Cell>& cells, const CacheSizes& caches ) {
+    out << std::setprecision( 17 ) << "scenario,distribution,N,elements,fl_bytes,std_bytes,fl_level,std_level,fl_ns,std_ns,speedup\n";
+    for( const Cell& cell : cells ) {
+        out << cell.scenario << ',' << cell.distribution << ',' << cell.string_size << ',' << cell.element_count << ','
+            << cell.fl_bytes << ',' << cell.std_bytes << ',' << cacheLevel( caches, cell.fl_bytes ) << ',' << cacheLevel( caches, cell.std_bytes ) << ','
+            << cell.fl_ns << ',' << cell.std_ns << ',' << cell.std_ns / cell.fl_ns << '\n';
+    }
+}
+
+// The sweep's own options are taken out of argv; the rest are left for fl::bench::parse_options()
+SweepOptions parseSweepOptions( int& argc, char* argv[] ) {
+    SweepOptions options;
+    int kept = 1;
+    for( int i=1; i<argc; ++i ) {
+        const std::string_view arg( argv[i] );
+        const bool ours = ( arg == "--n" || arg == "--max-elements" || arg == "--lookups" || arg == "--max-mib" || arg == "--sweep-csv" );
+        if( !ours ) {
+            argv[kept++] = argv[i];
+            continue;
+        }
+        if( i + 1 >= argc ) {
+            throw std::invalid_argument( "missing value for " + std::string( arg ) );
+        }
+        const std::string value( argv[++i] );
+        if( arg == "--n" ) {
+            options.string_sizes.clear();
+            std::istringstream list( value );
+            for( std::string n; std::getline( list, n, ',' ); ) {
+                const std::size_t size = std::stoul( n );
+                if( std::find( SweepOptions().string_sizes.begin(), SweepOptions().string_sizes.end(), size ) == SweepOptions().string_sizes.end() ) {
+                    throw std::invalid_argument( "N must be one of 4, 8, 16, 32, 64, 128 or 256" );
+                }
+                options.string_sizes.push_back( size );
+            }
+        } else if( arg == "--max-elements" ) {
+            options.max_elements = std::stoul( value );
+        } else if( arg == "--lookups" ) {
+            options.lookup_count = std::stoul( value );
+        } else if( arg == "--max-mib" ) {
+            options.max_bytes = std::stoull( value ) << 20;
+        } else {
+            options.csv_path = value;
+        }
+    }
+    if( options.max_elements < 128 || options.max_elements > 0xFFFFFFFF || options.lookup_count == 0 ) {
+        throw std::invalid_argument( "--max-elements must be at least 128 (and fit 32 bits), and --lookups at least 1" );
+    }
+    argc = kept;
+    return options;
+}
+
+// flstring_sweep [--n 4,8,...] [--max-elements N] [--lookups N] [--max-mib MIB] [--sweep-csv FILE]
+//                [any fl::bench option: --cpu N, --samples N, --sample-ms MS, --warmup-ms MS, --json FILE, --csv FILE, --perf]
+int main( int argc, char* argv[] ) {
+    SweepOptions sweep_options;
+    fl::bench::options options;
+    try {
+        sweep_options = parseSweepOptions( argc, argv );
+        options = fl::bench::parse_options( argc, argv );
+    } catch( const std::exception& e ) {
+        std::cerr << e.what() << "\nusage: " << argv[0] << " [--n 4,8,...] [--max-elements N] [--lookups N] [--max-mib MIB] [--sweep-csv FILE]\n"
+                  << "       [--cpu N] [--samples N] [--sample-ms MS] [--warmup-ms MS] [--json FILE] [--csv FILE] [--perf]" << std::endl;
+        return 2;
+    }
+    fl::bench::harness harness( options );
+    const CacheSizes caches = readCacheSizes();
+
+    std::vector<Cell> cells;
+    for( const std::size_t count : elementCounts( sweep_options.max_elements ) ) {
+        const std::size_t stream_length = streamLength( count, caches, sweep_options.lookup_count );
+        std::vector<LookupStream> streams;
+        streams.push_back( makeStream( "uniform", uniformLookups( count, stream_length ), count ) );
+        streams.push_back( makeStream( "zipfian", zipfianLookups( count, stream_length ), count ) );
+
+        for( const std::size_t n : sweep_options.string_sizes ) {
+            switch( n ) {
+            case 4:     sweepCell<4>( harness, sweep_options, streams, count, cells ); break;
+            case 8:     sweepCell<8>( harness, sweep_options, streams, count, cells ); break;
+            case 16:    sweepCell<16>( harness, sweep_options, streams, count, cells ); break;
+            case 32:    sweepCell<32>( harness, sweep_options, streams, count, cells ); break;
+            case 64:    sweepCell<64>( harness, sweep_options, streams, count, cells ); break;
+            case 128:   sweepCell<128>( harness, sweep_options, streams, count, cells ); break;
+            case 256:   sweepCell<256>( harness, sweep_options, streams, count, cells ); break;
+            }
+        }
+    }
+
+    printTables( cells, sweep_options, caches );
+    if( !sweep_options.csv_path.empty() ) {
+        std::ofstream out( sweep_options.csv_path );
+        writeCells( out, cells, caches );
+        if( !out ) {
+            std::cerr << "couldn't write " << sweep_options.csv_path << std::endl;
+            return 1;
+        }
+    }
+    harness.write_files();
+    return 0;
+}